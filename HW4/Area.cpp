@@ -6,12 +6,27 @@ using namespace mtm ;
  */
 
 Area::Area(const std::string& name): area_name(name), reachable_areas(),
-                                     groups(){
+                                     slot_names(), group_slots(),
+                                     group_names(nullptr), slot_stats(),
+                                     groups(), stats(){
+    stats.power = 0;
+    stats.groups = 0;
+    stats.ruler = nullptr;
+    stats.fights = 0;
+    stats.trades = 0;
     if (name.empty()){
         throw AreaInvalidArguments() ;
     }
 }
 
+const std::string& Area::getName() const {
+    return area_name;
+}
+
+void Area::setGroupNames(GroupNames* names) {
+    group_names = names;
+}
+
 void Area::addReachableArea(const std::string& area_name){
     reachable_areas.insert(area_name);
 }
@@ -42,15 +57,39 @@ void Area::groupLeave(const std::string& group_name) {
     if (group_index==-1) {
         throw AreaGroupNotFound();
     }
-    groups.erase(groups.begin()+group_index);
+    removeGroupAt(group_index);
+}
+
+void Area::refreshGroups() {
+    rebuildGroupSlots();
+}
+
+bool Area::appendRanked(const GroupPointer&) {
+    return true;
 }
 
 MtmSet<std::string> Area::getGroupsNames() const {
     MtmSet<std::string> groups_names ;
-    for (unsigned int i = 0; i < groups.size(); ++i) {
-        if (!((*(groups[i])).getName().empty())) { //check if name is not ""
-            groups_names.insert((*(groups[i])).getName());
+    for (unsigned int i = 0; i < slot_names.size(); ++i) {
+        if (!slot_names[i].empty()) { //check if name is not ""
+            groups_names.insert(slot_names[i]);
         }
     }
     return groups_names;
-}
\ No newline at end of file
+}
+
+bool Area::hasGroup(const std::string& group_name) const {
+    return findGroup(group_name) != -1 ;
+}
+
+GroupNamesView Area::getGroupsNamesView() const {
+    return GroupNamesView(slot_names);
+}
+
+const std::vector<GroupPointer>& Area::getGroups() const {
+    return groups;
+}
+
+const AreaStats& Area::getStats() const {
+    return stats;
+}
@@ -5,7 +5,10 @@
 #include <map>
 #include "Clan.h"
 #include "Group.h"
+#include "GroupNames.h"
+#include "Trace.h"
 #include <vector>
+#include <unordered_map>
 #include <memory>
 #include <algorithm>
 
@@ -14,17 +17,180 @@ using std::shared_ptr;
 using std::map;
 
 namespace mtm{
+
+    /**
+     * A non-owning view of the names of the groups in an area.
+     * Iterating it doesn't allocate, but the view is only valid until the
+     * next change to the area it was taken from.
+     */
+    class GroupNamesView{
+        const std::vector<std::string>* names ;
+    public:
+        typedef std::vector<std::string>::const_iterator const_iterator;
+
+        /**
+         * Constructor
+         * @param names The names vector of the area the view looks at.
+         */
+        explicit GroupNamesView(const std::vector<std::string>& names) :
+                names(&names) {}
+
+        /**
+         * @return A const_iterator to the first name in the view.
+         */
+        const_iterator begin() const {
+            return names->begin();
+        }
+
+        /**
+         * @return A const_iterator past the last name in the view.
+         */
+        const_iterator end() const {
+            return names->end();
+        }
+
+        /**
+         * @return The amount of names in the view.
+         */
+        int size() const {
+            return names->size();
+        }
+
+        /**
+         * @return true if there are no names in the view.
+         */
+        bool empty() const {
+            return names->empty();
+        }
+    };
     
+    /**
+     * What a group that arrives to an area can change, besides the area, the
+     * group and the clan of the group: the clans of the groups it can fight
+     * or trade with, and the groups that can lose their names to it (in a
+     * fight or a unite).
+     */
+    struct ArrivalFootprint{
+        std::vector<std::string> clans;
+        std::vector<std::string> names;
+    };
+
+    /**
+     * The live stats of an area, kept as its groups get in and out, fight,
+     * trade and unite, so reading them doesn't look at the groups.
+     *  - population - the amount of people of every clan in the area.
+     *  - power - the sum of the powers of the groups in the area.
+     *  - groups - the amount of groups in the area.
+     *  - ruler - the ruler of a mountain, nullptr if there is none or the
+     *    area isn't a mountain.
+     *  - fights - the amount of fights in the area so far.
+     *  - trades - the amount of trades in the area so far.
+     */
+    struct AreaStats{
+        std::unordered_map<std::string, int> population;
+        long long power;
+        int groups;
+        const Group* ruler;
+        int fights;
+        int trades;
+    };
+
     /**
      * An abstract call of an area in the world.
      * Assume every name is unique.
      * Groups that become empty, should be removed from the area.
      */
     class Area{
+        friend class Checkpoint;
+        friend class UndoLog;
+        friend class MemoryAccounting;
+
         std::string area_name ;
         MtmSet<std::string> reachable_areas ;
+        /**
+         * The name every slot of the groups vector is indexed under, kept
+         * next to the groups so a slot can be unindexed even after its group
+         * was emptied or renamed by a fight or a unite.
+         */
+        std::vector<std::string> slot_names ;
+        std::unordered_map<std::string, int> group_slots ;
+        GroupNames* group_names ;
+        /**
+         * What every slot of the groups vector was counted as in the stats,
+         * so a slot can be uncounted even after its group changed.
+         */
+        struct SlotStats{
+            std::string clan;
+            int people;
+            long long power;
+        };
+        std::vector<SlotStats> slot_stats ;
+
+        /**
+         * A private function that adds the group in the given slot to the
+         * stats, as it is now.
+         * @param
+         * index - the slot of the group in the groups vector.
+         */
+        void countSlot(int index) {
+            const Group& group = *(groups[index]);
+            SlotStats& counted = slot_stats[index];
+            counted.clan = group.getClan();
+            counted.people = group.getSize();
+            counted.power = group.getPower();
+            stats.population[counted.clan] += counted.people;
+            stats.power += counted.power;
+            stats.groups++;
+        }
+
+        /**
+         * A private function that removes the group in the given slot from
+         * the stats, as it was counted.
+         * @param
+         * index - the slot of the group in the groups vector.
+         */
+        void uncountSlot(int index) {
+            const SlotStats& counted = slot_stats[index];
+            std::unordered_map<std::string, int>::iterator it =
+                    stats.population.find(counted.clan);
+            it->second -= counted.people;
+            if (it->second == 0) {
+                stats.population.erase(it);
+            }
+            stats.power -= counted.power;
+            stats.groups--;
+        }
+
+        /**
+         * A private function that helps us index the group in the given
+         * slot by its current name.
+         * @param
+         * index - the slot of the group in the groups vector.
+         */
+        void indexSlot(int index) {
+            slot_names[index] = (*(groups[index])).getName();
+            group_slots[slot_names[index]] = index;
+        }
+
+        /**
+         * A private function that rebuilds the whole name index, used after
+         * the groups vector was reordered.
+         */
+        void rebuildGroupSlots() {
+            group_slots.clear();
+            slot_names.resize(groups.size());
+            slot_stats.resize(groups.size());
+            stats.population.clear();
+            stats.power = 0;
+            stats.groups = 0;
+            for (unsigned int i = 0; i < groups.size(); i++) {
+                indexSlot(i);
+                countSlot(i);
+            }
+        }
     protected:
         std::vector<GroupPointer> groups;
+        AreaStats stats;
 
         /**
          * static bool function to help us with sorting the groups pointer
@@ -44,7 +210,9 @@ namespace mtm{
          * A void function that sorts the groups in the area by strongest first.
          */
         void sortGroupsByStrongest() {
+            MTM_TRACE("Area::sortGroupsByStrongest");
             std::sort(groups.begin(), groups.end(), sortFunction);
+            rebuildGroupSlots();
         }
 
         /**
@@ -57,24 +225,140 @@ namespace mtm{
          * the gorups in the Area ,
          * -1 - otherwize.
          */
-        int findGroup(const std:: string& group_name){
-            for(unsigned int i=0 ; i<groups.size() ; i++){
-                if ((*(groups[i])).getName() == group_name) {
-                    return i ;
-                }
+        int findGroup(const std:: string& group_name) const {
+            std::unordered_map<std::string, int>::const_iterator it =
+                    group_slots.find(group_name);
+            if (it == group_slots.end()) {
+                return -1 ;
+            }
+            return it->second ;
+        }
+
+        /**
+         * A function that adds a group to the end of the groups vector and
+         * indexes it by its name.
+         * @param
+         * group - a pointer to the group that got into the area.
+         */
+        void addGroupToArea(const GroupPointer& group) {
+            groups.push_back(group);
+            slot_names.push_back(std::string());
+            slot_stats.push_back(SlotStats());
+            indexSlot(groups.size() - 1);
+            countSlot(groups.size() - 1);
+            if (group_names != nullptr) {
+                (*group_names).place(group, this);
+            }
+        }
+
+        /**
+         * A function that removes the group in the given slot, by moving the
+         * last group of the vector into its place.
+         * @param
+         * index - the slot of the group we wish to remove.
+         * @return
+         * the removed group.
+         */
+        GroupPointer removeGroupAt(int index) {
+            GroupPointer removed = groups[index];
+            int last = groups.size() - 1;
+            group_slots.erase(slot_names[index]);
+            uncountSlot(index);
+            if (group_names != nullptr) {
+                (*group_names).leave(slot_names[index]);
+            }
+            if (index != last) {
+                groups[index] = groups[last];
+                slot_names[index] = slot_names[last];
+                slot_stats[index] = slot_stats[last];
+                group_slots[slot_names[index]] = index;
+            }
+            groups.pop_back();
+            slot_names.pop_back();
+            slot_stats.pop_back();
+            return removed;
+        }
+
+        /**
+         * A function that counts a group in the stats again, after it was
+         * changed inside the area (by a fight or a trade).
+         * @param
+         * index - the slot of the changed group.
+         */
+        void recountGroup(int index) {
+            uncountSlot(index);
+            countSlot(index);
+        }
+
+        /**
+         * A function that updates the name index and the stats of a group
+         * whose name was changed inside the area (a unite keeps the name of
+         * the stronger group).
+         * @param
+         * index - the slot of the renamed group.
+         */
+        void reindexGroup(int index) {
+            recountGroup(index);
+            std::unordered_map<std::string, int>::iterator it =
+                    group_slots.find(slot_names[index]);
+            if (it != group_slots.end() && it->second == index) {
+                group_slots.erase(it);
+            }
+            if (slot_names[index] != (*(groups[index])).getName()) {
+                releaseName(slot_names[index]);
+            }
+            indexSlot(index);
+            if (group_names != nullptr) {
+                (*group_names).place(groups[index], this);
+            }
+        }
+
+        /**
+         * A function that tells the world that no group uses a name anymore,
+         * because its group was emptied or united into another group.
+         * @param
+         * group_name - the name that was freed.
+         */
+        void releaseName(const std::string& group_name) {
+            if (group_names != nullptr) {
+                (*group_names).release(group_name);
             }
-            return -1 ;
         }
+
+        /**
+         * @return The world-level index of group names the area reports to,
+         * or nullptr if the area isn't in a world.
+         */
+        GroupNames* getGroupNames() const {
+            return group_names ;
+        }
+
         /**
          * A private function that helps us delete any empty groups after a
          * fight or after a unite.
+         * The surviving groups are compacted to the front of the vector in a
+         * single pass, and only their slots are reindexed.
          */
         void deleteEmptyGroups () {
+            unsigned int kept = 0 ;
             for(unsigned int i=0 ; i<groups.size() ; i++){
                 if ((*(groups[i])).getName().empty()) {
-                    groups.erase(groups.begin()+i);
+                    group_slots.erase(slot_names[i]);
+                    uncountSlot(i);
+                    releaseName(slot_names[i]);
+                    continue ;
                 }
+                if (kept != i) {
+                    groups[kept] = groups[i];
+                    slot_names[kept] = slot_names[i];
+                    slot_stats[kept] = slot_stats[i];
+                    group_slots[slot_names[kept]] = kept;
+                }
+                kept++;
             }
+            groups.resize(kept);
+            slot_names.resize(kept);
+            slot_stats.resize(kept);
         }
 
     public:
@@ -100,6 +384,18 @@ namespace mtm{
          */
         virtual ~Area() = default;
         
+        /**
+         * @return The name of the area.
+         */
+        const std::string& getName() const;
+
+        /**
+         * Make the area report the groups that get in and out of it, and the
+         * names that are freed in it, to a world-level name index.
+         * @param names The index to report to.
+         */
+        void setGroupNames(GroupNames* names);
+
         /**
          * Add an area, that can be reachable from this area.
          * Doesn't mean that this area is reachable from the area with the
@@ -142,12 +438,56 @@ namespace mtm{
          *  same name;
          */
         virtual void groupLeave(const std::string& group_name);
+
+        /**
+         * Rebuild whatever the area keeps about its groups, after the groups
+         * were changed from outside of the area (for example, when their
+         * clans united and they changed clan and morale).
+         */
+        virtual void refreshGroups();
+
+        /**
+         * Rank a group that was added to the area without ranking it, after
+         * the groups that were ranked so far. Loading a checkpoint adds the
+         * groups strongest first, so every ranking of the area is built at
+         * its end, without comparing groups.
+         * @param group The group to rank.
+         * @return false if a ranked group that the area compares with this
+         *  one is weaker than it. The area has no rankings, so true.
+         */
+        virtual bool appendRanked(const GroupPointer& group);
         
         /**
          * Get a set of the names of all the groups in the area.
          * @return A set that contains the names of all the groups in the area.
          */
         MtmSet<std::string> getGroupsNames() const;
+
+        /**
+         * Check if a group is in the area, without building the names set.
+         * @param group_name The name of the group to look for.
+         * @return true if a group with the given name is in the area, false
+         *  otherwise.
+         */
+        bool hasGroup(const std::string& group_name) const;
+
+        /**
+         * Get a view of the names of all the groups in the area.
+         * @return A view over the area's own name index, valid until the
+         *  area changes.
+         */
+        GroupNamesView getGroupsNamesView() const;
+
+        /**
+         * @return The groups in the area, in the same order as the names of
+         *  getGroupsNamesView, valid until the area changes.
+         */
+        const std::vector<GroupPointer>& getGroups() const;
+
+        /**
+         * @return The live stats of the area, valid until the area changes.
+         */
+        const AreaStats& getStats() const;
     };
 } //namespace mtm
 
@@ -0,0 +1,685 @@
+#include "Checkpoint.h"
+#include "World.h"
+#include "CommandLog.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace mtm ;
+using std::string ;
+/**
+ * Checkpoint.cpp , all functions are explained in Checkpoint.h .
+ */
+
+static const char MAGIC[] = { 'W', 'C', 'K', 'P' };
+static const int MAGIC_SIZE = sizeof(MAGIC);
+
+/**
+ * The sections of a checkpoint as they are written: the numbers are added
+ * to a buffer, and every name is replaced by its number in the name table.
+ */
+class CheckpointWriter{
+    std::unordered_map<string, unsigned int> ids;
+    std::vector<const string*> names;
+    string body;
+
+public:
+    CheckpointWriter() : ids(), names(), body() {}
+
+    void writeInt(unsigned int value) {
+        char bytes[4];
+        for (int i = 0; i < 4; i++) {
+            bytes[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+        }
+        body.append(bytes, 4);
+    }
+
+    void writeLong(long long value) {
+        unsigned long long bits = static_cast<unsigned long long>(value);
+        writeInt(static_cast<unsigned int>(bits & 0xffffffffu));
+        writeInt(static_cast<unsigned int>(bits >> 32));
+    }
+
+    void writeDouble(double value) {
+        long long bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        writeLong(bits);
+    }
+
+    void writeName(const string& name) {
+        std::pair<std::unordered_map<string, unsigned int>::iterator, bool>
+                added = ids.insert(std::make_pair(name, names.size()));
+        if (added.second) {
+            names.push_back(&(added.first->first));
+        }
+        writeInt(added.first->second);
+    }
+
+    /**
+     * Write the header, the name table and the sections to a stream.
+     */
+    void flush(std::ostream& output) {
+        string sections;
+        sections.swap(body);
+        body.append(MAGIC, MAGIC_SIZE);
+        writeInt(Checkpoint::VERSION);
+        writeInt(names.size());
+        for (unsigned int i = 0; i < names.size(); i++) {
+            writeInt((*(names[i])).size());
+            body += *(names[i]);
+        }
+        output.write(body.data(), body.size());
+        output.write(sections.data(), sections.size());
+    }
+};
+
+namespace mtm{
+
+/**
+ * Reads the numbers of a checkpoint that is mapped into memory.
+ */
+class CheckpointReader{
+    const unsigned char* data;
+    size_t size;
+    size_t offset;
+    std::vector<string> names;
+
+public:
+    CheckpointReader(const void* data, size_t size) :
+            data(static_cast<const unsigned char*>(data)), size(size),
+            offset(0), names() {}
+
+    void need(size_t bytes) {
+        if (size - offset < bytes) {
+            throw CheckpointTruncated();
+        }
+    }
+
+    unsigned int readInt() {
+        need(4);
+        const unsigned char* bytes = data + offset;
+        offset += 4;
+        return static_cast<unsigned int>(bytes[0]) |
+               (static_cast<unsigned int>(bytes[1]) << 8) |
+               (static_cast<unsigned int>(bytes[2]) << 16) |
+               (static_cast<unsigned int>(bytes[3]) << 24);
+    }
+
+    int readSigned() {
+        return static_cast<int>(readInt());
+    }
+
+    long long readLong() {
+        unsigned long long low = readInt();
+        unsigned long long high = readInt();
+        return static_cast<long long>(low | (high << 32));
+    }
+
+    double readDouble() {
+        long long bits = readLong();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    /**
+     * Read a count of items that take at least item_size bytes each, so a
+     * bad count can't make the loader reserve memory the file doesn't have.
+     */
+    unsigned int readCount(size_t item_size) {
+        unsigned int count = readInt();
+        need(count * item_size);
+        return count;
+    }
+
+    void readHeader() {
+        need(MAGIC_SIZE);
+        if (std::memcmp(data, MAGIC, MAGIC_SIZE) != 0) {
+            throw CheckpointBadFormat();
+        }
+        offset = MAGIC_SIZE;
+        if (readInt() != Checkpoint::VERSION) {
+            throw CheckpointBadFormat();
+        }
+        unsigned int count = readCount(4);
+        names.reserve(count);
+        for (unsigned int i = 0; i < count; i++) {
+            unsigned int length = readInt();
+            need(length);
+            names.push_back(string(reinterpret_cast<const char*>(data +
+                                                                 offset),
+                                   length));
+            offset += length;
+        }
+    }
+
+    unsigned int readNameId() {
+        unsigned int id = readInt();
+        if (id >= names.size()) {
+            throw CheckpointBadFormat();
+        }
+        return id;
+    }
+
+    const string& readName() {
+        return names[readNameId()];
+    }
+
+    const string& name(unsigned int id) const {
+        return names[id];
+    }
+
+    int nameCount() const {
+        return names.size();
+    }
+
+    /**
+     * @return A column of count numbers, read in place.
+     */
+    const unsigned char* readColumn(unsigned int count) {
+        need(static_cast<size_t>(count) * 4);
+        const unsigned char* column = data + offset;
+        offset += static_cast<size_t>(count) * 4;
+        return column;
+    }
+
+    static int columnValue(const unsigned char* column, unsigned int index) {
+        const unsigned char* bytes = column + 4 * static_cast<size_t>(index);
+        return static_cast<int>(static_cast<unsigned int>(bytes[0]) |
+                                (static_cast<unsigned int>(bytes[1]) << 8) |
+                                (static_cast<unsigned int>(bytes[2]) << 16) |
+                                (static_cast<unsigned int>(bytes[3]) << 24));
+    }
+
+    bool atEnd() const {
+        return offset == size;
+    }
+};
+} // namespace mtm
+
+/**
+ * A file mapped into memory for as long as the object lives.
+ */
+class MappedFile{
+    int file;
+    void* data;
+    size_t size;
+
+public:
+    explicit MappedFile(const string& path) : file(-1), data(MAP_FAILED),
+                                              size(0) {
+        file = open(path.c_str(), O_RDONLY);
+        struct stat status;
+        if ((file < 0) || (fstat(file, &status) != 0)) {
+            close();
+            throw CheckpointCantOpen();
+        }
+        size = static_cast<size_t>(status.st_size);
+        if (size == 0) {
+            close();
+            throw CheckpointTruncated();
+        }
+        data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (data == MAP_FAILED) {
+            close();
+            throw CheckpointCantOpen();
+        }
+        madvise(data, size, MADV_SEQUENTIAL);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        close();
+    }
+
+    void close() {
+        if (data != MAP_FAILED) {
+            munmap(data, size);
+            data = MAP_FAILED;
+        }
+        if (file >= 0) {
+            ::close(file);
+            file = -1;
+        }
+    }
+
+    const void* getData() const {
+        return data;
+    }
+
+    size_t getSize() const {
+        return size;
+    }
+};
+
+/**
+ * Ranks a loaded group in its area, as the real type of the area.
+ */
+struct RankAppend{
+    const GroupPointer& group;
+    bool& appended;
+    template<typename AreaKind>
+    void operator()(AreaKind& area) const {
+        appended = area.AreaKind::appendRanked(group);
+    }
+};
+
+void Checkpoint::write(const World& world, std::ostream& output) {
+    CheckpointWriter writer;
+    writer.writeLong(world.current_tick);
+    writer.writeLong(world.scheduler_stats.events_processed);
+    writer.writeDouble(world.scheduler_stats.seconds);
+    writer.writeLong(world.scheduler.next_id);
+    writer.writeLong(world.checkpoint_position.generation);
+    writer.writeLong(world.checkpoint_position.offset);
+    writer.writeInt(world.used_clan_names.size());
+    for (std::unordered_set<string>::const_iterator it =
+            world.used_clan_names.begin(); it != world.used_clan_names.end();
+         ++it) {
+        writer.writeName(*it);
+    }
+    writer.writeInt(world.clan_map.size());
+    for (map<string, Clan>::const_iterator it = world.clan_map.begin();
+         it != world.clan_map.end(); ++it) {
+        const Clan& clan = it->second;
+        writer.writeName(it->first);
+        writer.writeInt(clan.friends.size());
+        for (MtmSet<string>::const_iterator name = clan.friends.begin();
+             name != clan.friends.end(); ++name) {
+            writer.writeName(*name);
+        }
+    }
+    int area_count = world.areas_by_id.size();
+    writer.writeInt(area_count);
+    int group_count = 0;
+    for (int id = 0; id < area_count; id++) {
+        const AreaSlot& slot = world.areas_by_id[id]->second;
+        const Area& area = world.getArea(slot);
+        const std::vector<GroupPointer>& groups = area.getGroups();
+        int ruler = -1;
+        int ruler_changes = 0;
+        if (slot.type == MOUNTAIN) {
+            const Mountain& mountain = world.mountains[slot.index];
+            for (unsigned int i = 0; i < groups.size(); i++) {
+                if (groups[i] == mountain.ruler) {
+                    ruler = i;
+                }
+            }
+            ruler_changes = mountain.ruler_changes;
+        }
+        writer.writeName(area.getName());
+        writer.writeInt(slot.type);
+        writer.writeInt(groups.size());
+        writer.writeInt(ruler);
+        writer.writeInt(ruler_changes);
+        writer.writeInt(area.getStats().fights);
+        writer.writeInt(area.getStats().trades);
+        group_count += groups.size();
+    }
+    for (int id = 0; id < area_count; id++) {
+        const std::vector<int>& roads =
+                world.reachability.getRoadsInto(id);
+        writer.writeInt(roads.size());
+        for (unsigned int i = 0; i < roads.size(); i++) {
+            writer.writeInt(roads[i]);
+        }
+    }
+    //the groups, column after column.
+    writer.writeInt(group_count);
+    for (int column = 0; column < 7; column++) {
+        for (int id = 0; id < area_count; id++) {
+            const std::vector<GroupPointer>& groups =
+                    world.getArea(world.areas_by_id[id]->second).getGroups();
+            for (unsigned int i = 0; i < groups.size(); i++) {
+                const Group& group = *(groups[i]);
+                switch (column) {
+                    case 0 : writer.writeName(group.getName()); break ;
+                    case 1 : writer.writeName(group.getClan()); break ;
+                    case 2 : writer.writeInt(group.getChildren()); break ;
+                    case 3 : writer.writeInt(group.getAdults()); break ;
+                    case 4 : writer.writeInt(group.getTools()); break ;
+                    case 5 : writer.writeInt(group.getFood()); break ;
+                    default : writer.writeInt(group.getMorale()); break ;
+                }
+            }
+        }
+    }
+    //the order of the groups from the strongest, by the same comparison as
+    //the rankings, in every area and then in the whole world, so loading
+    //appends every group at the end of the rankings of its area and clan.
+    struct RankKey{
+        long long power;
+        const string* name;
+        int index;
+    };
+    struct StrongerFirst{
+        bool operator()(const RankKey& first, const RankKey& second) const {
+            if (first.power != second.power) {
+                return first.power > second.power;
+            }
+            return *(first.name) > *(second.name);
+        }
+    };
+    std::vector<RankKey> order;
+    std::vector<RankKey> world_order;
+    world_order.reserve(group_count);
+    for (int id = 0; id < area_count; id++) {
+        const std::vector<GroupPointer>& groups =
+                world.getArea(world.areas_by_id[id]->second).getGroups();
+        order.clear();
+        for (unsigned int i = 0; i < groups.size(); i++) {
+            RankKey key = { (*(groups[i])).getPower(),
+                            &((*(groups[i])).getName()), (int)i };
+            order.push_back(key);
+            key.index = world_order.size();
+            world_order.push_back(key);
+        }
+        std::sort(order.begin(), order.end(), StrongerFirst());
+        for (unsigned int i = 0; i < order.size(); i++) {
+            writer.writeInt(order[i].index);
+        }
+    }
+    std::sort(world_order.begin(), world_order.end(), StrongerFirst());
+    for (unsigned int i = 0; i < world_order.size(); i++) {
+        writer.writeInt(world_order[i].index);
+    }
+    const GroupNames& group_names = world.group_names;
+    writer.writeInt(group_names.families.size());
+    for (std::unordered_map<string, GroupNames::SuffixFamily>::const_iterator
+                 it = group_names.families.begin();
+         it != group_names.families.end(); ++it) {
+        writer.writeName(it->first);
+        writer.writeInt(it->second.next);
+        writer.writeInt(it->second.freed.size());
+        for (std::set<int>::const_iterator freed = it->second.freed.begin();
+             freed != it->second.freed.end(); ++freed) {
+            writer.writeInt(*freed);
+        }
+    }
+    EventScheduler scheduler = world.scheduler;
+    writer.writeInt(scheduler.size());
+    while (scheduler.size() > 0) {
+        ScheduledEvent event = scheduler.takeNext();
+        Command command = Command::fromOperation(event.operation);
+        writer.writeLong(event.tick);
+        writer.writeLong(event.id);
+        writer.writeInt(command.type);
+        writer.writeName(command.first);
+        writer.writeName(command.second);
+        writer.writeName(command.third);
+        writer.writeInt(command.children);
+        writer.writeInt(command.adults);
+        writer.writeInt(command.area_type);
+    }
+    writer.flush(output);
+}
+
+void Checkpoint::save(const World& world, const string& path) {
+    //the old checkpoint stays whole until the new one is synced.
+    string written = path + ".tmp";
+    std::ofstream output(written.c_str(), std::ios::binary | std::ios::trunc);
+    if (!output) {
+        throw CheckpointCantOpen();
+    }
+    write(world, output);
+    output.close();
+    int file = open(written.c_str(), O_RDONLY);
+    bool synced = (file >= 0) && (fsync(file) == 0);
+    if (file >= 0) {
+        close(file);
+    }
+    if (!output || !synced || (rename(written.c_str(), path.c_str()) != 0)) {
+        unlink(written.c_str());
+        throw CheckpointCantOpen();
+    }
+}
+
+void Checkpoint::load(World& world, const string& path) {
+    MappedFile file(path);
+    read(world, file.getData(), file.getSize());
+}
+
+void Checkpoint::read(World& world, const void* data, size_t size) {
+    CheckpointReader reader(data, size);
+    reader.readHeader();
+    try {
+        loadSections(world, reader);
+    } catch (const GroupException&) {
+        throw CheckpointBadFormat();
+    } catch (const ClanException&) {
+        throw CheckpointBadFormat();
+    } catch (const AreaException&) {
+        throw CheckpointBadFormat();
+    }
+    if (!reader.atEnd()) {
+        throw CheckpointBadFormat();
+    }
+}
+
+void Checkpoint::loadSections(World& world, CheckpointReader& reader) {
+    world.current_tick = reader.readLong();
+    world.scheduler_stats.events_processed = reader.readLong();
+    world.scheduler_stats.seconds = reader.readDouble();
+    long long next_id = reader.readLong();
+    world.checkpoint_position.generation = reader.readLong();
+    world.checkpoint_position.offset = reader.readLong();
+    unsigned int used_count = reader.readCount(4);
+    for (unsigned int i = 0; i < used_count; i++) {
+        world.used_clan_names.insert(reader.readName());
+    }
+    std::vector<Clan*> clans(reader.nameCount(), nullptr);
+    unsigned int clan_count = reader.readCount(8);
+    for (unsigned int i = 0; i < clan_count; i++) {
+        unsigned int id = reader.readNameId();
+        const string& name = reader.name(id);
+        if ((clans[id] != nullptr) ||
+                (world.used_clan_names.count(name) == 0)) {
+            throw CheckpointBadFormat();
+        }
+        Clan& clan = world.clan_map.insert(
+                std::pair<string, Clan>(name, Clan(name))).first->second;
+        clan.rankIn(&world.clan_leaders);
+        clans[id] = &clan;
+        world.dirty_clans.insert(name);
+        unsigned int friend_count = reader.readCount(4);
+        for (unsigned int j = 0; j < friend_count; j++) {
+            const string& friend_name = reader.readName();
+            clan.friends.insert(friend_name);
+            clan.friends_index.insert(friend_name);
+        }
+    }
+    unsigned int area_count = reader.readCount(28);
+    std::vector<int> group_counts;
+    std::vector<int> rulers;
+    std::vector<int> ruler_changes;
+    std::vector<int> fights;
+    std::vector<int> trades;
+    for (unsigned int id = 0; id < area_count; id++) {
+        const string& name = reader.readName();
+        unsigned int type = reader.readInt();
+        if ((type > RIVER) ||
+                (world.applyAddArea(name, static_cast<AreaType>(type)) !=
+                 WORLD_SUCCESS)) {
+            throw CheckpointBadFormat();
+        }
+        group_counts.push_back(reader.readSigned());
+        rulers.push_back(reader.readSigned());
+        ruler_changes.push_back(reader.readSigned());
+        fights.push_back(reader.readSigned());
+        trades.push_back(reader.readSigned());
+        if ((group_counts.back() < 0) || (rulers.back() < -1) ||
+                (fights.back() < 0) || (trades.back() < 0) ||
+                (rulers.back() >= group_counts.back()) ||
+                ((type != MOUNTAIN) && (rulers.back() != -1))) {
+            throw CheckpointBadFormat();
+        }
+    }
+    std::vector<std::vector<int> > roads_into(area_count);
+    for (unsigned int to = 0; to < area_count; to++) {
+        unsigned int road_count = reader.readCount(4);
+        for (unsigned int i = 0; i < road_count; i++) {
+            unsigned int from = reader.readInt();
+            if (from >= area_count) {
+                throw CheckpointBadFormat();
+            }
+            world.getArea(world.areas_by_id[from]->second).addReachableArea(
+                    world.areas_by_id[to]->first);
+            roads_into[to].push_back(from);
+        }
+    }
+    world.reachability.addRoads(roads_into);
+    unsigned int group_count = reader.readCount(36);
+    const unsigned char* columns[7];
+    for (int column = 0; column < 7; column++) {
+        columns[column] = reader.readColumn(group_count);
+    }
+    const unsigned char* rank_order = reader.readColumn(group_count);
+    const unsigned char* clan_order = reader.readColumn(group_count);
+    //every clan gets room for its groups before they are added.
+    std::vector<int> clan_sizes(reader.nameCount(), 0);
+    for (unsigned int group = 0; group < group_count; group++) {
+        int id = CheckpointReader::columnValue(columns[1], group);
+        if ((id < 0) || (id >= reader.nameCount()) ||
+                (clans[id] == nullptr)) {
+            throw CheckpointBadFormat();
+        }
+        clan_sizes[id]++;
+    }
+    for (int id = 0; id < reader.nameCount(); id++) {
+        if (clan_sizes[id] > 0) {
+            (*clans[id]).groups.reserve(clan_sizes[id]);
+            (*clans[id]).slot_names.reserve(clan_sizes[id]);
+            (*clans[id]).members.reserve(clan_sizes[id]);
+            (*clans[id]).ranking.reserve(clan_sizes[id]);
+        }
+    }
+    world.group_names.entries.reserve(group_count);
+    std::vector<bool> ranked;
+    std::vector<GroupPointer> loaded;
+    loaded.reserve(group_count);
+    unsigned int group = 0;
+    for (unsigned int id = 0; id < area_count; id++) {
+        const AreaSlot& slot = world.areas_by_id[id]->second;
+        Area& area = world.getArea(slot);
+        area.groups.reserve(group_counts[id]);
+        area.slot_names.reserve(group_counts[id]);
+        area.slot_stats.reserve(group_counts[id]);
+        area.group_slots.reserve(group_counts[id]);
+        for (int i = 0; i < group_counts[id]; i++, group++) {
+            if (group >= group_count) {
+                throw CheckpointBadFormat();
+            }
+            int values[7];
+            for (int column = 0; column < 7; column++) {
+                values[column] = CheckpointReader::columnValue(
+                        columns[column], group);
+            }
+            if ((values[0] < 0) || (values[0] >= reader.nameCount())) {
+                throw CheckpointBadFormat();
+            }
+            //the clans were checked above, and a name that is used twice is
+            //found by the size of the name index below.
+            GroupPointer new_group(new Group(reader.name(values[0]),
+                                             reader.name(values[1]),
+                                             values[2], values[3], values[4],
+                                             values[5], values[6]));
+            if ((*new_group).getSize() == 0) {
+                throw CheckpointBadFormat();
+            }
+            (*clans[values[1]]).placeGroup(new_group);
+            area.addGroupToArea(new_group);
+            loaded.push_back(new_group);
+        }
+        //the groups of the area come strongest first, so every ranking of
+        //the area is built by adding at its end. A group that is out of
+        //order isn't appended, and every group has to come once.
+        ranked.assign(group_counts[id], false);
+        unsigned int first = group - group_counts[id];
+        for (int i = 0; i < group_counts[id]; i++) {
+            int index = CheckpointReader::columnValue(rank_order, first + i);
+            if ((index < 0) || (index >= group_counts[id]) || ranked[index]) {
+                throw CheckpointBadFormat();
+            }
+            ranked[index] = true;
+            bool appended = false;
+            RankAppend append = { area.getGroups()[index], appended };
+            world.visitArea(slot, append);
+            if (!appended) {
+                throw CheckpointBadFormat();
+            }
+        }
+        if (slot.type == MOUNTAIN) {
+            Mountain& mountain = world.mountains[slot.index];
+            if (rulers[id] != -1) {
+                mountain.ruler = area.getGroups()[rulers[id]];
+            }
+            mountain.ruler_changes = ruler_changes[id];
+            area.stats.ruler = mountain.ruler.get();
+        }
+        area.stats.fights = fights[id];
+        area.stats.trades = trades[id];
+    }
+    if ((group != group_count) ||
+            (world.group_names.entries.size() != group_count)) {
+        throw CheckpointBadFormat();
+    }
+    //all the groups come strongest first too, for the rankings of the
+    //clans. A group that is out of order, or comes twice, isn't appended,
+    //so every group came once.
+    for (unsigned int rank = 0; rank < group_count; rank++) {
+        int index = CheckpointReader::columnValue(clan_order, rank);
+        if ((index < 0) || (index >= (int)group_count)) {
+            throw CheckpointBadFormat();
+        }
+        int clan = CheckpointReader::columnValue(columns[1], index);
+        if (!(*clans[clan]).ranking.append(loaded[index])) {
+            throw CheckpointBadFormat();
+        }
+    }
+    for (int id = 0; id < reader.nameCount(); id++) {
+        if (clan_sizes[id] > 0) {
+            world.clan_leaders.update((*clans[id]).ranking);
+        }
+    }
+    unsigned int family_count = reader.readCount(12);
+    for (unsigned int i = 0; i < family_count; i++) {
+        GroupNames::SuffixFamily& family =
+                world.group_names.families[reader.readName()];
+        family.next = reader.readSigned();
+        unsigned int freed_count = reader.readCount(4);
+        for (unsigned int j = 0; j < freed_count; j++) {
+            family.freed.insert(reader.readSigned());
+        }
+    }
+    unsigned int event_count = reader.readCount(40);
+    for (unsigned int i = 0; i < event_count; i++) {
+        long long tick = reader.readLong();
+        long long id = reader.readLong();
+        Command command;
+        unsigned int type = reader.readInt();
+        command.first = reader.readName();
+        command.second = reader.readName();
+        command.third = reader.readName();
+        command.children = reader.readSigned();
+        command.adults = reader.readSigned();
+        unsigned int area_type = reader.readInt();
+        if ((type >= COMMAND_TYPES) || (area_type > RIVER)) {
+            throw CheckpointBadFormat();
+        }
+        command.type = static_cast<CommandType>(type);
+        command.area_type = static_cast<AreaType>(area_type);
+        if (!command.isOperation()) {
+            throw CheckpointBadFormat();
+        }
+        ScheduledEvent event = { tick, id, command.toOperation() };
+        world.scheduler.events.push(event);
+    }
+    world.scheduler.next_id = next_id;
+}
@@ -0,0 +1,79 @@
+#ifndef MTM4_CHECKPOINT_H
+#define MTM4_CHECKPOINT_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+namespace mtm{
+
+    class World;
+    class CheckpointReader;
+
+    /**
+     * Saves a world to a binary file and loads it back, without applying
+     * any of the operations that built it.
+     *
+     * The file is little endian. It has a header ("WCKP" and a version), a
+     * table of every name the world uses, and then sections that refer to
+     * the names by their number in the table:
+     *  - the tick, the scheduler totals, the next event id and the place
+     *    in the journal the checkpoint got to (Journal.h).
+     *  - every clan name that was ever used.
+     *  - the clans, with their friends.
+     *  - the areas by id: name, type, number of groups, ruler, ruler
+     *    changes, fights and trades.
+     *  - the roads into every area, in the order they were added.
+     *  - the groups as columns (names, clans, children, adults, tools, food,
+     *    morale), area after area, in the order of the groups in the area,
+     *    a column of the groups of every area from the strongest, and a
+     *    column of all the groups from the strongest, so loading builds the
+     *    rankings of the areas and the clans without comparing groups.
+     *  - the split name families of the name index.
+     *  - the scheduled events.
+     * Loading maps the file into memory and reads the columns in place.
+     */
+    class Checkpoint{
+        /**
+         * A private function that builds the world from the sections of a
+         * checkpoint, after its header and name table. Every section is
+         * checked against the world it builds, so a file that contradicts
+         * itself is reported instead of building a broken world.
+         */
+        static void loadSections(World& world, CheckpointReader& reader);
+
+    public:
+        static const unsigned int VERSION = 4;
+
+        /**
+         * Write a world to a stream.
+         */
+        static void write(const World& world, std::ostream& output);
+
+        /**
+         * Read a world from a checkpoint in memory, into a world that was
+         * just created.
+         * @throws CheckpointBadFormat If it isn't a checkpoint of this
+         *  version, or it contradicts itself.
+         * @throws CheckpointTruncated If the checkpoint ends in the middle.
+         */
+        static void read(World& world, const void* data, std::size_t size);
+
+        /**
+         * Write a world to a file.
+         * @throws CheckpointCantOpen If the file can't be written.
+         */
+        static void save(const World& world, const std::string& path);
+
+        /**
+         * Read a world from a file, like read.
+         * @throws CheckpointCantOpen If the file can't be read.
+         * @throws CheckpointBadFormat If it isn't a checkpoint of this
+         *  version, or it contradicts itself.
+         * @throws CheckpointTruncated If the file ends in the middle.
+         */
+        static void load(World& world, const std::string& path);
+    };
+} // namespace mtm
+
+#endif //MTM4_CHECKPOINT_H
@@ -1,15 +1,44 @@
 #include "Clan.h"
-#include <list>
+#include "Trace.h"
+#include <algorithm>
 using namespace mtm ;
 using  std::ostream ;
-using std::endl;
 
-Clan::Clan(const std::string& name) : clan_name(name),groups(),friends(){
+Clan::Clan(const std::string& name) : clan_name(name), groups(),
+                                      slot_names(), members(),
+                                      population(0), friends(),
+                                      friends_index(), ranking(),
+                                      leaders(nullptr),
+                                      recording(false), saved_size(0),
+                                      saved_population(0), saved_slots(),
+                                      saved_members() {
     if (name.empty()){
         throw ClanEmptyName();
     }
 }
 
+Clan::Clan(const Clan& other) : clan_name(other.clan_name),
+                                groups(other.groups),
+                                slot_names(other.slot_names),
+                                members(other.members),
+                                population(other.population),
+                                friends(other.friends),
+                                friends_index(other.friends_index),
+                                ranking(other.ranking),
+                                leaders(nullptr),
+                                recording(other.recording),
+                                saved_size(other.saved_size),
+                                saved_population(other.saved_population),
+                                saved_slots(other.saved_slots),
+                                saved_members(other.saved_members) {}
+
+Clan::~Clan() {
+    if (leaders != nullptr) {
+        std::unique_lock<std::mutex> guard = lockLeaders();
+        (*leaders).erase(ranking);
+    }
+}
+
 void Clan::addGroup(const Group& group){
     if (doesContain(group.getName())) {
         throw ClanGroupNameAlreadyTaken() ;
@@ -17,42 +46,85 @@ void Clan::addGroup(const Group& group){
     if (group.getSize()==0) {
         throw ClanGroupIsEmpty();
     }
-    Group new_group(group);
-    new_group.changeClan(clan_name);
-    GroupPointer new_group_ptr(new Group(new_group)) ;
-    groups.insert(new_group_ptr);
+    GroupPointer new_group_ptr(new Group(group)) ;
+    (*new_group_ptr).changeClan(clan_name);
+    insertGroup(new_group_ptr);
 }
 
 const GroupPointer& Clan::getGroup(const std::string& group_name) const {
-    MtmSet<GroupPointer>::const_iterator c_it = groups.begin();
-    for (int i = 0; i < groups.size(); ++i) {
-        if ((*(*c_it)).getName() == group_name) {
-            return *c_it ;
-        }
-        c_it++;
+    std::unordered_map<std::string, Member>::const_iterator it =
+            members.find(group_name);
+    if (it == members.end()) {
+        throw ClanGroupNotFound();
     }
-    throw ClanGroupNotFound();
+    return groups[(it->second).slot];
 }
 
 bool Clan::doesContain(const std::string& group_name) const{
-    MtmSet<GroupPointer>::const_iterator c_it = groups.begin();
-    for (int i = 0; i < groups.size(); ++i) {
-        if ((*(*c_it)).getName() == group_name) {
-            return true ;
-        }
-        c_it++;
-    }
-    return false;
+    return members.find(group_name) != members.end();
 }
 
 int Clan::getSize() const {
-    int clan_size = 0 ;
-    MtmSet<GroupPointer>::const_iterator c_it = groups.begin();
-    for (int i = 0; i < groups.size(); ++i) {
-        clan_size+=(*(*c_it)).getSize() ;
-        c_it++;
+    return population;
+}
+
+void Clan::refreshGroup(const std::string& group_name) {
+    std::unordered_map<std::string, Member>::iterator it =
+            members.find(group_name);
+    if (it == members.end()) {
+        return ;
+    }
+    const Group& group = *(groups[(it->second).slot]);
+    if (group.getSize() == 0) {
+        removeGroup(it);
+        return ;
+    }
+    saveSlot((it->second).slot);
+    saveMember(group_name);
+    saveMember(group.getName());
+    population += group.getSize() - (it->second).size;
+    (it->second).size = group.getSize();
+    rankGroup(groups[(it->second).slot]);
+    if (group.getName() != group_name) {
+        Member member = it->second;
+        members.erase(it);
+        members[group.getName()] = member;
+        slot_names[member.slot] = group.getName();
     }
-    return clan_size;
+}
+
+void Clan::rankIn(ClanLeaders* leaders) {
+    if (this->leaders != nullptr) {
+        std::unique_lock<std::mutex> guard = lockLeaders();
+        (*(this->leaders)).erase(ranking);
+    }
+    this->leaders = leaders;
+    std::unique_lock<std::mutex> guard = lockLeaders();
+    for (unsigned int i = 0; i < groups.size(); ++i) {
+        ranking.insert(groups[i]);
+    }
+    if (leaders != nullptr) {
+        (*leaders).update(ranking);
+    }
+}
+
+void Clan::rerankGroup(const GroupPointer& group) {
+    std::unique_lock<std::mutex> guard = lockLeaders();
+    if (ranking.contains(group)) {
+        rankLocked(group);
+    }
+}
+
+const GroupRanking& Clan::getRanking() const {
+    return ranking;
+}
+
+Clan::const_iterator Clan::begin() const {
+    return groups.begin();
+}
+
+Clan::const_iterator Clan::end() const {
+    return groups.end();
 }
 
 Clan& Clan::unite(Clan& other, const std::string& new_name){
@@ -64,9 +136,26 @@ Clan& Clan::unite(Clan& other, const std::string& new_name){
     }
     clan_name=new_name;
     changeAllGroupsClan(new_name);
+    for (unsigned int i = 0; i < groups.size(); ++i) {
+        rankGroup(groups[i]);
+    }
+    //the other clan is taken out of the leaders before its groups are
+    //ranked in this clan, so its strongest group isn't the leader of two
+    //clans at once.
+    if (other.leaders != nullptr) {
+        std::unique_lock<std::mutex> guard = other.lockLeaders();
+        (*(other.leaders)).erase(other.ranking);
+    }
     addGroupsFromClan(other);
+    //the groups of the other clan are ranked in this clan now.
+    other.ranking.clear();
     other.groups.clear();
+    other.slot_names.clear();
+    other.members.clear();
+    other.population = 0;
     friends.unite(other.friends);
+    friends_index.insert(other.friends_index.begin(),
+                         other.friends_index.end());
     return (*this);
 }
 
@@ -75,32 +164,56 @@ void Clan::makeFriend(Clan& other){
         return ;
     }
     friends.insert(other.clan_name);
+    friends_index.insert(other.clan_name);
     other.friends.insert(clan_name);
+    other.friends_index.insert(clan_name);
 }
 
 bool Clan::isFriend(const Clan& other) const{
     if (this==&other){
         return true;
     }
-    return friends.contains(other.clan_name) ;
+    return friends_index.count(other.clan_name) != 0 ;
 }
 
 std::ostream& mtm::operator<<(std::ostream& os, const Clan& clan){
-    int size = clan.groups.size();
-    os << "Clan's name: " << clan.clan_name << endl ;
-    os << "Clan's groups:"<< endl ;
-    MtmSet<GroupPointer>::const_iterator c_it = clan.groups.begin();
-    std::list<Group> groupList ;
-    for (int i = 0; i < size; ++i) {
-        groupList.push_back(*(*c_it));
-        c_it++;
-    }
-    groupList.sort() ;
-    for(int i=0 ; i<size ; ++i) {
-        if (groupList.back().getSize()!=0) {
-            os << groupList.back().getName() << endl;
+    char buffer[OutputBuffer::STACK_SIZE];
+    OutputBuffer output(os, buffer, sizeof(buffer));
+    output.append("Clan's name: ");
+    output.append(clan.clan_name);
+    output.append("\nClan's groups:\n");
+    //sorting the powers and names of the groups, computed once, instead of
+    //copies of the groups. The stable sort keeps the order equal groups
+    //had, the same as sorting a list of copies.
+    struct SortKey{
+        long long power;
+        const std::string* name;
+    };
+    std::vector<SortKey> sorted ;
+    sorted.reserve(clan.groups.size());
+    for (unsigned int i = 0; i < clan.groups.size(); ++i) {
+        const Group& group = *(clan.groups[i]);
+        if (group.getSize() != 0) {
+            SortKey key = { group.getPower(), &group.getName() };
+            sorted.push_back(key);
         }
-        groupList.pop_back();
     }
+    {
+        MTM_TRACE("Clan::sortGroups");
+        //the same comparison as Group::operator< .
+        std::stable_sort(sorted.begin(), sorted.end(),
+                         [](const SortKey& first, const SortKey& second) {
+                             long long res = first.power - second.power;
+                             if (res != 0) {
+                                 return res < 0;
+                             }
+                             return *(first.name) < *(second.name);
+                         });
+    }
+    for (int i = sorted.size() - 1; i >= 0; --i) {
+        output.append(*(sorted[i].name));
+        output.append('\n');
+    }
+    output.flush();
     return os;
 }
\ No newline at end of file
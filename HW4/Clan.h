@@ -3,14 +3,19 @@
 
 #include <string>
 #include "Group.h"
+#include "GroupRanking.h"
 #include "MtmSet.h"
 #include "exceptions.h"
 #include <ostream>
 #include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace mtm{
 
-    typedef std::shared_ptr<Group> GroupPointer;
     /**
      * A clan of multiple groups. Groups can join a clan, and clans can be
      * friends to other clans.
@@ -18,22 +23,278 @@ namespace mtm{
      * lost all of its people, will be removed from the clan.
      */
     class Clan{
+        friend class Checkpoint;
+        friend class UndoLog;
+        friend class MemoryAccounting;
+        friend class StateExport;
+
+        /**
+         * Where a group is in the groups vector, and how many people it had
+         * the last time the clan looked at it.
+         */
+        struct Member{
+            int slot;
+            int size;
+        };
         std::string clan_name;
-        MtmSet<GroupPointer> groups;
+        std::vector<GroupPointer> groups;
+        /**
+         * The name every group is indexed by in members, slot by slot. A
+         * group can take the name of the group it united with before the
+         * clan is refreshed, so its own name can't be used to find its entry.
+         */
+        std::vector<std::string> slot_names;
+        std::unordered_map<std::string, Member> members;
+        int population;
         MtmSet<std::string> friends;
+        /**
+         * The same names as friends, hashed, so isFriend doesn't scan the
+         * friends set.
+         */
+        std::unordered_set<std::string> friends_index;
+        /**
+         * The groups of the clan from the strongest to the weakest, and the
+         * leaders of the world the clan is ordered in by its strongest group
+         * (nullptr if there are none). A group is ranked again whenever the
+         * clan is told it changed, so the ranking stays in order without
+         * sorting.
+         */
+        GroupRanking ranking;
+        ClanLeaders* leaders;
+
+        /**
+         * What the groups of the clan were before their first change since
+         * undo recording started (beginUndo): the slots, the index entries
+         * (if they were there), the number of groups and the population.
+         */
+        struct SavedMember{
+            bool present;
+            Member member;
+        };
+        bool recording;
+        int saved_size;
+        int saved_population;
+        std::unordered_map<int, std::pair<GroupPointer, std::string> >
+                saved_slots;
+        std::unordered_map<std::string, SavedMember> saved_members;
+
+        /**
+         * A private function that remembers what a slot was, before its
+         * first change since undo recording started. Slots that were added
+         * since then are not remembered, undo cuts them.
+         */
+        void saveSlot(int slot) {
+            if (!recording || (slot >= saved_size) ||
+                    (saved_slots.count(slot) != 0)) {
+                return ;
+            }
+            saved_slots[slot] = std::make_pair(groups[slot], slot_names[slot]);
+        }
+
+        /**
+         * A private function that checks if a group is the strongest group
+         * of the clan, by its rank.
+         */
+        bool isLeader(const GroupPointer& group) const {
+            return !ranking.empty() && ((*(ranking.begin())).get() ==
+                                        group.get());
+        }
+
+        /**
+         * A private function that locks the leaders of the world, before the
+         * ranking changes (ClanLeaders::lock).
+         * @return
+         * the lock , that doesn't lock anything if there are no leaders.
+         */
+        std::unique_lock<std::mutex> lockLeaders() {
+            if (leaders == nullptr) {
+                return std::unique_lock<std::mutex>();
+            }
+            return (*leaders).lock();
+        }
+
+        /**
+         * A private function that ranks a group (again) by its current power
+         * and name, with the leaders locked. If the group is or was the
+         * strongest group of the clan, the clan is ordered again in the
+         * leaders of the world.
+         */
+        void rankLocked(const GroupPointer& group) {
+            bool was_leader = isLeader(group);
+            ranking.insert(group);
+            if ((leaders != nullptr) && (was_leader || isLeader(group))) {
+                (*leaders).update(ranking);
+            }
+        }
+
+        /**
+         * A private function that ranks a group (again), see rankLocked.
+         */
+        void rankGroup(const GroupPointer& group) {
+            std::unique_lock<std::mutex> guard = lockLeaders();
+            rankLocked(group);
+        }
+
+        /**
+         * A private function that removes a group from the ranking, and
+         * orders the clan again in the leaders of the world if it was the
+         * strongest group of the clan.
+         */
+        void unrankGroup(const GroupPointer& group) {
+            std::unique_lock<std::mutex> guard = lockLeaders();
+            bool was_leader = isLeader(group);
+            ranking.erase(group);
+            if ((leaders != nullptr) && was_leader) {
+                (*leaders).update(ranking);
+            }
+        }
+
+        /**
+         * A private function that remembers the index entry of a name,
+         * before its first change since undo recording started.
+         */
+        void saveMember(const std::string& group_name) {
+            if (!recording || (saved_members.count(group_name) != 0)) {
+                return ;
+            }
+            std::unordered_map<std::string, Member>::const_iterator it =
+                    members.find(group_name);
+            SavedMember saved = { it != members.end(), Member() };
+            if (saved.present) {
+                saved.member = it->second;
+            }
+            saved_members[group_name] = saved;
+        }
+
+        /**
+         * A private function that starts remembering the groups of the clan
+         * before they change, so undo can put them back. Only the groups
+         * that change are remembered, not the whole clan. Uniting and
+         * making friends are not remembered.
+         */
+        void beginUndo() {
+            endUndo();
+            recording = true;
+            saved_size = groups.size();
+            saved_population = population;
+        }
 
         /**
-         * Adds all the groups from a given clan to this clan .
+         * A private function that puts back the groups of the clan the way
+         * they were at beginUndo, in the same slots, and stops remembering.
+         * The stats of the groups have to be put back first, so the groups
+         * that changed are ranked by the power they had.
+         */
+        void undo() {
+            //every group that joined, left or changed is in a saved slot, or
+            //in a slot that was added.
+            for (unsigned int slot = saved_size; slot < groups.size();
+                 slot++) {
+                unrankGroup(groups[slot]);
+            }
+            for (std::unordered_map<int, std::pair<GroupPointer,
+                    std::string> >::const_iterator it = saved_slots.begin();
+                 it != saved_slots.end(); ++it) {
+                if (it->first < (int)groups.size()) {
+                    unrankGroup(groups[it->first]);
+                }
+            }
+            groups.resize(saved_size);
+            slot_names.resize(saved_size);
+            for (std::unordered_map<int, std::pair<GroupPointer,
+                    std::string> >::const_iterator it = saved_slots.begin();
+                 it != saved_slots.end(); ++it) {
+                groups[it->first] = (it->second).first;
+                slot_names[it->first] = (it->second).second;
+                rankGroup(groups[it->first]);
+            }
+            for (std::unordered_map<std::string, SavedMember>::const_iterator
+                         it = saved_members.begin();
+                 it != saved_members.end(); ++it) {
+                if ((it->second).present) {
+                    members[it->first] = (it->second).member;
+                } else {
+                    members.erase(it->first);
+                }
+            }
+            population = saved_population;
+            endUndo();
+        }
+
+        /**
+         * A private function that forgets the changes since beginUndo, and
+         * stops remembering.
+         */
+        void endUndo() {
+            recording = false;
+            saved_slots.clear();
+            saved_members.clear();
+        }
+
+        /**
+         * A private function that puts a group in the clan and indexes it
+         * by its name, without ranking it.
+         * @param
+         * group - the group to put in the clan.
+         */
+        void placeGroup(const GroupPointer& group) {
+            saveSlot(groups.size());
+            saveMember((*group).getName());
+            Member member = { (int)groups.size(), (*group).getSize() };
+            groups.push_back(group);
+            slot_names.push_back((*group).getName());
+            members[slot_names.back()] = member;
+            population += member.size;
+        }
+
+        /**
+         * A private function that puts a group in the clan, indexes it by
+         * its name and ranks it.
+         * @param
+         * group - the group to put in the clan.
+         */
+        void insertGroup(const GroupPointer& group) {
+            placeGroup(group);
+            rankGroup(group);
+        }
+
+        /**
+         * A private function that takes a group out of the clan, by moving the
+         * last group into its slot.
+         * @param
+         * member - the index entry of the group to take out.
+         */
+        void removeGroup(std::unordered_map<std::string, Member>::iterator
+                         member) {
+            int slot = (member->second).slot;
+            int last = groups.size() - 1;
+            saveSlot(slot);
+            saveSlot(last);
+            saveMember(member->first);
+            saveMember(slot_names[last]);
+            population -= (member->second).size;
+            unrankGroup(groups[slot]);
+            members.erase(member);
+            if (slot != last) {
+                groups[slot] = groups[last];
+                slot_names[slot] = slot_names[last];
+                members[slot_names[slot]].slot = slot;
+            }
+            groups.pop_back();
+            slot_names.pop_back();
+        }
+
+        /**
+         * Moves all the groups from a given clan to this clan .
+         * The groups themselves are moved (not copies of them), so the areas
+         * that hold them keep seeing the same groups after the unite.
          * @param
          * other - the clan we wish to add all the groups from .
          */
         void addGroupsFromClan(const Clan& other) {
-            MtmSet<GroupPointer>::const_iterator c_it = other.groups.begin();
-            for (int i = 0; i < other.groups.size(); ++i) {
-                try {
-                    addGroup(*(*c_it));
-                }   catch (ClanGroupIsEmpty) {} ;
-                    c_it++;
+            for (unsigned int i = 0; i < other.groups.size(); ++i) {
+                (*(other.groups[i])).changeClan(clan_name);
+                insertGroup(other.groups[i]);
             }
         }
 
@@ -46,10 +307,8 @@ namespace mtm{
          * new_name - the new clan name we wish to change to .
          */
         void changeAllGroupsClan(const std::string& new_name){
-            MtmSet<GroupPointer>::const_iterator c_it = groups.begin();
-            for (int i = 0; i < groups.size(); ++i) {
-                (*(*c_it)).changeClan(new_name);
-                c_it++;
+            for (unsigned int i = 0; i < groups.size(); ++i) {
+                (*(groups[i])).changeClan(new_name);
             }
         }
         /**
@@ -63,12 +322,10 @@ namespace mtm{
          * false- otherwize .
          */
         bool checkIfGroupIsInOtherClan (const Clan & other) const {
-            MtmSet<GroupPointer>::const_iterator c_it = groups.begin();
-            for (int i = 0; i < groups.size(); ++i) {
-                if(other.doesContain((*(*c_it)).getName())){
+            for (unsigned int i = 0; i < groups.size(); ++i) {
+                if(other.doesContain((*(groups[i])).getName())){
                     return true ;
                 }
-                c_it++;
             }
             return false ;
         }
@@ -83,9 +340,10 @@ namespace mtm{
         explicit Clan(const std::string& name);
 
         /**
-         * Copy constructor.
+         * Copy constructor. The copy has the same groups (not copies of
+         * them), and it isn't in the leaders of a world.
          */
-        Clan(const Clan& other)= default;
+        Clan(const Clan& other);
 
         /**
          * Disable assignment operator
@@ -93,9 +351,9 @@ namespace mtm{
         Clan &operator=(const Clan &) = delete;
 
         /**
-         * Destructor
+         * Destructor. The clan is taken out of the leaders of its world.
          */
-        ~Clan() = default;
+        ~Clan();
 
         /**
          * Add a group (copy of it) to the clan
@@ -134,6 +392,55 @@ namespace mtm{
          */
         int getSize() const;
 
+        /**
+         * Tell the clan that one of its groups was changed through its
+         * pointer (in a fight, a unite or a divide), so the clan can update
+         * the amount of people it has, index the group by its new name, or
+         * remove it if it has no people left.
+         * When two groups of the clan united, refresh the group that was
+         * emptied first.
+         * @param group_name The name the group had before it changed. If
+         * there is no group in the clan that had this name, does nothing.
+         */
+        void refreshGroup(const std::string& group_name);
+
+        /**
+         * Rank a group of the clan again, after its power changed through
+         * its pointer in a way that kept its people and its name (a trade).
+         * It doesn't look at the other groups of the clan, so it can be
+         * called while the clan changes on another thread of a concurrent
+         * batch.
+         * @param group The group. If it isn't ranked in the clan, does
+         *  nothing.
+         */
+        void rerankGroup(const GroupPointer& group);
+
+        /**
+         * Order the clan in the leaders of a world by its strongest group,
+         * and keep it in order there as its groups change. The clan is taken
+         * out of the leaders it was in before, if there were any.
+         * The groups of the clan are ranked again, in case they changed
+         * without the clan being told.
+         * @param leaders The leaders of the world, or nullptr to stop
+         *  ordering the clan in a world.
+         */
+        void rankIn(ClanLeaders* leaders);
+
+        /**
+         * @return The groups of the clan, from the strongest to the weakest.
+         */
+        const GroupRanking& getRanking() const;
+
+        typedef std::vector<GroupPointer>::const_iterator const_iterator;
+
+        /**
+         * @return An iterator over the groups of the clan, in no particular
+         * order.
+         */
+        const_iterator begin() const;
+
+        const_iterator end() const;
+
         /**
          * Make two clans unite, to form a new clan, with a new name. All the
          * groups of each clan will change their clan.
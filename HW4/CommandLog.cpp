@@ -0,0 +1,408 @@
+#include "CommandLog.h"
+#include "exceptions.h"
+#include <sstream>
+
+using namespace mtm ;
+using std::string ;
+/**
+ * CommandLog.cpp , all functions are explained in CommandLog.h .
+ */
+
+/**
+ * The header of a binary log. The first byte is not printable, so a text
+ * log never starts with it.
+ */
+static const char BINARY_MAGIC[] = { '\x7f', 'W', 'L', 'O', 'G', '\x01' };
+static const int BINARY_MAGIC_SIZE = sizeof(BINARY_MAGIC);
+
+static const char* const AREA_TYPE_NAMES[] = { "plain", "mountain", "river" };
+
+/**
+ * Binary numbers are written as 4 bytes , little endian , so a log can be
+ * read on every machine.
+ */
+static void writeInt(std::ostream& output, int value) {
+    unsigned int bits = static_cast<unsigned int>(value);
+    char bytes[4];
+    for (int i = 0; i < 4; i++) {
+        bytes[i] = static_cast<char>((bits >> (8 * i)) & 0xff);
+    }
+    output.write(bytes, 4);
+}
+
+static void writeLong(std::ostream& output, long long value) {
+    unsigned long long bits = static_cast<unsigned long long>(value);
+    writeInt(output, static_cast<int>(bits & 0xffffffffu));
+    writeInt(output, static_cast<int>(bits >> 32));
+}
+
+static void writeString(std::ostream& output, const string& value) {
+    writeInt(output, static_cast<int>(value.size()));
+    output.write(value.data(), value.size());
+}
+
+static void readBytes(std::istream& input, char* bytes, int size) {
+    if (!input.read(bytes, size)) {
+        throw CommandLogTruncated();
+    }
+}
+
+static int readInt(std::istream& input) {
+    unsigned char bytes[4];
+    readBytes(input, reinterpret_cast<char*>(bytes), 4);
+    unsigned int bits = 0;
+    for (int i = 0; i < 4; i++) {
+        bits |= static_cast<unsigned int>(bytes[i]) << (8 * i);
+    }
+    return static_cast<int>(bits);
+}
+
+static long long readLong(std::istream& input) {
+    unsigned long long low = static_cast<unsigned int>(readInt(input));
+    unsigned long long high = static_cast<unsigned int>(readInt(input));
+    return static_cast<long long>(low | (high << 32));
+}
+
+static string readString(std::istream& input) {
+    int size = readInt(input);
+    if (size < 0) {
+        throw CommandLogBadCommand();
+    }
+    string value(size, '\0');
+    if (size > 0) {
+        readBytes(input, &value[0], size);
+    }
+    return value;
+}
+
+/**
+ * In a binary log, the type of a scheduled operation has this bit set, and
+ * its tick comes right after it.
+ */
+static const int SCHEDULED_BIT = 0x80;
+
+Command::Command() : type(CLAN_ADD), first(), second(), third(), children(0),
+                     adults(0), area_type(PLAIN), tick(-1) {}
+
+Command Command::fromOperation(const WorldOperation& operation) {
+    Command command;
+    switch (operation.type) {
+        case ADD_CLAN :
+            command.type = CLAN_ADD;
+            break ;
+        case ADD_AREA :
+            command.type = AREA_ADD;
+            break ;
+        case MAKE_REACHABLE :
+            command.type = REACH;
+            break ;
+        case ADD_GROUP :
+            command.type = GROUP_ADD;
+            break ;
+        case MOVE_GROUP :
+            command.type = MOVE;
+            break ;
+        case MAKE_FRIENDS :
+            command.type = FRIEND;
+            break ;
+        case UNITE_CLANS :
+            command.type = UNITE;
+            break ;
+    }
+    command.first = operation.first;
+    command.second = operation.second;
+    command.third = operation.third;
+    command.children = operation.children;
+    command.adults = operation.adults;
+    command.area_type = operation.area_type;
+    return command;
+}
+
+Command Command::printGroup(const string& group_name) {
+    Command command;
+    command.type = PRINT_GROUP;
+    command.first = group_name;
+    return command;
+}
+
+Command Command::printClan(const string& clan_name) {
+    Command command;
+    command.type = PRINT_CLAN;
+    command.first = clan_name;
+    return command;
+}
+
+Command Command::schedule(long long tick, const WorldOperation& operation) {
+    Command command = fromOperation(operation);
+    command.tick = tick;
+    return command;
+}
+
+Command Command::advance(long long tick) {
+    Command command;
+    command.type = ADVANCE;
+    command.tick = tick;
+    return command;
+}
+
+bool Command::isOperation() const {
+    return (type != PRINT_GROUP) && (type != PRINT_CLAN) && (type != ADVANCE);
+}
+
+WorldOperation Command::toOperation() const {
+    switch (type) {
+        case CLAN_ADD :
+            return WorldOperation::addClan(first);
+        case AREA_ADD :
+            return WorldOperation::addArea(first, area_type);
+        case REACH :
+            return WorldOperation::makeReachable(first, second);
+        case GROUP_ADD :
+            return WorldOperation::addGroup(first, second, children, adults,
+                                            third);
+        case MOVE :
+            return WorldOperation::moveGroup(first, second);
+        case FRIEND :
+            return WorldOperation::makeFriends(first, second);
+        default :
+            return WorldOperation::uniteClans(first, second, third);
+    }
+}
+
+const char* Command::typeName(CommandType type) {
+    static const char* const names[COMMAND_TYPES] = { "clan add", "area add",
+            "reach", "group add", "move", "friend", "unite", "print group",
+            "print clan", "advance" };
+    return names[type];
+}
+
+CommandReader::CommandReader(std::istream& input) : input(input),
+                                                     binary(false), line(0) {
+    if (input.peek() != BINARY_MAGIC[0]) {
+        return ;
+    }
+    char magic[BINARY_MAGIC_SIZE];
+    readBytes(input, magic, BINARY_MAGIC_SIZE);
+    if (string(magic, BINARY_MAGIC_SIZE) !=
+            string(BINARY_MAGIC, BINARY_MAGIC_SIZE)) {
+        throw CommandLogBadCommand();
+    }
+    binary = true;
+}
+
+bool CommandReader::next(Command& command) {
+    if (binary) {
+        return nextBinary(command);
+    }
+    return nextText(command);
+}
+
+bool CommandReader::isBinary() const {
+    return binary;
+}
+
+int CommandReader::getLine() const {
+    return line;
+}
+
+bool CommandReader::nextText(Command& command) {
+    string text;
+    while (std::getline(input, text)) {
+        line++;
+        std::istringstream words(text);
+        string verb;
+        if (!(words >> verb) || (verb[0] == '#')) {
+            continue ;
+        }
+        Command result;
+        string kind;
+        bool valid = false;
+        long long tick = -1;
+        if ((verb == "at") && !((words >> tick >> verb) && (tick >= 0))) {
+            throw CommandLogBadCommand();
+        }
+        if (verb == "clan") {
+            result.type = CLAN_ADD;
+            valid = (words >> kind) && (kind == "add") &&
+                    (words >> result.first);
+        } else if (verb == "area") {
+            result.type = AREA_ADD;
+            string area_type;
+            valid = (words >> kind) && (kind == "add") &&
+                    (words >> result.first >> area_type);
+            if (valid) {
+                valid = false;
+                for (int i = 0; i < 3; i++) {
+                    if (area_type == AREA_TYPE_NAMES[i]) {
+                        result.area_type = static_cast<AreaType>(i);
+                        valid = true;
+                    }
+                }
+            }
+        } else if (verb == "reach" || verb == "move" || verb == "friend") {
+            result.type = verb == "reach" ? REACH :
+                          verb == "move" ? MOVE : FRIEND;
+            valid = static_cast<bool>(words >> result.first >> result.second);
+        } else if (verb == "group") {
+            result.type = GROUP_ADD;
+            valid = (words >> kind) && (kind == "add") &&
+                    (words >> result.first >> result.second >>
+                     result.children >> result.adults >> result.third);
+        } else if (verb == "unite") {
+            result.type = UNITE;
+            valid = static_cast<bool>(words >> result.first >> result.second
+                                            >> result.third);
+        } else if (verb == "print") {
+            valid = (words >> kind) && (kind == "group" || kind == "clan") &&
+                    (words >> result.first);
+            result.type = kind == "group" ? PRINT_GROUP : PRINT_CLAN;
+        } else if (verb == "advance") {
+            result.type = ADVANCE;
+            valid = (words >> result.tick) && (result.tick >= 0);
+        }
+        if (tick != -1) {
+            valid = valid && result.isOperation();
+            result.tick = tick;
+        }
+        string extra;
+        if (!valid || (words >> extra)) {
+            throw CommandLogBadCommand();
+        }
+        command = result;
+        return true;
+    }
+    return false;
+}
+
+bool CommandReader::nextBinary(Command& command) {
+    int type = input.get();
+    if (type == std::char_traits<char>::eof()) {
+        return false;
+    }
+    Command result;
+    bool scheduled = (type & SCHEDULED_BIT) != 0;
+    type &= ~SCHEDULED_BIT;
+    if (type >= COMMAND_TYPES) {
+        throw CommandLogBadCommand();
+    }
+    result.type = static_cast<CommandType>(type);
+    if (scheduled || (result.type == ADVANCE)) {
+        result.tick = readLong(input);
+        if ((result.tick < 0) || (scheduled && !result.isOperation())) {
+            throw CommandLogBadCommand();
+        }
+    }
+    if (result.type == ADVANCE) {
+        command = result;
+        return true;
+    }
+    result.first = readString(input);
+    switch (result.type) {
+        case AREA_ADD : {
+            int area_type = input.get();
+            if (area_type == std::char_traits<char>::eof()) {
+                throw CommandLogTruncated();
+            }
+            if (area_type > RIVER) {
+                throw CommandLogBadCommand();
+            }
+            result.area_type = static_cast<AreaType>(area_type);
+            break ;
+        }
+        case GROUP_ADD :
+            result.second = readString(input);
+            result.third = readString(input);
+            result.children = readInt(input);
+            result.adults = readInt(input);
+            break ;
+        case REACH :
+        case MOVE :
+        case FRIEND :
+            result.second = readString(input);
+            break ;
+        case UNITE :
+            result.second = readString(input);
+            result.third = readString(input);
+            break ;
+        default :
+            break ;
+    }
+    command = result;
+    return true;
+}
+
+CommandWriter::CommandWriter(std::ostream& output, bool binary) :
+        output(output), binary(binary) {
+    if (binary) {
+        output.write(BINARY_MAGIC, BINARY_MAGIC_SIZE);
+    }
+}
+
+void CommandWriter::write(const Command& command) {
+    if (binary) {
+        if (command.type == ADVANCE) {
+            output.put(static_cast<char>(command.type));
+            writeLong(output, command.tick);
+            return ;
+        }
+        if (command.isOperation() && (command.tick >= 0)) {
+            output.put(static_cast<char>(command.type | SCHEDULED_BIT));
+            writeLong(output, command.tick);
+        } else {
+            output.put(static_cast<char>(command.type));
+        }
+        writeString(output, command.first);
+        switch (command.type) {
+            case AREA_ADD :
+                output.put(static_cast<char>(command.area_type));
+                break ;
+            case GROUP_ADD :
+                writeString(output, command.second);
+                writeString(output, command.third);
+                writeInt(output, command.children);
+                writeInt(output, command.adults);
+                break ;
+            case REACH :
+            case MOVE :
+            case FRIEND :
+                writeString(output, command.second);
+                break ;
+            case UNITE :
+                writeString(output, command.second);
+                writeString(output, command.third);
+                break ;
+            default :
+                break ;
+        }
+        return ;
+    }
+    if (command.type == ADVANCE) {
+        output << Command::typeName(command.type) << ' ' << command.tick
+               << '\n';
+        return ;
+    }
+    if (command.isOperation() && (command.tick >= 0)) {
+        output << "at " << command.tick << ' ';
+    }
+    output << Command::typeName(command.type) << ' ' << command.first;
+    switch (command.type) {
+        case AREA_ADD :
+            output << ' ' << AREA_TYPE_NAMES[command.area_type];
+            break ;
+        case GROUP_ADD :
+            output << ' ' << command.second << ' ' << command.children << ' '
+                   << command.adults << ' ' << command.third;
+            break ;
+        case REACH :
+        case MOVE :
+        case FRIEND :
+            output << ' ' << command.second;
+            break ;
+        case UNITE :
+            output << ' ' << command.second << ' ' << command.third;
+            break ;
+        default :
+            break ;
+    }
+    output << '\n';
+}
@@ -0,0 +1,173 @@
+#ifndef MTM4_COMMAND_LOG_H
+#define MTM4_COMMAND_LOG_H
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include "WorldOperation.h"
+
+namespace mtm{
+
+    enum CommandType{
+        CLAN_ADD, AREA_ADD, REACH, GROUP_ADD, MOVE, FRIEND, UNITE,
+        PRINT_GROUP, PRINT_CLAN, ADVANCE
+    };
+
+    const int COMMAND_TYPES = 10;
+
+    /**
+     * One command of a command log: a World operation, or a print.
+     * The text form of every command is one line, where the names are
+     * separated by white spaces (so in a text log a name can't have white
+     * spaces in it):
+     *  clan add <clan>
+     *  area add <area> <plain|mountain|river>
+     *  reach <from> <to>
+     *  group add <group> <clan> <children> <adults> <area>
+     *  move <group> <destination>
+     *  friend <clan1> <clan2>
+     *  unite <clan1> <clan2> <new name>
+     *  print group <group>
+     *  print clan <clan>
+     *  advance <tick>
+     * An operation that is scheduled for a tick instead of applied right
+     * away starts with "at <tick>", like "at 5 move <group> <destination>".
+     * Empty lines and lines that start with '#' are skipped.
+     */
+    struct Command{
+        CommandType type;
+        std::string first;
+        std::string second;
+        std::string third;
+        int children;
+        int adults;
+        AreaType area_type;
+        /**
+         * The tick of an ADVANCE, or the tick a scheduled operation is
+         * scheduled for. -1 for an operation that is applied right away.
+         */
+        long long tick;
+
+        Command();
+
+        /**
+         * @param operation A World operation.
+         * @return The command that applies the operation.
+         */
+        static Command fromOperation(const WorldOperation& operation);
+
+        static Command printGroup(const std::string& group_name);
+
+        static Command printClan(const std::string& clan_name);
+
+        /**
+         * @param tick A tick.
+         * @param operation A World operation.
+         * @return The command that schedules the operation for the tick.
+         */
+        static Command schedule(long long tick,
+                                const WorldOperation& operation);
+
+        static Command advance(long long tick);
+
+        /**
+         * @return true if the command is a World operation (applied right
+         *  away or scheduled), false if it is a print or an ADVANCE.
+         */
+        bool isOperation() const;
+
+        /**
+         * @return The World operation of the command. Only for commands
+         *  that are operations.
+         */
+        WorldOperation toOperation() const;
+
+        /**
+         * @param type A command type.
+         * @return The name of the type, as it is written in a text log
+         *  ("clan add", "move", ...).
+         */
+        static const char* typeName(CommandType type);
+    };
+
+    /**
+     * Reads commands one after the other from a text or a binary log. The
+     * format is found by the first byte of the log: a binary log starts
+     * with a magic header that can't start a text line.
+     */
+    class CommandReader{
+        std::istream& input;
+        bool binary;
+        int line;
+
+        /**
+         * Private functions that read one command of each format.
+         * @return false if the log ended before the command started.
+         * @throws CommandLogBadCommand if the command isn't valid.
+         * @throws CommandLogTruncated if the log ended inside the command.
+         */
+        bool nextText(Command& command);
+        bool nextBinary(Command& command);
+
+    public:
+        /**
+         * @param input The stream of the log, it has to stay alive while
+         *  the reader is used.
+         * @throws CommandLogTruncated if the log has a cut binary header.
+         * @throws CommandLogBadCommand if the binary header is wrong.
+         */
+        explicit CommandReader(std::istream& input);
+
+        CommandReader(const CommandReader&) = delete;
+        CommandReader& operator=(const CommandReader&) = delete;
+
+        /**
+         * Read the next command of the log.
+         * @param command Where to put the command.
+         * @return true if a command was read, false at the end of the log.
+         * @throws CommandLogBadCommand if the command isn't valid. In a
+         *  text log, the rest of the log can still be read.
+         * @throws CommandLogTruncated if the log ended inside a command.
+         */
+        bool next(Command& command);
+
+        /**
+         * @return true if the log is binary.
+         */
+        bool isBinary() const;
+
+        /**
+         * @return The number of the last line that was read, in a text log.
+         */
+        int getLine() const;
+    };
+
+    /**
+     * Writes commands to a text or a binary log, in the format
+     * CommandReader reads.
+     */
+    class CommandWriter{
+        std::ostream& output;
+        bool binary;
+
+    public:
+        /**
+         * @param output The stream to write to, it has to stay alive while
+         *  the writer is used.
+         * @param binary true to write a binary log, false for a text log.
+         *  The header of a binary log is written right away.
+         */
+        CommandWriter(std::ostream& output, bool binary);
+
+        CommandWriter(const CommandWriter&) = delete;
+        CommandWriter& operator=(const CommandWriter&) = delete;
+
+        /**
+         * Write one command to the log.
+         * @param command The command to write.
+         */
+        void write(const Command& command);
+    };
+} // namespace mtm
+
+#endif //MTM4_COMMAND_LOG_H
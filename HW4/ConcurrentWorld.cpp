@@ -0,0 +1,150 @@
+#include "ConcurrentWorld.h"
+
+using namespace mtm ;
+/**
+ * ConcurrentWorld.cpp , all functions are explained in ConcurrentWorld.h .
+ */
+
+void ConcurrentWorld::addClan(const string& new_clan) {
+    WriteLock guard(mutex);
+    world.addClan(new_clan);
+}
+
+void ConcurrentWorld::addArea(const string& area_name, AreaType type) {
+    WriteLock guard(mutex);
+    world.addArea(area_name, type);
+}
+
+void ConcurrentWorld::addGroup(const string& group_name,
+                               const string& clan_name, int num_children,
+                               int num_adults, const string& area_name) {
+    WriteLock guard(mutex);
+    world.addGroup(group_name, clan_name, num_children, num_adults,
+                   area_name);
+}
+
+void ConcurrentWorld::makeReachable(const string& from, const string& to) {
+    WriteLock guard(mutex);
+    world.makeReachable(from, to);
+}
+
+void ConcurrentWorld::moveGroup(const string& group_name,
+                                const string& destination) {
+    WriteLock guard(mutex);
+    world.moveGroup(group_name, destination);
+}
+
+void ConcurrentWorld::moveGroupVia(const string& group_name,
+                                   const string& destination) {
+    WriteLock guard(mutex);
+    world.moveGroupVia(group_name, destination);
+}
+
+void ConcurrentWorld::makeFriends(const string& clan1, const string& clan2) {
+    WriteLock guard(mutex);
+    world.makeFriends(clan1, clan2);
+}
+
+void ConcurrentWorld::uniteClans(const string& clan1, const string& clan2,
+                                 const string& new_name) {
+    WriteLock guard(mutex);
+    world.uniteClans(clan1, clan2, new_name);
+}
+
+WorldResult ConcurrentWorld::apply(const WorldOperation& operation) {
+    WriteLock guard(mutex);
+    return world.apply(operation);
+}
+
+std::vector<WorldResult> ConcurrentWorld::applyBatch(
+        const std::vector<WorldOperation>& operations) {
+    WriteLock guard(mutex);
+    return world.applyBatch(operations);
+}
+
+std::vector<WorldResult> ConcurrentWorld::applyBatchConcurrently(
+        const std::vector<WorldOperation>& operations, int threads) {
+    WriteLock guard(mutex);
+    return world.applyBatchConcurrently(operations, threads);
+}
+
+long long ConcurrentWorld::schedule(long long tick,
+                                    const WorldOperation& operation) {
+    WriteLock guard(mutex);
+    return world.schedule(tick, operation);
+}
+
+std::vector<EventResult> ConcurrentWorld::advanceTo(long long tick) {
+    WriteLock guard(mutex);
+    return world.advanceTo(tick);
+}
+
+std::shared_ptr<const WorldSnapshot> ConcurrentWorld::snapshot() {
+    WriteLock guard(mutex);
+    return world.snapshot();
+}
+
+std::shared_ptr<const WorldSnapshot> ConcurrentWorld::getSnapshot() const {
+    return world.getSnapshot();
+}
+
+bool ConcurrentWorld::canReach(const string& from, const string& to) const {
+    SharedLock guard(mutex);
+    return world.canReach(from, to);
+}
+
+long long ConcurrentWorld::getCurrentTick() const {
+    SharedLock guard(mutex);
+    return world.getCurrentTick();
+}
+
+int ConcurrentWorld::getPendingEvents() const {
+    SharedLock guard(mutex);
+    return world.getPendingEvents();
+}
+
+SchedulerStats ConcurrentWorld::getSchedulerStats() const {
+    SharedLock guard(mutex);
+    return world.getSchedulerStats();
+}
+
+int ConcurrentWorld::getRulerChanges(const string& area_name) const {
+    SharedLock guard(mutex);
+    return world.getRulerChanges(area_name);
+}
+
+void ConcurrentWorld::printGroup(std::ostream& os,
+                                 const string& group_name) const {
+    SharedLock guard(mutex);
+    world.printGroup(os, group_name);
+}
+
+void ConcurrentWorld::printClan(std::ostream& os,
+                                const string& clan_name) const {
+    SharedLock guard(mutex);
+    world.printClan(os, clan_name);
+}
+
+WorldResult ConcurrentWorld::tryCanReach(const string& from, const string& to,
+                                         bool& reachable) const {
+    SharedLock guard(mutex);
+    return world.tryCanReach(from, to, reachable);
+}
+
+WorldResult ConcurrentWorld::tryGetRulerChanges(const string& area_name,
+                                                int& changes) const {
+    SharedLock guard(mutex);
+    return world.tryGetRulerChanges(area_name, changes);
+}
+
+WorldResult ConcurrentWorld::tryPrintGroup(std::ostream& os,
+                                           const string& group_name) const {
+    SharedLock guard(mutex);
+    return world.tryPrintGroup(os, group_name);
+}
+
+WorldResult ConcurrentWorld::tryPrintClan(std::ostream& os,
+                                          const string& clan_name) const {
+    SharedLock guard(mutex);
+    return world.tryPrintClan(os, clan_name);
+}
@@ -0,0 +1,78 @@
+#ifndef MTM4_CONCURRENT_WORLD_H
+#define MTM4_CONCURRENT_WORLD_H
+
+#include "World.h"
+#include "SharedMutex.h"
+
+namespace mtm{
+
+    /**
+     * A world that many threads can use at once: the prints and the queries
+     * run together on any number of threads, and the functions that change
+     * the world run one at a time, while no query runs.
+     * Every function works like the World function with the same name.
+     * Readers that don't need the latest state can query getSnapshot()
+     * instead, which doesn't wait for the writer at all.
+     *
+     * Lock ordering: every function holds one ShardedSharedMutex, which a
+     * writer takes shard by shard from the first to the last. A unite and a
+     * move both hold the whole world alone, so they can't deadlock on the
+     * clans and areas they share. Inside a writer, applyBatchConcurrently
+     * takes the GroupNames lock and the locks of its thread pool, never the
+     * other way around.
+     * A batch holds the world alone from its first operation to its last, so
+     * readers see all of it or none of it. Writers that want readers to get
+     * in between their operations should apply them one by one.
+     */
+    class ConcurrentWorld{
+        World world;
+        mutable ShardedSharedMutex mutex;
+
+        typedef std::lock_guard<ShardedSharedMutex> WriteLock;
+
+    public:
+        ConcurrentWorld() = default;
+
+        ConcurrentWorld(const ConcurrentWorld&) = delete;
+        ConcurrentWorld& operator=(const ConcurrentWorld&) = delete;
+
+        void addClan(const string& new_clan);
+        void addArea(const string& area_name, AreaType type);
+        void addGroup(const string& group_name, const string& clan_name,
+                      int num_children, int num_adults,
+                      const string& area_name);
+        void makeReachable(const string& from, const string& to);
+        void moveGroup(const string& group_name, const string& destination);
+        void moveGroupVia(const string& group_name, const string& destination);
+        void makeFriends(const string& clan1, const string& clan2);
+        void uniteClans(const string& clan1, const string& clan2,
+                        const string& new_name);
+        WorldResult apply(const WorldOperation& operation);
+        std::vector<WorldResult> applyBatch(
+                const std::vector<WorldOperation>& operations);
+        std::vector<WorldResult> applyBatchConcurrently(
+                const std::vector<WorldOperation>& operations, int threads);
+        long long schedule(long long tick, const WorldOperation& operation);
+        std::vector<EventResult> advanceTo(long long tick);
+        std::shared_ptr<const WorldSnapshot> snapshot();
+        std::shared_ptr<const WorldSnapshot> getSnapshot() const;
+
+        bool canReach(const string& from, const string& to) const;
+        long long getCurrentTick() const;
+        int getPendingEvents() const;
+        SchedulerStats getSchedulerStats() const;
+        int getRulerChanges(const string& area_name) const;
+        void printGroup(std::ostream& os, const string& group_name) const;
+        void printClan(std::ostream& os, const string& clan_name) const;
+        WorldResult tryCanReach(const string& from, const string& to,
+                                bool& reachable) const;
+        WorldResult tryGetRulerChanges(const string& area_name,
+                                       int& changes) const;
+        WorldResult tryPrintGroup(std::ostream& os,
+                                  const string& group_name) const;
+        WorldResult tryPrintClan(std::ostream& os,
+                                 const string& clan_name) const;
+    };
+} // namespace mtm
+
+#endif //MTM4_CONCURRENT_WORLD_H
@@ -0,0 +1,29 @@
+#include "EventScheduler.h"
+
+using namespace mtm ;
+/**
+ * EventScheduler.cpp , all functions are explained in EventScheduler.h .
+ */
+
+EventScheduler::EventScheduler() : events(), next_id(0) {}
+
+long long EventScheduler::schedule(long long tick,
+                                   const WorldOperation& operation) {
+    ScheduledEvent event = { tick, next_id++, operation };
+    events.push(event);
+    return event.id;
+}
+
+bool EventScheduler::hasEventUntil(long long tick) const {
+    return !events.empty() && events.top().tick <= tick;
+}
+
+ScheduledEvent EventScheduler::takeNext() {
+    ScheduledEvent event = events.top();
+    events.pop();
+    return event;
+}
+
+int EventScheduler::size() const {
+    return events.size();
+}
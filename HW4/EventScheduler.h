@@ -0,0 +1,96 @@
+#ifndef MTM4_EVENT_SCHEDULER_H
+#define MTM4_EVENT_SCHEDULER_H
+
+#include <queue>
+#include <vector>
+#include "WorldOperation.h"
+
+namespace mtm{
+
+    /**
+     * An operation that should be applied to a world at a given tick.
+     * id is the number of the event in the order events were scheduled.
+     */
+    struct ScheduledEvent{
+        long long tick;
+        long long id;
+        WorldOperation operation;
+    };
+
+    /**
+     * The result of an event that was applied.
+     */
+    struct EventResult{
+        long long tick;
+        long long id;
+        WorldResult result;
+    };
+
+    /**
+     * How many events were applied, and how long applying them took.
+     */
+    struct SchedulerStats{
+        long long events_processed;
+        double seconds;
+
+        /**
+         * @return The events applied per second, 0 if no time was measured.
+         */
+        double eventsPerSecond() const {
+            return seconds > 0 ? events_processed / seconds : 0;
+        }
+    };
+
+    /**
+     * The events that were scheduled and were not applied yet, by their
+     * order: the earliest tick first, and events of the same tick in the
+     * order they were scheduled. Scheduling and taking out an event are
+     * O(log n).
+     */
+    class EventScheduler{
+        friend class Checkpoint;
+
+        struct Later{
+            bool operator()(const ScheduledEvent& e1,
+                            const ScheduledEvent& e2) const {
+                if (e1.tick != e2.tick) {
+                    return e1.tick > e2.tick;
+                }
+                return e1.id > e2.id;
+            }
+        };
+        std::priority_queue<ScheduledEvent, std::vector<ScheduledEvent>,
+                Later> events;
+        long long next_id;
+
+    public:
+        EventScheduler();
+
+        /**
+         * Schedule an event.
+         * @param tick The tick of the event.
+         * @param operation The operation to apply at the tick.
+         * @return The id of the event.
+         */
+        long long schedule(long long tick, const WorldOperation& operation);
+
+        /**
+         * @param tick A tick.
+         * @return true if there is an event at the tick or before it.
+         */
+        bool hasEventUntil(long long tick) const;
+
+        /**
+         * Take out the next event. There has to be one.
+         * @return The next event.
+         */
+        ScheduledEvent takeNext();
+
+        /**
+         * @return The number of events that were not taken out yet.
+         */
+        int size() const;
+    };
+} // namespace mtm
+
+#endif //MTM4_EVENT_SCHEDULER_H
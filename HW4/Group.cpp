@@ -1,7 +1,8 @@
 #include "Group.h"
+#include "Metrics.h"
+#include "Trace.h"
 using namespace mtm;
 using  std::ostream ;
-using std::endl;
 
 /**
  * Group.cpp
@@ -37,6 +38,26 @@ const std::string& Group::getClan() const{
     return clan_name;
 }
 
+int Group::getChildren() const{
+    return children;
+}
+
+int Group::getAdults() const{
+    return adults;
+}
+
+int Group::getMorale() const{
+    return morale;
+}
+
+int Group::getTools() const{
+    return tools;
+}
+
+int Group::getFood() const{
+    return food;
+}
+
 void Group::changeClan(const std::string& clan){
     if (clan_name==clan) {//if clans are equal do nothing.
         return ;
@@ -58,7 +79,7 @@ void Group::changeClan(const std::string& clan){
 }
 
 bool Group::operator<(const Group& rhs) const{
-    int res = getPower() - rhs.getPower() ;
+    long long res = getPower() - rhs.getPower() ;
     if (res>0){
         return false;
     }
@@ -72,7 +93,7 @@ bool Group::operator<(const Group& rhs) const{
 }
 
 bool Group::operator>(const Group& rhs) const{
-    int res = getPower() - rhs.getPower() ;
+    long long res = getPower() - rhs.getPower() ;
     if (res>0){
         return true;
     }
@@ -115,6 +136,7 @@ bool Group::unite(Group& other, int max_amount){
     }
     operator+=(other);
     other.emptyGroup();
+    MTM_COUNT(METRIC_GROUP_UNITES);
     return true;
 }
 
@@ -128,10 +150,12 @@ Group Group::divide(const std::string& name){
     Group new_gorup(name,clan_name,children/2,adults/2,tools/2
             ,food/2,morale);
     (*this)-=(new_gorup);
+    MTM_COUNT(METRIC_GROUP_DIVIDES);
     return new_gorup;
 }
 
 FIGHT_RESULT Group::fight(Group& opponent){
+    MTM_TRACE("Group::fight");
     if (this==&opponent){
         throw GroupCantFightWithItself();
     }
@@ -140,16 +164,20 @@ FIGHT_RESULT Group::fight(Group& opponent){
     }
     if (operator>(opponent)){
         fightEffects((*this),opponent);
+        MTM_COUNT(METRIC_FIGHTS_WON);
         return WON;
     }
     if (operator<(opponent)){
         fightEffects(opponent,(*this));
+        MTM_COUNT(METRIC_FIGHTS_LOST);
         return LOST;
     }
+    MTM_COUNT(METRIC_FIGHTS_DRAWN);
     return DRAW;
 }
 
 bool Group::trade(Group& other){
+    MTM_TRACE("Group::trade");
     if (this==&other){
         throw GroupCantTradeWithItself();
     }
@@ -163,15 +191,33 @@ bool Group::trade(Group& other){
     } else {
         exchangeProducts(other,(*this));
     }
+    MTM_COUNT(METRIC_TRADES);
     return true;
 }
 
+void Group::print(OutputBuffer& output) const {
+    output.append("Group's name: ");
+    output.append(group_name);
+    output.append("\nGroup's clan: ");
+    output.append(clan_name);
+    output.append("\nGroup's children: ");
+    output.appendNumber(children);
+    output.append("\nGroup's adults: ");
+    output.appendNumber(adults);
+    output.append("\nGroup's tools: ");
+    output.appendNumber(tools);
+    output.append("\nGroup's food: ");
+    output.appendNumber(food);
+    output.append("\nGroup's morale: ");
+    output.appendNumber(morale);
+    output.append('\n');
+}
+
 std::ostream& mtm::operator<<(std::ostream& os, const Group& group){
-    return os << "Group's name: "<<group.group_name<<endl <<
-              "Group's clan: "<<group.clan_name<<endl <<
-              "Group's children: "<<group.children<<endl <<
-              "Group's adults: "<<group.adults<<endl <<
-              "Group's tools: "<<group.tools<<endl <<
-              "Group's food: "<<group.food<<endl <<
-              "Group's morale: "<<group.morale<<endl ;
+    //one write to the stream, and no flush after every line.
+    char buffer[OutputBuffer::STACK_SIZE];
+    OutputBuffer output(os, buffer, sizeof(buffer));
+    group.print(output);
+    output.flush();
+    return os;
 }
\ No newline at end of file
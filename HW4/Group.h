@@ -5,6 +5,7 @@
 #include <ostream>
 #include <math.h>
 #include "exceptions.h"
+#include "OutputBuffer.h"
 
 namespace mtm{
 
@@ -34,15 +35,6 @@ namespace mtm{
             return true;
         }
 
-        /**
-         * Calculates and returns the power of the group as defined.
-         * @return
-         * the power of the group .
-         */
-         int getPower() const {
-            return (((10*adults+3*children)*(10*tools+food)*morale)/100);
-        }
-
         /**
          * A private function that helps us unite one group with this group.
          * @param group - the group that we which to add it's parameters
@@ -186,6 +178,16 @@ namespace mtm{
          */
         const std::string& getName() const;
 
+        /**
+         * Calculates and returns the power of the group, as defined in the
+         * comparison operators. It is computed in long long, since the
+         * groups of a big world grow past what an int can hold.
+         * @return The power of the group.
+         */
+        long long getPower() const {
+            return (((10LL*adults+3*children)*(10LL*tools+food)*morale)/100);
+        }
+
         /**
          * Get the amount of people (children + adults) in the group.
          * @return  Amount of people in the group
@@ -197,6 +199,31 @@ namespace mtm{
          */
         const std::string& getClan() const;
 
+        /**
+         * @return The amount of children in the group.
+         */
+        int getChildren() const;
+
+        /**
+         * @return The amount of adults in the group.
+         */
+        int getAdults() const;
+
+        /**
+         * @return The morale of the group.
+         */
+        int getMorale() const;
+
+        /**
+         * @return The amount of tools the group has.
+         */
+        int getTools() const;
+
+        /**
+         * @return The amount of food the group has.
+         */
+        int getFood() const;
+
         /**
          * Change the clan of the group.
          * If the group had a different clan before, reduce morale by 10%.
@@ -358,6 +385,13 @@ namespace mtm{
          */
         bool trade(Group& other);
 
+        /**
+         * Write the data of the group into a buffer, in the same form as
+         * operator<< .
+         * @param output The buffer to write into.
+         */
+        void print(OutputBuffer& output) const;
+
         /**
          * Print the data of a given group. Output form:
          *      Group's name: [group's name]
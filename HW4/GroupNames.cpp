@@ -0,0 +1,177 @@
+#include "GroupNames.h"
+using namespace mtm ;
+
+/**
+ * GroupNames.cpp , all functions are explained in GroupNames.h .
+ */
+GroupNames::GroupNames() : entries(), families(), mutex(), concurrent(false),
+                           recording(false), saved_entries(),
+                           saved_families() {}
+
+bool GroupNames::splitSuffix(const std::string& name, std::string& base,
+                             int& suffix) {
+    std::string::size_type underscore = name.rfind('_');
+    if ((underscore == std::string::npos) ||
+        (underscore + 1 == name.size()) ||
+        (name.size() - underscore > 10) || (name[underscore + 1] == '0')) {
+        return false ;
+    }
+    suffix = 0 ;
+    for (std::string::size_type i = underscore + 1; i < name.size(); i++) {
+        if ((name[i] < '0') || (name[i] > '9')) {
+            return false ;
+        }
+        suffix = suffix * 10 + (name[i] - '0');
+    }
+    base = name.substr(0, underscore);
+    return suffix > 1 ;
+}
+
+void GroupNames::place(const GroupPointer& group, Area* area) {
+    std::unique_lock<std::mutex> guard = lock();
+    saveEntry((*group).getName());
+    Entry entry = { group, area };
+    entries[(*group).getName()] = entry;
+}
+
+void GroupNames::leave(const std::string& group_name) {
+    std::unique_lock<std::mutex> guard = lock();
+    std::unordered_map<std::string, Entry>::iterator it =
+            entries.find(group_name);
+    if (it != entries.end()) {
+        saveEntry(group_name);
+        (it->second).area = nullptr ;
+    }
+}
+
+void GroupNames::release(const std::string& group_name) {
+    std::unique_lock<std::mutex> guard = lock();
+    saveEntry(group_name);
+    entries.erase(group_name);
+    std::string base ;
+    int suffix ;
+    if (!splitSuffix(group_name, base, suffix)) {
+        return ;
+    }
+    std::unordered_map<std::string, SuffixFamily>::iterator it =
+            families.find(base);
+    if ((it != families.end()) && (suffix < (it->second).next)) {
+        saveFamily(base);
+        (it->second).freed.insert(suffix);
+    }
+}
+
+bool GroupNames::contains(const std::string& group_name) const {
+    std::unique_lock<std::mutex> guard = lock();
+    return containsName(group_name);
+}
+
+bool GroupNames::containsName(const std::string& group_name) const {
+    return entries.find(group_name) != entries.end();
+}
+
+GroupPointer GroupNames::getGroup(const std::string& group_name) const {
+    std::unique_lock<std::mutex> guard = lock();
+    std::unordered_map<std::string, Entry>::const_iterator it =
+            entries.find(group_name);
+    if (it == entries.end()) {
+        return nullptr ;
+    }
+    return (it->second).group ;
+}
+
+Area* GroupNames::getArea(const std::string& group_name) const {
+    std::unique_lock<std::mutex> guard = lock();
+    std::unordered_map<std::string, Entry>::const_iterator it =
+            entries.find(group_name);
+    if (it == entries.end()) {
+        return nullptr ;
+    }
+    return (it->second).area ;
+}
+
+std::string GroupNames::splitName(const std::string& group_name) {
+    std::unique_lock<std::mutex> guard = lock();
+    saveFamily(group_name);
+    std::unordered_map<std::string, SuffixFamily>::iterator it =
+            families.find(group_name);
+    if (it == families.end()) {
+        SuffixFamily family ;
+        family.next = 2 ;
+        it = families.insert(std::make_pair(group_name, family)).first;
+    }
+    SuffixFamily& family = it->second ;
+    std::string name ;
+    while (!family.freed.empty()) {
+        name = group_name + "_" + std::to_string(*family.freed.begin());
+        family.freed.erase(family.freed.begin());
+        if (!containsName(name)) {
+            return name ;
+        }
+    }
+    do {
+        name = group_name + "_" + std::to_string(family.next++);
+    } while (containsName(name));
+    return name ;
+}
+
+void GroupNames::setConcurrent(bool shared) {
+    concurrent = shared;
+}
+
+void GroupNames::saveEntry(const std::string& group_name) {
+    if (!recording || (saved_entries.count(group_name) != 0)) {
+        return ;
+    }
+    std::unordered_map<std::string, Entry>::const_iterator it =
+            entries.find(group_name);
+    SavedEntry saved = { it != entries.end(), Entry() };
+    if (saved.present) {
+        saved.entry = it->second;
+    }
+    saved_entries.insert(std::make_pair(group_name, saved));
+}
+
+void GroupNames::saveFamily(const std::string& base) {
+    if (!recording || (saved_families.count(base) != 0)) {
+        return ;
+    }
+    std::unordered_map<std::string, SuffixFamily>::const_iterator it =
+            families.find(base);
+    SavedFamily saved = { it != families.end(), SuffixFamily() };
+    if (saved.present) {
+        saved.family = it->second;
+    }
+    saved_families.insert(std::make_pair(base, saved));
+}
+
+void GroupNames::beginUndo() {
+    endUndo();
+    recording = true;
+}
+
+void GroupNames::undo() {
+    for (std::unordered_map<std::string, SavedEntry>::const_iterator it =
+            saved_entries.begin(); it != saved_entries.end(); ++it) {
+        if ((it->second).present) {
+            entries[it->first] = (it->second).entry;
+        } else {
+            entries.erase(it->first);
+        }
+    }
+    for (std::unordered_map<std::string, SavedFamily>::const_iterator it =
+            saved_families.begin(); it != saved_families.end(); ++it) {
+        if ((it->second).present) {
+            families[it->first] = (it->second).family;
+        } else {
+            families.erase(it->first);
+        }
+    }
+    endUndo();
+}
+
+void GroupNames::endUndo() {
+    recording = false;
+    saved_entries.clear();
+    saved_families.clear();
+}
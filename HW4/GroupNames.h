@@ -0,0 +1,196 @@
+#ifndef MTM4_GROUP_NAMES_H
+#define MTM4_GROUP_NAMES_H
+
+#include <string>
+#include <set>
+#include <mutex>
+#include <unordered_map>
+#include "Clan.h"
+
+namespace mtm{
+
+    class Area;
+
+    /**
+     * A world-level index of the names of all the living groups, with the
+     * group every name belongs to and the area the group is in.
+     * The areas keep it up to date: they report every group that gets in or
+     * out of them, and every name that stops being used, because its group
+     * was emptied in a fight or united into another group.
+     *
+     * It also gives new names to divided groups ("<name>_<i>") without
+     * checking every candidate against every clan. For every name that was
+     * divided, it remembers the next suffix it hasn't tried yet, and the
+     * smaller suffixes that were freed since, so choosing a name is O(1)
+     * amortized.
+     *
+     * While the world applies moves in parallel, every call locks the
+     * index, so areas on different threads can report to it.
+     */
+    class GroupNames{
+        friend class Checkpoint;
+        friend class MemoryAccounting;
+
+        struct Entry{
+            GroupPointer group;
+            Area* area;
+        };
+        struct SuffixFamily{
+            int next;
+            std::set<int> freed;
+        };
+        /**
+         * What a name or a family was before the first change since undo
+         * recording started: if it was there, and what it was.
+         */
+        struct SavedEntry{
+            bool present;
+            Entry entry;
+        };
+        struct SavedFamily{
+            bool present;
+            SuffixFamily family;
+        };
+        std::unordered_map<std::string, Entry> entries;
+        std::unordered_map<std::string, SuffixFamily> families;
+        mutable std::mutex mutex;
+        bool concurrent;
+        bool recording;
+        std::unordered_map<std::string, SavedEntry> saved_entries;
+        std::unordered_map<std::string, SavedFamily> saved_families;
+
+        /**
+         * A private function that locks the index, if it is shared between
+         * threads.
+         * @return
+         * the lock , that unlocks the index when it is destroyed.
+         */
+        std::unique_lock<std::mutex> lock() const {
+            std::unique_lock<std::mutex> guard(mutex, std::defer_lock);
+            if (concurrent) {
+                guard.lock();
+            }
+            return guard;
+        }
+
+        /**
+         * A private version of contains that doesn't lock the index.
+         */
+        bool containsName(const std::string& group_name) const;
+
+        /**
+         * A private function that remembers what a name was, before its
+         * first change since undo recording started.
+         */
+        void saveEntry(const std::string& group_name);
+
+        /**
+         * A private function that remembers what a family was, before its
+         * first change since undo recording started.
+         */
+        void saveFamily(const std::string& base);
+
+    public:
+        /**
+         * Split a name of the form "<base>_<i>", when i is a number bigger
+         * than 1 (without leading zeros).
+         * @param name The name to split.
+         * @param base Set to the part before the last '_'.
+         * @param suffix Set to the number after the last '_'.
+         * @return true if the name has this form, false otherwise.
+         */
+        static bool splitSuffix(const std::string& name, std::string& base,
+                                int& suffix);
+
+        GroupNames();
+
+        /**
+         * Disable copy constructor
+         */
+        GroupNames(const GroupNames&) = delete;
+
+        /**
+         * Disable assignment operator
+         */
+        GroupNames& operator=(const GroupNames&) = delete;
+
+        ~GroupNames() = default;
+
+        /**
+         * Record that a group is in an area, under its current name.
+         * @param group The group.
+         * @param area The area the group is in, or nullptr if it's between
+         *  areas.
+         */
+        void place(const GroupPointer& group, Area* area);
+
+        /**
+         * Record that a group got out of its area. The name stays in use.
+         * @param group_name The name of the group.
+         */
+        void leave(const std::string& group_name);
+
+        /**
+         * Record that a name isn't used anymore.
+         * @param group_name The name that was freed.
+         */
+        void release(const std::string& group_name);
+
+        /**
+         * @param group_name The name to check.
+         * @return true if a living group has the given name.
+         */
+        bool contains(const std::string& group_name) const;
+
+        /**
+         * @param group_name The name of the group.
+         * @return The group with the given name, or nullptr if there is none.
+         */
+        GroupPointer getGroup(const std::string& group_name) const;
+
+        /**
+         * @param group_name The name of the group.
+         * @return The area the group is in, or nullptr if there is no such
+         * group or it isn't in an area.
+         */
+        Area* getArea(const std::string& group_name) const;
+
+        /**
+         * Choose the name for a group divided from the given group: the
+         * given name with "_i" added, when i is the smallest number bigger
+         * than 1 that makes a name no living group has.
+         * The name isn't taken until a group is placed with it.
+         * @param group_name The name of the divided group.
+         * @return The new name.
+         */
+        std::string splitName(const std::string& group_name);
+
+        /**
+         * Choose if every call locks the index. Only change it while no other
+         * thread uses the index.
+         * @param shared true while areas on different threads report to the
+         *  index.
+         */
+        void setConcurrent(bool shared);
+
+        /**
+         * Start remembering every name and family before it changes, so
+         * undo can put them all back. The first change of a name is the only
+         * one that is remembered, so it costs as much as the changes do.
+         */
+        void beginUndo();
+
+        /**
+         * Put back every name and family that changed since beginUndo, and
+         * stop remembering.
+         */
+        void undo();
+
+        /**
+         * Forget the changes since beginUndo, and stop remembering.
+         */
+        void endUndo();
+    };
+} // namespace mtm
+
+#endif //MTM4_GROUP_NAMES_H
@@ -0,0 +1,486 @@
+#ifndef MTM4_GROUP_RANKING_H
+#define MTM4_GROUP_RANKING_H
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Group.h"
+
+namespace mtm{
+
+    typedef std::shared_ptr<Group> GroupPointer;
+
+    /**
+     * Groups ordered from the strongest to the weakest, by the same power
+     * and name comparison as Group::operator> .
+     * Every group is ranked by the power and name it had when it was
+     * inserted, so after a fight, a trade or a unite changes a ranked group,
+     * it has to be refreshed.
+     * Insert, erase and refresh are O(log n), the strongest group is O(1).
+     */
+    class GroupRanking{
+        friend class MemoryAccounting;
+
+        struct Rank{
+            long long power;
+            std::string name;
+            GroupPointer group;
+        };
+        struct StrongerFirst{
+            bool operator()(const Rank& r1, const Rank& r2) const {
+                if (r1.power != r2.power) {
+                    return r1.power > r2.power ;
+                }
+                return r1.name > r2.name ;
+            }
+        };
+        typedef std::set<Rank, StrongerFirst> Ranks;
+        Ranks ranks;
+        std::unordered_map<const Group*, Ranks::iterator> handles;
+
+    public:
+        /**
+         * An iterator over the ranked groups, strongest first.
+         */
+        class const_iterator{
+            Ranks::const_iterator it;
+        public:
+            explicit const_iterator(Ranks::const_iterator it) :
+                    it(it) {}
+            const GroupPointer& operator*() const {
+                return it->group;
+            }
+            const GroupPointer* operator->() const {
+                return &(it->group);
+            }
+            /**
+             * @return The power and the name the group is ranked by.
+             */
+            long long getPower() const {
+                return it->power;
+            }
+            const std::string& getName() const {
+                return it->name;
+            }
+            const_iterator& operator++() {
+                ++it;
+                return *this;
+            }
+            bool operator==(const const_iterator& rhs) const {
+                return it == rhs.it;
+            }
+            bool operator!=(const const_iterator& rhs) const {
+                return it != rhs.it;
+            }
+        };
+
+        GroupRanking() : ranks(), handles() {}
+
+        /**
+         * Copy constructor. The copy ranks the same groups, by the power and
+         * name they were ranked by here.
+         */
+        GroupRanking(const GroupRanking& other) : ranks(), handles() {
+            for (Ranks::const_iterator it = other.ranks.begin();
+                 it != other.ranks.end(); ++it) {
+                handles[(it->group).get()] = ranks.insert(ranks.end(), *it);
+            }
+        }
+
+        GroupRanking& operator=(const GroupRanking&) = delete;
+
+        /**
+         * Rank a group by its current power and name. If the group is
+         * already ranked, its rank is refreshed.
+         * @param group The group to rank.
+         */
+        void insert(const GroupPointer& group) {
+            std::pair<std::unordered_map<const Group*,
+                    Ranks::iterator>::iterator, bool> handle =
+                    handles.insert(std::make_pair(group.get(), ranks.end()));
+            long long power = (*group).getPower();
+            if (!handle.second) {
+                Ranks::iterator& rank = (handle.first)->second;
+                //a group that kept its power and name keeps its rank.
+                if ((rank->power == power) &&
+                        (rank->name == (*group).getName())) {
+                    return ;
+                }
+                ranks.erase(rank);
+            }
+            Rank rank = { power, (*group).getName(), group };
+            (handle.first)->second = ranks.insert(rank).first;
+        }
+
+        /**
+         * Rank a group that is weaker than every ranked group, at the end of
+         * the ranking, in O(1). Building a ranking from groups that are
+         * already ordered, strongest first, doesn't compare them again.
+         * @param group The group to rank.
+         * @return false, without ranking the group, if it is ranked already
+         *  or a ranked group is weaker than it.
+         */
+        bool append(const GroupPointer& group) {
+            Rank rank = { (*group).getPower(), (*group).getName(), group };
+            if ((!ranks.empty() && !StrongerFirst()(*(ranks.rbegin()), rank))
+                    || (handles.count(group.get()) != 0)) {
+                return false;
+            }
+            handles[group.get()] = ranks.insert(ranks.end(), rank);
+            return true;
+        }
+
+        /**
+         * Make room for the given number of ranked groups.
+         */
+        void reserve(int count) {
+            handles.reserve(count);
+        }
+
+        /**
+         * Remove a group from the ranking. Does nothing if it isn't ranked.
+         * @param group The group to remove.
+         */
+        void erase(const GroupPointer& group) {
+            std::unordered_map<const Group*,
+                    Ranks::iterator>::iterator it =
+                    handles.find(group.get());
+            if (it == handles.end()) {
+                return ;
+            }
+            ranks.erase(it->second);
+            handles.erase(it);
+        }
+
+        /**
+         * Re-rank a group after its power or name changed. A group that
+         * became empty is removed from the ranking.
+         * @param group The group to refresh.
+         */
+        void refresh(const GroupPointer& group) {
+            if ((*group).getSize() == 0) {
+                erase(group);
+                return ;
+            }
+            insert(group);
+        }
+
+        /**
+         * @param group The group to look for.
+         * @return true if the group is ranked.
+         */
+        bool contains(const GroupPointer& group) const {
+            return handles.find(group.get()) != handles.end();
+        }
+
+        /**
+         * @return The strongest ranked group, or nullptr if there are none.
+         */
+        GroupPointer strongest() const {
+            if (ranks.empty()) {
+                return nullptr;
+            }
+            return ranks.begin()->group;
+        }
+
+        /**
+         * Remove all the groups from the ranking.
+         */
+        void clear() {
+            ranks.clear();
+            handles.clear();
+        }
+
+        int size() const {
+            return ranks.size();
+        }
+
+        bool empty() const {
+            return ranks.empty();
+        }
+
+        const_iterator begin() const {
+            return const_iterator(ranks.begin());
+        }
+
+        const_iterator end() const {
+            return const_iterator(ranks.end());
+        }
+    };
+
+    /**
+     * The clans of a world ordered by the strongest group of every clan, so
+     * the strongest groups of the world are found by merging the rankings
+     * of the clans, without ranking all the groups of the world again in
+     * one big ranking. Every clan of the world tells it when its ranking
+     * changed (Clan::rankIn), and the order of the clans only changes when
+     * the strongest group of a clan changes.
+     * While the world applies moves in parallel, the clans lock it before
+     * they change their rankings, so clans on different threads can report
+     * to it, like they report to the name index (GroupNames.h), and a trade
+     * on one thread can rank a group of a clan that moves on another.
+     */
+    class ClanLeaders{
+        friend class MemoryAccounting;
+
+        struct Leader{
+            long long power;
+            std::string name;
+            const GroupRanking* ranking;
+        };
+        struct StrongerFirst{
+            bool operator()(const Leader& l1, const Leader& l2) const {
+                if (l1.power != l2.power) {
+                    return l1.power > l2.power ;
+                }
+                if (l1.name != l2.name) {
+                    return l1.name > l2.name ;
+                }
+                //two clans only lead with the same group while a unite
+                //moves it, they are still two leaders.
+                return std::less<const GroupRanking*>()(l1.ranking,
+                                                        l2.ranking) ;
+            }
+        };
+        typedef std::set<Leader, StrongerFirst> Leaders;
+        Leaders leaders;
+        std::unordered_map<const GroupRanking*, Leaders::iterator> handles;
+        std::mutex mutex;
+        bool concurrent;
+
+        /**
+         * Where the merge of topGroups got to in the ranking of a clan, and
+         * if it is the strongest group of the clan, the clan after it.
+         */
+        struct Cursor{
+            GroupRanking::const_iterator group;
+            GroupRanking::const_iterator end;
+            Leaders::const_iterator next_clan;
+            bool leader;
+        };
+        struct WeakerCursor{
+            bool operator()(const Cursor& c1, const Cursor& c2) const {
+                if (c1.group.getPower() != c2.group.getPower()) {
+                    return c1.group.getPower() < c2.group.getPower() ;
+                }
+                return c1.group.getName() < c2.group.getName() ;
+            }
+        };
+
+        /**
+         * A private function that puts the cursor of the strongest group of
+         * a clan in the merge.
+         */
+        static void pushLeader(Leaders::const_iterator clan,
+                               std::vector<Cursor>& heap) {
+            Leaders::const_iterator next_clan = clan;
+            Cursor cursor = { (*(clan->ranking)).begin(),
+                              (*(clan->ranking)).end(), ++next_clan, true };
+            heap.push_back(cursor);
+            std::push_heap(heap.begin(), heap.end(), WeakerCursor());
+        }
+
+    public:
+        ClanLeaders() : leaders(), handles(), mutex(), concurrent(false) {}
+
+        ClanLeaders(const ClanLeaders&) = delete;
+        ClanLeaders& operator=(const ClanLeaders&) = delete;
+
+        /**
+         * Lock the leaders and the rankings of the clans, if they are shared
+         * between threads. Hold it while changing a ranking and calling
+         * update or erase.
+         * @return the lock , that unlocks the leaders when it is destroyed.
+         */
+        std::unique_lock<std::mutex> lock() {
+            std::unique_lock<std::mutex> guard(mutex, std::defer_lock);
+            if (concurrent) {
+                guard.lock();
+            }
+            return guard;
+        }
+
+        /**
+         * Order a clan (again) by the strongest group of its ranking. A clan
+         * with no ranked groups is taken out.
+         * @param ranking The ranking of the clan, that stays where it is
+         *  until the clan is erased.
+         */
+        void update(const GroupRanking& ranking) {
+            std::unordered_map<const GroupRanking*,
+                    Leaders::iterator>::iterator handle =
+                    handles.find(&ranking);
+            if (ranking.empty()) {
+                if (handle != handles.end()) {
+                    leaders.erase(handle->second);
+                    handles.erase(handle);
+                }
+                return ;
+            }
+            GroupRanking::const_iterator strongest = ranking.begin();
+            if (handle != handles.end()) {
+                const Leader& leader = *(handle->second);
+                if ((leader.power == strongest.getPower()) &&
+                        (leader.name == strongest.getName())) {
+                    return ;
+                }
+                leaders.erase(handle->second);
+            }
+            Leader leader = { strongest.getPower(), strongest.getName(),
+                              &ranking };
+            std::pair<Leaders::iterator, bool> inserted =
+                    leaders.insert(leader);
+            assert(inserted.second);
+            handles[&ranking] = inserted.first;
+        }
+
+        /**
+         * Take a clan out. Does nothing if it isn't there.
+         * @param ranking The ranking of the clan.
+         */
+        void erase(const GroupRanking& ranking) {
+            std::unordered_map<const GroupRanking*,
+                    Leaders::iterator>::iterator handle =
+                    handles.find(&ranking);
+            if (handle != handles.end()) {
+                leaders.erase(handle->second);
+                handles.erase(handle);
+            }
+        }
+
+        /**
+         * Choose if every change locks the leaders. Only change it while no
+         * other thread uses them.
+         * @param shared true while clans on different threads report to the
+         *  leaders.
+         */
+        void setConcurrent(bool shared) {
+            concurrent = shared;
+        }
+
+        /**
+         * Get the strongest groups of all the clans, by merging the rankings
+         * of the clans from the strongest clan. A clan joins the merge only
+         * after the strongest group of the clan before it was taken, so it
+         * costs O(k log k), whatever the amount of groups and clans is.
+         * @param k The amount of groups to get.
+         * @param groups Set to the groups, the strongest first.
+         */
+        void top(int k, std::vector<const Group*>& groups) const {
+            groups.clear();
+            std::vector<Cursor> heap;
+            if (leaders.empty() || (k <= 0)) {
+                return ;
+            }
+            pushLeader(leaders.begin(), heap);
+            while (!heap.empty() && ((int)groups.size() < k)) {
+                std::pop_heap(heap.begin(), heap.end(), WeakerCursor());
+                Cursor cursor = heap.back();
+                heap.pop_back();
+                groups.push_back((*(cursor.group)).get());
+                if (cursor.leader && (cursor.next_clan != leaders.end())) {
+                    pushLeader(cursor.next_clan, heap);
+                }
+                ++(cursor.group);
+                if (cursor.group != cursor.end) {
+                    cursor.leader = false;
+                    heap.push_back(cursor);
+                    std::push_heap(heap.begin(), heap.end(), WeakerCursor());
+                }
+            }
+        }
+    };
+
+    /**
+     * A GroupRanking for every clan that has ranked groups, by clan name.
+     * A clan whose last group was erased is dropped.
+     */
+    class ClanRankings{
+        friend class MemoryAccounting;
+
+        typedef std::unordered_map<std::string, GroupRanking> Rankings;
+        Rankings rankings;
+
+    public:
+        typedef Rankings::const_iterator const_iterator;
+
+        ClanRankings() : rankings() {}
+
+        /**
+         * Rank a group (again) under the given clan. A group that became
+         * empty is removed instead.
+         * @param group The group to rank.
+         * @param clan_name The clan the group is ranked under. It has to be
+         *  the clan the group was ranked under before, if it was.
+         */
+        void refresh(const GroupPointer& group, const std::string& clan_name) {
+            if ((*group).getSize() == 0) {
+                erase(group, clan_name);
+                return ;
+            }
+            rankings[clan_name].insert(group);
+        }
+
+        /**
+         * Rank a group under the given clan, after all the groups of the
+         * clan (GroupRanking::append).
+         * @return false if the group isn't weaker than them.
+         */
+        bool append(const GroupPointer& group, const std::string& clan_name) {
+            return rankings[clan_name].append(group);
+        }
+
+        /**
+         * Remove a group from the ranking of the given clan.
+         * @param group The group to remove.
+         * @param clan_name The clan the group was ranked under.
+         */
+        void erase(const GroupPointer& group, const std::string& clan_name) {
+            Rankings::iterator it = rankings.find(clan_name);
+            if (it == rankings.end()) {
+                return ;
+            }
+            (it->second).erase(group);
+            if ((it->second).empty()) {
+                rankings.erase(it);
+            }
+        }
+
+        /**
+         * @param clan_name The name of the clan.
+         * @return The ranking of the clan, or nullptr if no group of the
+         * clan is ranked.
+         */
+        const GroupRanking* find(const std::string& clan_name) const {
+            Rankings::const_iterator it = rankings.find(clan_name);
+            if (it == rankings.end()) {
+                return nullptr ;
+            }
+            return &(it->second);
+        }
+
+        void clear() {
+            rankings.clear();
+        }
+
+        /**
+         * @return An iterator over (clan name, ranking) pairs.
+         */
+        const_iterator begin() const {
+            return rankings.begin();
+        }
+
+        const_iterator end() const {
+            return rankings.end();
+        }
+    };
+} // namespace mtm
+
+#endif //MTM4_GROUP_RANKING_H
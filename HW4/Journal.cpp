@@ -0,0 +1,182 @@
+#include "Journal.h"
+#include "exceptions.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace mtm ;
+using std::string ;
+/**
+ * Journal.cpp , all functions are explained in Journal.h .
+ */
+
+static const char MAGIC[] = { 'W', 'J', 'N', 'L' };
+static const int MAGIC_SIZE = sizeof(MAGIC);
+static const int HEADER_SIZE = MAGIC_SIZE + 4 + 8;
+
+Journal::Journal(const string& path, long long generation, int sync_every,
+                 int sync_millis) :
+        file(-1), generation(generation), size(0), buffer(),
+        writer(buffer, true), sync_every(sync_every),
+        sync_millis(sync_millis), pending(0),
+        last_sync(std::chrono::steady_clock::now()), stats() {
+    //the header of the command log is in the header of the journal.
+    buffer.str(string());
+    stats.records = 0;
+    stats.syncs = 0;
+    stats.bytes = 0;
+    file = open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    struct stat status;
+    if ((file < 0) || (fstat(file, &status) != 0)) {
+        if (file >= 0) {
+            close(file);
+        }
+        throw JournalCantOpen();
+    }
+    string start = header(generation);
+    if (status.st_size < static_cast<off_t>(start.size())) {
+        //a new journal, or one that crashed before its header was synced.
+        if (ftruncate(file, 0) != 0) {
+            close(file);
+            throw JournalCantOpen();
+        }
+        append(start);
+        size = start.size();
+        return ;
+    }
+    string read(start.size(), '\0');
+    std::istringstream input;
+    if (pread(file, &read[0], read.size(), 0) !=
+            static_cast<ssize_t>(read.size())) {
+        close(file);
+        throw JournalCantOpen();
+    }
+    input.str(read);
+    try {
+        this->generation = readHeader(input);
+    } catch (const JournalBadFormat&) {
+        close(file);
+        throw ;
+    }
+    if (read != header(this->generation)) {
+        close(file);
+        throw JournalBadFormat();
+    }
+    size = status.st_size;
+}
+
+Journal::~Journal() {
+    try {
+        sync();
+    } catch (const JournalException&) {}
+    close(file);
+}
+
+string Journal::header(long long generation) {
+    string bytes(MAGIC, MAGIC_SIZE);
+    unsigned long long values[] = { VERSION,
+                                    static_cast<unsigned long long>(
+                                            generation) };
+    int sizes[] = { 4, 8 };
+    for (int value = 0; value < 2; value++) {
+        for (int i = 0; i < sizes[value]; i++) {
+            bytes += static_cast<char>((values[value] >> (8 * i)) & 0xff);
+        }
+    }
+    std::ostringstream log;
+    CommandWriter log_header(log, true);
+    return bytes + log.str();
+}
+
+void Journal::append(const string& bytes) {
+    size_t written = 0;
+    while (written < bytes.size()) {
+        ssize_t result = write(file, bytes.data() + written,
+                               bytes.size() - written);
+        if (result < 0) {
+            throw JournalCantWrite();
+        }
+        written += result;
+    }
+    if (fdatasync(file) != 0) {
+        throw JournalCantWrite();
+    }
+}
+
+void Journal::record(const Command& command) {
+    writer.write(command);
+    stats.records++;
+    pending++;
+    if ((pending >= sync_every) ||
+            (std::chrono::steady_clock::now() - last_sync >=
+             std::chrono::milliseconds(sync_millis))) {
+        sync();
+    }
+}
+
+void Journal::sync() {
+    if (pending == 0) {
+        return ;
+    }
+    string bytes = buffer.str();
+    try {
+        append(bytes);
+    } catch (const JournalCantWrite&) {
+        //drop what was written of the commands, they are kept for the next
+        //sync.
+        if (ftruncate(file, size) != 0) {}
+        throw ;
+    }
+    buffer.str(string());
+    pending = 0;
+    size += bytes.size();
+    stats.syncs++;
+    stats.bytes += bytes.size();
+    last_sync = std::chrono::steady_clock::now();
+}
+
+void Journal::restart() {
+    sync();
+    if (ftruncate(file, 0) != 0) {
+        throw JournalCantWrite();
+    }
+    generation++;
+    string start = header(generation);
+    append(start);
+    size = start.size();
+}
+
+JournalPosition Journal::getPosition() const {
+    JournalPosition position = { generation, size };
+    return position;
+}
+
+JournalStats Journal::getStats() const {
+    return stats;
+}
+
+long long Journal::headerSize() {
+    return header(0).size();
+}
+
+long long Journal::readHeader(std::istream& input) {
+    unsigned char bytes[HEADER_SIZE];
+    if (!input.read(reinterpret_cast<char*>(bytes), HEADER_SIZE) ||
+            (std::memcmp(bytes, MAGIC, MAGIC_SIZE) != 0)) {
+        throw JournalBadFormat();
+    }
+    unsigned long long values[2] = { 0, 0 };
+    int offset = MAGIC_SIZE;
+    int sizes[] = { 4, 8 };
+    for (int value = 0; value < 2; value++) {
+        for (int i = 0; i < sizes[value]; i++, offset++) {
+            values[value] |= static_cast<unsigned long long>(bytes[offset])
+                    << (8 * i);
+        }
+    }
+    if (values[0] != VERSION) {
+        throw JournalBadFormat();
+    }
+    return static_cast<long long>(values[1]);
+}
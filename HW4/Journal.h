@@ -0,0 +1,141 @@
+#ifndef MTM4_JOURNAL_H
+#define MTM4_JOURNAL_H
+
+#include <chrono>
+#include <istream>
+#include <sstream>
+#include <string>
+#include "CommandLog.h"
+
+namespace mtm{
+
+    /**
+     * A place in a journal: the generation of the journal, and the number of
+     * bytes from the start of the file.
+     */
+    struct JournalPosition{
+        long long generation;
+        long long offset;
+    };
+
+    /**
+     * How many commands a journal wrote since it was opened, in how many
+     * syncs, and how many bytes.
+     */
+    struct JournalStats{
+        long long records;
+        long long syncs;
+        long long bytes;
+    };
+
+    /**
+     * An append only file of the commands that changed a world, so after a
+     * crash the world can be built again from its last checkpoint and the
+     * commands that came after it (World::recover).
+     *
+     * The file has a header ("WJNL", a version and a generation) and then a
+     * binary command log (CommandLog.h). Every checkpoint starts a new
+     * generation: the file is cut back to its header, and the checkpoint
+     * keeps the position in the old generation it got to.
+     *
+     * Commands are kept in a buffer, and written with one sync for the whole
+     * group of them: once sync_every commands are waiting, or once a command
+     * comes sync_millis after the last sync. Only the commands that weren't
+     * synced yet can be lost in a crash. A crash in the middle of a write
+     * leaves a cut command at the end of the file, that recover drops.
+     */
+    class Journal{
+        int file;
+        long long generation;
+        long long size;
+        std::ostringstream buffer;
+        CommandWriter writer;
+        int sync_every;
+        int sync_millis;
+        int pending;
+        std::chrono::steady_clock::time_point last_sync;
+        JournalStats stats;
+
+        /**
+         * A private function that returns the first bytes of a journal of a
+         * generation: the header and the header of the command log.
+         */
+        static std::string header(long long generation);
+
+        /**
+         * A private function that writes bytes at the end of the file, and
+         * syncs it.
+         * @throws JournalCantWrite If the bytes weren't all written.
+         */
+        void append(const std::string& bytes);
+
+    public:
+        static const unsigned int VERSION = 1;
+
+        /**
+         * Open a journal to add commands at its end, or create it.
+         * @param path The file of the journal.
+         * @param generation The generation of the journal if it is created.
+         * @param sync_every The number of commands to sync together.
+         * @param sync_millis The most time between syncs, while commands
+         *  are added.
+         * @throws JournalCantOpen If the file can't be opened.
+         * @throws JournalBadFormat If the file isn't a journal.
+         */
+        Journal(const std::string& path, long long generation, int sync_every,
+                int sync_millis);
+
+        /**
+         * Syncs the commands that are left, if it can.
+         */
+        ~Journal();
+
+        Journal(const Journal&) = delete;
+        Journal& operator=(const Journal&) = delete;
+
+        /**
+         * Add a command to the journal, and sync if it is time to.
+         * @throws JournalCantWrite If a sync failed.
+         */
+        void record(const Command& command);
+
+        /**
+         * Write and sync every command that was added.
+         * @throws JournalCantWrite If the commands weren't all written. The
+         *  file is cut back to the last sync, and the commands are kept.
+         */
+        void sync();
+
+        /**
+         * Start the next generation: sync, then cut the file back to the
+         * header of the next generation.
+         * @throws JournalCantWrite If the file couldn't be cut or written.
+         */
+        void restart();
+
+        /**
+         * @return The generation, and the end of the commands that were
+         *  synced.
+         */
+        JournalPosition getPosition() const;
+
+        JournalStats getStats() const;
+
+        /**
+         * @return The size of an empty journal.
+         */
+        static long long headerSize();
+
+        /**
+         * Read the header of a journal, so the command log comes next in
+         * the stream.
+         * @param input The journal, at its start.
+         * @return The generation of the journal.
+         * @throws JournalBadFormat If the stream doesn't start with the
+         *  header of a journal.
+         */
+        static long long readHeader(std::istream& input);
+    };
+} // namespace mtm
+
+#endif //MTM4_JOURNAL_H
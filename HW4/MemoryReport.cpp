@@ -0,0 +1,267 @@
+#include "MemoryReport.h"
+#include "World.h"
+#include <functional>
+#include <type_traits>
+
+using namespace mtm ;
+using std::string ;
+/**
+ * MemoryReport.cpp , all functions are explained in MemoryReport.h .
+ */
+
+namespace {
+    const long long POINTER = sizeof(void*);
+    //the color of a tree node (padded to a pointer), its parent and its
+    //children.
+    const long long TREE_LINKS = sizeof(void*) * 4;
+    //the vtable pointer, the pointer to the group and the 2 counts.
+    const long long CONTROL_BLOCK = sizeof(void*) * 2 + sizeof(int) * 2;
+
+    long long stringBytes(const string& s) {
+        //a short string keeps its characters inside itself.
+        const char* data = s.data();
+        const char* inside = reinterpret_cast<const char*>(&s);
+        std::less<const char*> before;
+        if (!before(data, inside) && before(data, inside + sizeof(s))) {
+            return 0;
+        }
+        return s.capacity() + 1;
+    }
+
+    template<typename Type>
+    long long vectorBytes(const std::vector<Type>& vector) {
+        return static_cast<long long>(vector.capacity()) * sizeof(Type);
+    }
+
+    template<typename Tree>
+    long long treeBytes(const Tree& tree) {
+        return static_cast<long long>(tree.size()) *
+               (sizeof(typename Tree::value_type) + TREE_LINKS);
+    }
+
+    template<typename Table>
+    long long tableBytes(const Table& table) {
+        long long node = sizeof(typename Table::value_type) + POINTER;
+        if (std::is_same<typename Table::key_type, string>::value) {
+            node += sizeof(std::size_t);
+        }
+        //a table that never grew uses the single bucket inside itself.
+        long long buckets = table.bucket_count() > 1 ?
+                            table.bucket_count() * POINTER : 0;
+        return static_cast<long long>(table.size()) * node + buckets;
+    }
+
+    template<typename Map>
+    long long keyBytes(const Map& entries) {
+        long long bytes = 0;
+        for (typename Map::const_iterator it = entries.begin();
+             it != entries.end(); ++it) {
+            bytes += stringBytes(it->first);
+        }
+        return bytes;
+    }
+
+    template<typename Strings>
+    long long elementBytes(const Strings& strings) {
+        long long bytes = 0;
+        for (typename Strings::const_iterator it = strings.begin();
+             it != strings.end(); ++it) {
+            bytes += stringBytes(*it);
+        }
+        return bytes;
+    }
+
+    void printUsage(std::ostream& os, const string& title,
+                    const MemoryUsage& usage) {
+        os << title << ": " << usage.total() << " bytes (groups "
+           << usage.groups << ", control blocks " << usage.control_blocks
+           << ", set nodes " << usage.set_nodes << ", strings "
+           << usage.strings << ", map nodes " << usage.map_nodes
+           << ", vectors " << usage.vectors << ")" << std::endl;
+    }
+}
+
+std::ostream& mtm::operator<<(std::ostream& os, const MemoryReport& report) {
+    printUsage(os, "total", report.total);
+    printUsage(os, "world", report.world);
+    for (std::map<string, MemoryUsage>::const_iterator it =
+            report.clans.begin(); it != report.clans.end(); ++it) {
+        printUsage(os, "clan " + it->first, it->second);
+    }
+    for (std::map<string, MemoryUsage>::const_iterator it =
+            report.areas.begin(); it != report.areas.end(); ++it) {
+        printUsage(os, "area " + it->first, it->second);
+    }
+    return os;
+}
+
+void MemoryAccounting::measureRanking(const GroupRanking& ranking,
+                                      MemoryUsage& usage) {
+    usage.map_nodes += treeBytes(ranking.ranks) + tableBytes(ranking.handles);
+    for (GroupRanking::Ranks::const_iterator it = ranking.ranks.begin();
+         it != ranking.ranks.end(); ++it) {
+        usage.strings += stringBytes(it->name);
+    }
+}
+
+void MemoryAccounting::measureRankings(const ClanRankings& rankings,
+                                       MemoryUsage& usage) {
+    usage.map_nodes += tableBytes(rankings.rankings);
+    usage.strings += keyBytes(rankings.rankings);
+    for (ClanRankings::const_iterator it = rankings.begin();
+         it != rankings.end(); ++it) {
+        measureRanking(it->second, usage);
+    }
+}
+
+void MemoryAccounting::measureClan(const Clan& clan, MemoryUsage& usage) {
+    usage.strings += stringBytes(clan.clan_name);
+    for (unsigned int i = 0; i < clan.groups.size(); i++) {
+        const Group& group = *(clan.groups[i]);
+        usage.groups += sizeof(Group);
+        usage.control_blocks += CONTROL_BLOCK;
+        usage.strings += stringBytes(group.getName()) +
+                         stringBytes(group.getClan());
+    }
+    usage.vectors += vectorBytes(clan.groups) + vectorBytes(clan.slot_names);
+    usage.strings += elementBytes(clan.slot_names);
+    usage.map_nodes += tableBytes(clan.members) +
+                       tableBytes(clan.friends_index);
+    usage.strings += keyBytes(clan.members) + elementBytes(clan.friends_index);
+    usage.set_nodes += clan.friends.nodeBytes();
+    usage.strings += elementBytes(clan.friends);
+    measureRanking(clan.ranking, usage);
+    //what the clan saved for the undo of a transaction.
+    usage.map_nodes += tableBytes(clan.saved_slots) +
+                       tableBytes(clan.saved_members);
+    usage.strings += keyBytes(clan.saved_members);
+    for (std::unordered_map<int, std::pair<GroupPointer, string> >::
+                 const_iterator it = clan.saved_slots.begin();
+         it != clan.saved_slots.end(); ++it) {
+        usage.strings += stringBytes(it->second.second);
+    }
+}
+
+void MemoryAccounting::measureArea(const Area& area, MemoryUsage& usage) {
+    usage.strings += stringBytes(area.area_name);
+    usage.set_nodes += area.reachable_areas.nodeBytes();
+    usage.strings += elementBytes(area.reachable_areas);
+    usage.vectors += vectorBytes(area.groups) + vectorBytes(area.slot_names) +
+                     vectorBytes(area.slot_stats);
+    usage.strings += elementBytes(area.slot_names);
+    for (unsigned int i = 0; i < area.slot_stats.size(); i++) {
+        usage.strings += stringBytes(area.slot_stats[i].clan);
+    }
+    usage.map_nodes += tableBytes(area.group_slots) +
+                       tableBytes(area.stats.population);
+    usage.strings += keyBytes(area.group_slots) +
+                     keyBytes(area.stats.population);
+}
+
+void MemoryAccounting::measureWorld(const World& world, MemoryUsage& usage) {
+    const GroupNames& names = world.group_names;
+    usage.map_nodes += tableBytes(names.entries) + tableBytes(names.families) +
+                       tableBytes(names.saved_entries) +
+                       tableBytes(names.saved_families);
+    usage.strings += keyBytes(names.entries) + keyBytes(names.families) +
+                     keyBytes(names.saved_entries) +
+                     keyBytes(names.saved_families);
+    for (std::unordered_map<string, GroupNames::SuffixFamily>::const_iterator
+                 it = names.families.begin(); it != names.families.end();
+         ++it) {
+        usage.map_nodes += treeBytes(it->second.freed);
+    }
+    const ClanLeaders& leaders = world.clan_leaders;
+    usage.map_nodes += treeBytes(leaders.leaders) +
+                       tableBytes(leaders.handles);
+    for (ClanLeaders::Leaders::const_iterator it = leaders.leaders.begin();
+         it != leaders.leaders.end(); ++it) {
+        usage.strings += stringBytes(it->name);
+    }
+    usage.map_nodes += tableBytes(world.used_clan_names);
+    usage.strings += elementBytes(world.used_clan_names);
+    const ReachabilityIndex& reachability = world.reachability;
+    usage.vectors += vectorBytes(reachability.representatives) +
+                     vectorBytes(reachability.representative_areas) +
+                     vectorBytes(reachability.reaches) +
+                     vectorBytes(reachability.reached_by) +
+                     vectorBytes(reachability.roads) +
+                     vectorBytes(reachability.roads_into);
+    for (unsigned int i = 0; i < reachability.reaches.size(); i++) {
+        usage.vectors += vectorBytes(reachability.reaches[i]) +
+                         vectorBytes(reachability.reached_by[i]) +
+                         vectorBytes(reachability.roads[i]) +
+                         vectorBytes(reachability.roads_into[i]);
+    }
+    usage.map_nodes += tableBytes(reachability.next_hops);
+    for (std::unordered_map<int, std::vector<int> >::const_iterator it =
+            reachability.next_hops.begin();
+         it != reachability.next_hops.end(); ++it) {
+        usage.vectors += vectorBytes(it->second);
+    }
+    usage.vectors += vectorBytes(world.areas_by_id) +
+                     vectorBytes(world.dirty_areas) +
+                     vectorBytes(world.published_groups);
+    for (unsigned int i = 0; i < world.published_groups.size(); i++) {
+        const std::vector<PublishedGroup>& published =
+                world.published_groups[i];
+        usage.vectors += vectorBytes(published);
+        for (unsigned int j = 0; j < published.size(); j++) {
+            usage.strings += stringBytes(published[j].name) +
+                             stringBytes(published[j].clan);
+        }
+    }
+    usage.map_nodes += tableBytes(world.dirty_clans);
+    usage.strings += elementBytes(world.dirty_clans);
+}
+
+MemoryReport MemoryAccounting::measure(const World& world) {
+    MemoryReport report;
+    for (map<string, Clan>::const_iterator it = world.clan_map.begin();
+         it != world.clan_map.end(); ++it) {
+        MemoryUsage& usage = report.clans[it->first];
+        //the node of the clan in the world.
+        usage.map_nodes += sizeof(std::pair<const string, Clan>) + TREE_LINKS;
+        usage.strings += stringBytes(it->first);
+        measureClan(it->second, usage);
+        report.total += usage;
+    }
+    for (map<string, AreaSlot>::const_iterator it = world.areas_map.begin();
+         it != world.areas_map.end(); ++it) {
+        MemoryUsage& usage = report.areas[it->first];
+        const AreaSlot& slot = it->second;
+        //the node of the area in the world, and the area in its deque.
+        usage.map_nodes += sizeof(std::pair<const string, AreaSlot>) +
+                           TREE_LINKS;
+        usage.strings += stringBytes(it->first);
+        switch (slot.type) {
+            case PLAIN : {
+                const Plain& plain = world.plains[slot.index];
+                usage.vectors += sizeof(Plain);
+                measureArea(plain, usage);
+                measureRankings(plain.clan_rankings, usage);
+                break ;
+            }
+            case MOUNTAIN : {
+                const Mountain& mountain = world.mountains[slot.index];
+                usage.vectors += sizeof(Mountain);
+                measureArea(mountain, usage);
+                measureRankings(mountain.clan_rankings, usage);
+                measureRanking(mountain.all_rankings, usage);
+                break ;
+            }
+            case RIVER : {
+                const River& river = world.rivers[slot.index];
+                usage.vectors += sizeof(River);
+                measureArea(river, usage);
+                measureRankings(river.tool_surplus, usage);
+                measureRankings(river.food_surplus, usage);
+                break ;
+            }
+        }
+        report.total += usage;
+    }
+    measureWorld(world, report.world);
+    report.total += report.world;
+    return report;
+}
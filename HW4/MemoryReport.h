@@ -0,0 +1,140 @@
+#ifndef MTM4_MEMORY_REPORT_H
+#define MTM4_MEMORY_REPORT_H
+
+#include <map>
+#include <ostream>
+#include <string>
+
+namespace mtm{
+
+    class World;
+    class Clan;
+    class Area;
+    class GroupRanking;
+    class ClanRankings;
+
+    /**
+     * The bytes a part of the world takes, by what takes them:
+     *  - groups - the Group objects.
+     *  - control_blocks - the control blocks of the shared pointers to the
+     *    groups.
+     *  - set_nodes - the nodes of the MtmSets (friends and roads).
+     *  - strings - the heap buffers of strings too long to fit inside the
+     *    string itself.
+     *  - map_nodes - the nodes of maps, sets and hash tables, and the bucket
+     *    arrays of the hash tables.
+     *  - vectors - the buffers of vectors, and the areas themselves (in the
+     *    deques of the world).
+     */
+    struct MemoryUsage{
+        long long groups;
+        long long control_blocks;
+        long long set_nodes;
+        long long strings;
+        long long map_nodes;
+        long long vectors;
+
+        MemoryUsage() : groups(0), control_blocks(0), set_nodes(0),
+                        strings(0), map_nodes(0), vectors(0) {}
+
+        /**
+         * @return All the bytes.
+         */
+        long long total() const {
+            return groups + control_blocks + set_nodes + strings + map_nodes +
+                   vectors;
+        }
+
+        MemoryUsage& operator+=(const MemoryUsage& other) {
+            groups += other.groups;
+            control_blocks += other.control_blocks;
+            set_nodes += other.set_nodes;
+            strings += other.strings;
+            map_nodes += other.map_nodes;
+            vectors += other.vectors;
+            return *this;
+        }
+    };
+
+    /**
+     * The memory a world takes (World::memoryReport):
+     *  - clans - every clan by name: the clan and its entry in the world,
+     *    its groups, its friends and the ranking of its groups.
+     *  - areas - every area by name: the area and its entry in the world,
+     *    its roads, the slots of its groups, its stats and its rankings.
+     *    The groups themselves are counted in their clans.
+     *  - world - the indexes of the whole world: the group names, the used
+     *    clan names, the leaders of the clans, the roads between the areas
+     *    and what the last snapshot published.
+     *  - total - all of the above.
+     * The snapshots, the journal, the scheduled events and an open
+     * transaction aren't counted.
+     */
+    struct MemoryReport{
+        std::map<std::string, MemoryUsage> clans;
+        std::map<std::string, MemoryUsage> areas;
+        MemoryUsage world;
+        MemoryUsage total;
+    };
+
+    /**
+     * Print a memory report: a line for the total, the world, every clan
+     * and every area, like:
+     *      clan Stark: 1234 bytes (groups 160, control blocks 48, ...)
+     */
+    std::ostream& operator<<(std::ostream& os, const MemoryReport& report);
+
+    /**
+     * Measures the memory of a world by walking it.
+     *
+     * Vectors are counted by their capacity and strings by their heap
+     * buffer, which is exact. The containers of the standard library don't
+     * say how big their nodes are, so a node is counted as its value and
+     * the pointers the library (libstdc++) keeps with it: a tree node has a
+     * color and 3 pointers, a hash node a next pointer and, for string keys,
+     * the cached hash, and a bucket is a pointer. A group is held by a
+     * shared pointer made from new, so its control block is its own
+     * allocation of a vtable pointer, a pointer to the group and 2 counts.
+     * The headers malloc keeps with every allocation aren't counted.
+     */
+    class MemoryAccounting{
+        /**
+         * A private function that adds a clan to its usage.
+         */
+        static void measureClan(const Clan& clan, MemoryUsage& usage);
+
+        /**
+         * A private function that adds what every area type has to the
+         * usage of an area.
+         */
+        static void measureArea(const Area& area, MemoryUsage& usage);
+
+        /**
+         * A private function that adds a ranking of groups to a usage.
+         */
+        static void measureRanking(const GroupRanking& ranking,
+                                   MemoryUsage& usage);
+
+        /**
+         * A private function that adds the rankings of the clans of an area
+         * to its usage.
+         */
+        static void measureRankings(const ClanRankings& rankings,
+                                    MemoryUsage& usage);
+
+        /**
+         * A private function that adds the indexes of the whole world to
+         * its usage.
+         */
+        static void measureWorld(const World& world, MemoryUsage& usage);
+
+    public:
+        /**
+         * Measure a world.
+         * @return Its memory, by clan, by area and for the whole world.
+         */
+        static MemoryReport measure(const World& world);
+    };
+} // namespace mtm
+
+#endif //MTM4_MEMORY_REPORT_H
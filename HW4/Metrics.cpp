@@ -0,0 +1,252 @@
+#include "Metrics.h"
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <unordered_set>
+
+using namespace mtm ;
+/**
+ * Metrics.cpp , all functions are explained in Metrics.h .
+ */
+
+namespace {
+    /**
+     * What is printed for a counter: the metric it is a label of, the help
+     * of the metric, and the label.
+     */
+    struct MetricInfo{
+        const char* name;
+        const char* help;
+        const char* label;
+    };
+
+    /**
+     * The counters in the order of Metric. The labels of a metric are next
+     * to each other.
+     */
+    const MetricInfo METRIC_INFO[METRIC_COUNT] = {
+        { "mtm_fights_total", "Fights between groups, by the result for the "
+          "group that arrived.", "result=\"won\"" },
+        { "mtm_fights_total", "", "result=\"lost\"" },
+        { "mtm_fights_total", "", "result=\"drawn\"" },
+        { "mtm_trades_total", "Trades between groups.", nullptr },
+        { "mtm_group_unites_total", "Groups that united into another group.",
+          nullptr },
+        { "mtm_group_divides_total", "Groups that divided in two.", nullptr },
+        { "mtm_ruler_changes_total", "Changes of the ruler of a mountain.",
+          nullptr },
+        { "mtm_set_operations_total", "Inserts, erases and membership checks "
+          "of MtmSet.", nullptr },
+        { "mtm_set_node_allocations_total", "Nodes allocated by MtmSet.",
+          nullptr },
+        { "mtm_area_arrivals_total", "Groups that arrived to an area, by the "
+          "type of the area.", "area=\"plain\"" },
+        { "mtm_area_arrivals_total", "", "area=\"mountain\"" },
+        { "mtm_area_arrivals_total", "", "area=\"river\"" },
+        { "mtm_world_calls_total", "Public calls of the world, the throwing "
+          "and the try versions together.", "call=\"addClan\"" },
+        { "mtm_world_calls_total", "", "call=\"addArea\"" },
+        { "mtm_world_calls_total", "", "call=\"addGroup\"" },
+        { "mtm_world_calls_total", "", "call=\"makeReachable\"" },
+        { "mtm_world_calls_total", "", "call=\"moveGroup\"" },
+        { "mtm_world_calls_total", "", "call=\"moveGroupVia\"" },
+        { "mtm_world_calls_total", "", "call=\"makeFriends\"" },
+        { "mtm_world_calls_total", "", "call=\"uniteClans\"" },
+        { "mtm_world_calls_total", "", "call=\"canReach\"" },
+        { "mtm_world_calls_total", "", "call=\"apply\"" },
+        { "mtm_world_calls_total", "", "call=\"applyBatch\"" },
+        { "mtm_world_calls_total", "", "call=\"applyBatchConcurrently\"" },
+        { "mtm_world_calls_total", "", "call=\"schedule\"" },
+        { "mtm_world_calls_total", "", "call=\"advanceTo\"" },
+        { "mtm_world_calls_total", "", "call=\"getRulerChanges\"" },
+        { "mtm_world_calls_total", "", "call=\"areaStats\"" },
+        { "mtm_world_calls_total", "", "call=\"printGroup\"" },
+        { "mtm_world_calls_total", "", "call=\"printClan\"" },
+        { "mtm_world_calls_total", "", "call=\"topGroups\"" },
+        { "mtm_world_calls_total", "", "call=\"topGroupsOfClan\"" },
+        { "mtm_world_exceptions_total", "Exceptions thrown by the world, by "
+          "type.", "type=\"WorldInvalidArgument\"" },
+        { "mtm_world_exceptions_total", "", "type=\"WorldGroupNameIsTaken\"" },
+        { "mtm_world_exceptions_total", "", "type=\"WorldClanNameIsTaken\"" },
+        { "mtm_world_exceptions_total", "", "type=\"WorldAreaNameIsTaken\"" },
+        { "mtm_world_exceptions_total", "", "type=\"WorldGroupNotFound\"" },
+        { "mtm_world_exceptions_total", "", "type=\"WorldClanNotFound\"" },
+        { "mtm_world_exceptions_total", "", "type=\"WorldAreaNotFound\"" },
+        { "mtm_world_exceptions_total", "",
+          "type=\"WorldGroupAlreadyInArea\"" },
+        { "mtm_world_exceptions_total", "", "type=\"WorldAreaNotReachable\"" },
+        { "mtm_world_exceptions_total", "", "type=\"ClanCantUnite\"" },
+        { "mtm_world_exceptions_total", "",
+          "type=\"WorldTransactionActive\"" },
+    };
+
+    /**
+     * @return The histogram a counter is a label of, in dump.
+     */
+    const char* latencyName(int metric) {
+        return metric < METRIC_CALL_ADD_CLAN ? "mtm_area_arrival_seconds" :
+               "mtm_world_call_seconds";
+    }
+}
+
+struct Metrics::Registry{
+    std::mutex mutex;
+    std::unordered_set<const ThreadCounters*> threads;
+    long long ended[METRIC_COUNT];
+    long long ended_latencies[LATENCY_COUNT][LATENCY_BUCKETS];
+    long long ended_latency_sums[LATENCY_COUNT];
+};
+
+Metrics::Registry& Metrics::registry() {
+    static Registry instance;
+    return instance;
+}
+
+long long Metrics::total(Registry& counters, int metric) {
+    long long sum = counters.ended[metric];
+    for (std::unordered_set<const ThreadCounters*>::const_iterator it =
+            counters.threads.begin(); it != counters.threads.end(); ++it) {
+        sum += (**it).values[metric].load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+long long Metrics::totalLatencies(Registry& counters, int latency,
+                                  long long buckets[LATENCY_BUCKETS]) {
+    long long sum = counters.ended_latency_sums[latency];
+    for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        buckets[bucket] = counters.ended_latencies[latency][bucket];
+    }
+    for (std::unordered_set<const ThreadCounters*>::const_iterator it =
+            counters.threads.begin(); it != counters.threads.end(); ++it) {
+        const ThreadCounters& thread = **it;
+        sum += thread.latency_sums[latency].load(std::memory_order_relaxed);
+        for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+            buckets[bucket] += thread.latencies[latency][bucket].load(
+                    std::memory_order_relaxed);
+        }
+    }
+    return sum;
+}
+
+Metrics::ThreadCounters::ThreadCounters() {
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        values[i].store(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < LATENCY_COUNT; i++) {
+        for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+            latencies[i][bucket].store(0, std::memory_order_relaxed);
+        }
+        latency_sums[i].store(0, std::memory_order_relaxed);
+    }
+    Registry& counters = registry();
+    std::lock_guard<std::mutex> guard(counters.mutex);
+    counters.threads.insert(this);
+}
+
+Metrics::ThreadCounters::~ThreadCounters() {
+    Registry& counters = registry();
+    std::lock_guard<std::mutex> guard(counters.mutex);
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        counters.ended[i] += values[i].load(std::memory_order_relaxed);
+    }
+    for (int i = 0; i < LATENCY_COUNT; i++) {
+        for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+            counters.ended_latencies[i][bucket] +=
+                    latencies[i][bucket].load(std::memory_order_relaxed);
+        }
+        counters.ended_latency_sums[i] +=
+                latency_sums[i].load(std::memory_order_relaxed);
+    }
+    counters.threads.erase(this);
+}
+
+long long Metrics::get(Metric metric) {
+    Registry& counters = registry();
+    std::lock_guard<std::mutex> guard(counters.mutex);
+    return total(counters, metric);
+}
+
+long long Metrics::bucketLimit(int bucket) {
+    if (bucket < 8) {
+        return bucket;
+    }
+    int power = bucket / 8 + 2;
+    return ((9LL + bucket % 8) << (power - 3)) - 1;
+}
+
+long long Metrics::percentile(Metric metric, double quantile) {
+    long long buckets[LATENCY_BUCKETS];
+    Registry& counters = registry();
+    {
+        std::lock_guard<std::mutex> guard(counters.mutex);
+        totalLatencies(counters, metric - LATENCY_FIRST, buckets);
+    }
+    long long count = 0;
+    for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        count += buckets[bucket];
+    }
+    if (count == 0) {
+        return 0;
+    }
+    //the first bucket that the latencies up to it are at least the quantile.
+    long long rank = static_cast<long long>(std::ceil(quantile * count));
+    long long seen = 0;
+    for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        seen += buckets[bucket];
+        if ((seen >= rank) && (seen > 0)) {
+            return bucketLimit(bucket);
+        }
+    }
+    return bucketLimit(LATENCY_BUCKETS - 1);
+}
+
+void Metrics::dump(std::ostream& os) {
+#ifdef MTM_NO_METRICS
+    os << "# the metrics were compiled out (MTM_NO_METRICS)" << std::endl;
+#endif
+    Registry& counters = registry();
+    std::lock_guard<std::mutex> guard(counters.mutex);
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        const MetricInfo& info = METRIC_INFO[i];
+        if ((i == 0) ||
+                (std::strcmp(METRIC_INFO[i - 1].name, info.name) != 0)) {
+            os << "# HELP " << info.name << " " << info.help << std::endl
+               << "# TYPE " << info.name << " counter" << std::endl;
+        }
+        os << info.name;
+        if (info.label != nullptr) {
+            os << "{" << info.label << "}";
+        }
+        os << " " << total(counters, i) << std::endl;
+    }
+    long long buckets[LATENCY_BUCKETS];
+    for (int i = LATENCY_FIRST; i < LATENCY_FIRST + LATENCY_COUNT; i++) {
+        const char* name = latencyName(i);
+        if ((i == LATENCY_FIRST) ||
+                (std::strcmp(latencyName(i - 1), name) != 0)) {
+            os << "# HELP " << name << " How long "
+               << (i < METRIC_CALL_ADD_CLAN ? "the arrivals to an area"
+                                            : "the calls of the world")
+               << " took." << std::endl
+               << "# TYPE " << name << " histogram" << std::endl;
+        }
+        long long sum = totalLatencies(counters, i - LATENCY_FIRST, buckets);
+        long long count = 0;
+        for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+            if (buckets[bucket] == 0) {
+                continue ;
+            }
+            count += buckets[bucket];
+            os << name << "_bucket{" << METRIC_INFO[i].label << ",le=\""
+               << bucketLimit(bucket) * 1e-9 << "\"} " << count
+               << std::endl;
+        }
+        os << name << "_bucket{" << METRIC_INFO[i].label << ",le=\"+Inf\"} "
+           << count << std::endl
+           << name << "_sum{" << METRIC_INFO[i].label << "} " << sum * 1e-9
+           << std::endl
+           << name << "_count{" << METRIC_INFO[i].label << "} " << count
+           << std::endl;
+    }
+}
@@ -0,0 +1,269 @@
+#ifndef MTM4_METRICS_H
+#define MTM4_METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+namespace mtm{
+
+    /**
+     * The counters the simulation keeps (Metrics), a counter for every
+     * label of a metric.
+     */
+    enum Metric{
+        METRIC_FIGHTS_WON,
+        METRIC_FIGHTS_LOST,
+        METRIC_FIGHTS_DRAWN,
+        METRIC_TRADES,
+        METRIC_GROUP_UNITES,
+        METRIC_GROUP_DIVIDES,
+        METRIC_RULER_CHANGES,
+        METRIC_SET_OPERATIONS,
+        METRIC_SET_NODE_ALLOCATIONS,
+        METRIC_PLAIN_ARRIVALS,
+        METRIC_MOUNTAIN_ARRIVALS,
+        METRIC_RIVER_ARRIVALS,
+        //the public calls of the world, the throwing function and its try
+        //version are counted as one.
+        METRIC_CALL_ADD_CLAN,
+        METRIC_CALL_ADD_AREA,
+        METRIC_CALL_ADD_GROUP,
+        METRIC_CALL_MAKE_REACHABLE,
+        METRIC_CALL_MOVE_GROUP,
+        METRIC_CALL_MOVE_GROUP_VIA,
+        METRIC_CALL_MAKE_FRIENDS,
+        METRIC_CALL_UNITE_CLANS,
+        METRIC_CALL_CAN_REACH,
+        METRIC_CALL_APPLY,
+        METRIC_CALL_APPLY_BATCH,
+        METRIC_CALL_APPLY_BATCH_CONCURRENTLY,
+        METRIC_CALL_SCHEDULE,
+        METRIC_CALL_ADVANCE_TO,
+        METRIC_CALL_GET_RULER_CHANGES,
+        METRIC_CALL_AREA_STATS,
+        METRIC_CALL_PRINT_GROUP,
+        METRIC_CALL_PRINT_CLAN,
+        METRIC_CALL_TOP_GROUPS,
+        METRIC_CALL_TOP_GROUPS_OF_CLAN,
+        //the exceptions the world throws, in the order of WorldResult (from
+        //WORLD_INVALID_ARGUMENT).
+        METRIC_THROWN_INVALID_ARGUMENT,
+        METRIC_THROWN_GROUP_NAME_IS_TAKEN,
+        METRIC_THROWN_CLAN_NAME_IS_TAKEN,
+        METRIC_THROWN_AREA_NAME_IS_TAKEN,
+        METRIC_THROWN_GROUP_NOT_FOUND,
+        METRIC_THROWN_CLAN_NOT_FOUND,
+        METRIC_THROWN_AREA_NOT_FOUND,
+        METRIC_THROWN_GROUP_ALREADY_IN_AREA,
+        METRIC_THROWN_AREA_NOT_REACHABLE,
+        METRIC_THROWN_CLAN_CANT_UNITE,
+        METRIC_THROWN_TRANSACTION_ACTIVE,
+        METRIC_COUNT
+    };
+
+    /**
+     * The counters that also keep a latency histogram, the arrivals to
+     * every type of area and the calls of the world, and the amount of
+     * buckets of a histogram (Metrics::latencyBucket).
+     */
+    const int LATENCY_FIRST = METRIC_PLAIN_ARRIVALS;
+    const int LATENCY_COUNT = METRIC_CALL_TOP_GROUPS_OF_CLAN -
+                              METRIC_PLAIN_ARRIVALS + 1;
+    const int LATENCY_BUCKETS = 312;
+
+    /**
+     * The metrics of the simulation: counters of what the groups, the areas
+     * and the world do, for all the worlds of the process.
+     *
+     * Every thread counts into its own counters, without locking, and
+     * reading a metric adds up the counters of all the threads. The
+     * counters of a thread that ended are added to the counters of the
+     * ended threads, so they aren't lost.
+     *
+     * The arrivals and the calls of the world also keep a histogram of
+     * how long they took, with buckets like those of an HDR histogram:
+     * every power of 2 of nanoseconds is split into 8 buckets, so a bucket
+     * is at most 12.5% wider than its lower limit, from 1 nanosecond to
+     * more than half an hour.
+     *
+     * The counters are counted with MTM_COUNT, and the histograms with
+     * MTM_TIME, that also counts. Both do nothing when the build defines
+     * MTM_NO_METRICS (the WORLD_METRICS option of cmake).
+     */
+    class Metrics{
+        /**
+         * The counters of a thread. Only the thread writes them, so adding
+         * is a plain load and store, and the readers of other threads load
+         * them.
+         */
+        struct ThreadCounters{
+            std::atomic<long long> values[METRIC_COUNT];
+            std::atomic<long long> latencies[LATENCY_COUNT][LATENCY_BUCKETS];
+            std::atomic<long long> latency_sums[LATENCY_COUNT];
+
+            /**
+             * Start the counters of the thread at 0, and register them.
+             */
+            ThreadCounters();
+
+            /**
+             * Add the counters to those of the ended threads, and unregister
+             * them.
+             */
+            ~ThreadCounters();
+        };
+
+        /**
+         * The counters of the running threads, and those of the ended
+         * threads added up (Metrics.cpp).
+         */
+        struct Registry;
+
+        /**
+         * A private function that gets the registry, made on the first
+         * call. The counters of the main thread are unregistered before it
+         * is destroyed.
+         */
+        static Registry& registry();
+
+        /**
+         * A private function that adds up a counter over the ended threads
+         * and the running ones, with the registry locked.
+         */
+        static long long total(Registry& counters, int metric);
+
+        /**
+         * A private function that adds up the histogram of a counter over
+         * the ended threads and the running ones, with the registry locked.
+         * @return The sum of the latencies.
+         */
+        static long long totalLatencies(Registry& counters, int latency,
+                                        long long buckets[LATENCY_BUCKETS]);
+
+        /**
+         * A private function that gets the counters of the thread that calls
+         * it, registering them on the first call.
+         */
+        static ThreadCounters& local() {
+            static thread_local ThreadCounters counters;
+            return counters;
+        }
+
+    public:
+        /**
+         * A private function that adds to a counter of the calling thread,
+         * without sharing it with other threads.
+         */
+        static void addTo(std::atomic<long long>& value, long long amount) {
+            value.store(value.load(std::memory_order_relaxed) + amount,
+                        std::memory_order_relaxed);
+        }
+
+        /**
+         * Add to a counter of the calling thread.
+         * @param metric The counter.
+         * @param amount What to add to it.
+         */
+        static void add(Metric metric, long long amount = 1) {
+            addTo(local().values[metric], amount);
+        }
+
+        /**
+         * @param nanoseconds A latency.
+         * @return The bucket of the latency in a histogram: the latencies
+         *  below 8 nanoseconds have a bucket each, and then every power of
+         *  2 has 8 buckets. The longest latencies share the last bucket.
+         */
+        static int latencyBucket(long long nanoseconds) {
+            if (nanoseconds < 8) {
+                return nanoseconds < 0 ? 0 : static_cast<int>(nanoseconds);
+            }
+            int power = 63 - __builtin_clzll(nanoseconds);
+            int bucket = (power - 2) * 8 + static_cast<int>(
+                    (nanoseconds >> (power - 3)) & 7);
+            return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+        }
+
+        /**
+         * @param bucket A bucket of a histogram.
+         * @return The longest latency in the bucket, in nanoseconds.
+         */
+        static long long bucketLimit(int bucket);
+
+        /**
+         * Add a latency to the histogram of a counter, of the calling
+         * thread.
+         * @param metric An arrival or a call of the world.
+         * @param nanoseconds How long it took.
+         */
+        static void record(Metric metric, long long nanoseconds) {
+            ThreadCounters& counters = local();
+            int latency = metric - LATENCY_FIRST;
+            addTo(counters.latencies[latency][latencyBucket(nanoseconds)], 1);
+            addTo(counters.latency_sums[latency], nanoseconds);
+        }
+
+        /**
+         * Get a percentile of the histogram of a counter, added up over all
+         * the threads.
+         * @param metric An arrival or a call of the world.
+         * @param quantile The percentile, from 0 to 1 (0.99 for the 99th).
+         * @return The limit of the bucket the percentile is in, in
+         *  nanoseconds, or 0 if the histogram is empty.
+         */
+        static long long percentile(Metric metric, double quantile);
+
+        /**
+         * @param metric The counter.
+         * @return The counter, added up over all the threads.
+         */
+        static long long get(Metric metric);
+
+        /**
+         * Print all the metrics to the ostream in the Prometheus text format:
+         * every metric has a HELP and a TYPE line, and then a line for every
+         * label of it, like:
+         *      mtm_fights_total{result="won"} 12
+         * A histogram has a line for every bucket that isn't empty, with
+         * the latencies up to the limit of the bucket, in seconds, and its
+         * sum and count:
+         *      mtm_world_call_seconds_bucket{call="moveGroup",le="1.535e-06"} 7
+         * @param os The ostream to print into.
+         */
+        static void dump(std::ostream& os);
+    };
+
+    /**
+     * Counts an arrival or a call of the world when it is made, and adds
+     * how long it took to its histogram when it goes out of scope.
+     */
+    class LatencyTimer{
+        Metric metric;
+        std::chrono::steady_clock::time_point start;
+    public:
+        explicit LatencyTimer(Metric metric) : metric(metric),
+                start(std::chrono::steady_clock::now()) {
+            Metrics::add(metric);
+        }
+
+        LatencyTimer(const LatencyTimer&) = delete;
+        LatencyTimer& operator=(const LatencyTimer&) = delete;
+
+        ~LatencyTimer() {
+            Metrics::record(metric,
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start).count());
+        }
+    };
+} // namespace mtm
+
+#ifdef MTM_NO_METRICS
+#define MTM_COUNT(metric) ((void)0)
+#define MTM_TIME(metric) ((void)0)
+#else
+#define MTM_COUNT(metric) (mtm::Metrics::add(metric))
+#define MTM_TIME(metric) mtm::LatencyTimer latency_timer(metric)
+#endif
+
+#endif //MTM4_METRICS_H
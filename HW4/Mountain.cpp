@@ -1,36 +1,57 @@
 #include "Mountain.h"
+#include "Trace.h"
 using namespace mtm ;
 /**
  * Mountain.cpp , all functions are explained in Mountain.h .
  */
 Mountain::Mountain(const std::string& name) : Area(name),
-                                              ruler(nullptr) {}
+                                              ruler(nullptr),
+                                              ruler_changes(0),
+                                              clan_rankings(),
+                                              all_rankings() {}
 
 void Mountain::groupArrive(const string& group_name, const string& clan,
                            map<string, Clan>& clan_map) {
+    MTM_TIME(METRIC_MOUNTAIN_ARRIVALS);
+    MTM_TRACE("Mountain::groupArrive");
     Area::groupArrive(group_name,clan,clan_map);
     GroupPointer arrived_group = clan_map.at(clan).getGroup(group_name) ;
     if (ruler == nullptr) {
-        ruler=arrived_group;
-        groups.insert(groups.begin(),arrived_group);
+        setRuler(arrived_group);
+        addRankedGroup(arrived_group);
         return ;
     }
     if ((*ruler).getClan()==clan) {
         if ((*arrived_group)>(*ruler)) {
-            ruler=arrived_group ;
+            setRuler(arrived_group);
         }
-        groups.insert(groups.begin(),arrived_group);
+        addRankedGroup(arrived_group);
         return ;
     }
-    if ((*arrived_group).fight(*ruler)==WON){
-        ruler=arrived_group ;
-        groups.insert(groups.begin(),arrived_group);
+    GroupPointer old_ruler = ruler ;
+    string old_ruler_name = (*old_ruler).getName() ;
+    string old_ruler_clan = (*old_ruler).getClan() ;
+    FIGHT_RESULT result = (*arrived_group).fight(*old_ruler);
+    stats.fights++;
+    clan_map.at(old_ruler_clan).refreshGroup(old_ruler_name);
+    clan_map.at(clan).refreshGroup(group_name);
+    if ((*old_ruler).getSize()==0) {
+        unrankGroup(old_ruler, old_ruler_clan);
+    } else {
+        rankGroup(old_ruler);
+        recountGroup(findGroup(old_ruler_name));
+    }
+    if (result==WON){
+        setRuler(arrived_group);
+        addRankedGroup(arrived_group);
         deleteEmptyGroups();
         return ;
     }
     if ((*arrived_group).getSize()!=0){
-        groups.insert(groups.begin(),arrived_group);//
+        addRankedGroup(arrived_group);
+        return ;
     }//if they lost we don't want to add an empty group to the vector.
+    releaseName(group_name);
 }
 
 void Mountain::groupLeave(const std::string& group_name){
@@ -38,11 +59,42 @@ void Mountain::groupLeave(const std::string& group_name){
     if (group_index==-1) {
         throw AreaGroupNotFound();
     }
-    groups.erase(groups.begin()+group_index);
-    if((*ruler).getName()!=group_name) {
+    GroupPointer leaving = removeGroupAt(group_index);
+    unrankGroup(leaving, (*leaving).getClan());
+    if(leaving != ruler) {
+        return ;
+    }
+    ruler = nullptr ;
+    setRuler(findStrongestGroup((*leaving).getClan()));
+}
+
+void Mountain::refreshGroups() {
+    Area::refreshGroups();
+    //the ruler may have been put back from outside of the mountain.
+    stats.ruler = ruler.get();
+    clan_rankings.clear();
+    all_rankings.clear();
+    for (unsigned int i = 0; i < groups.size(); i++) {
+        rankGroup(groups[i]);
+    }
+}
+
+bool Mountain::appendRanked(const GroupPointer& group) {
+    return all_rankings.append(group) &&
+           clan_rankings.append(group, (*group).getClan());
+}
+
+int Mountain::getRulerChanges() const {
+    return ruler_changes ;
+}
+
+void Mountain::addArrivalFootprint(const std::string& clan,
+                                   const map<string, Clan>&,
+                                   ArrivalFootprint& footprint) const {
+    //the group fights the ruler, if the ruler is from another clan.
+    if ((ruler == nullptr) || ((*ruler).getClan() == clan)) {
         return ;
     }
-    GroupPointer strongest = findStrongestGroup
-            ((*groups[group_index]).getClan());
-    ruler= strongest;
-}
\ No newline at end of file
+    footprint.clans.push_back((*ruler).getClan());
+    footprint.names.push_back((*ruler).getName());
+}
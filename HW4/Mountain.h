@@ -2,13 +2,80 @@
 #define MOUNTAIN_H
 
 #include "Area.h"
+#include "GroupRanking.h"
+#include "Metrics.h"
 
 namespace mtm{
     /**
      * Mountain
      */
-    class Mountain : public Area {
+    class Mountain final : public Area {
+        friend class Checkpoint;
+        friend class UndoLog;
+        friend class MemoryAccounting;
+
         GroupPointer ruler ;
+        int ruler_changes ;
+        /**
+         * The groups of every clan in the mountain, strongest first, and all
+         * the groups in the mountain, so ruler succession doesn't need to
+         * sort the groups vector.
+         */
+        ClanRankings clan_rankings ;
+        GroupRanking all_rankings ;
+
+        /**
+         * A private function that adds a group to the area and ranks it.
+         * @param
+         * group - the group that got into the mountain.
+         */
+        void addRankedGroup(const GroupPointer& group) {
+            addGroupToArea(group);
+            rankGroup(group);
+        }
+
+        /**
+         * A private function that ranks a group (again) after it got in, or
+         * after a fight changed it. An empty group is unranked.
+         * @param
+         * group - the group to rank.
+         */
+        void rankGroup(const GroupPointer& group) {
+            all_rankings.refresh(group);
+            if ((*group).getSize() == 0) {
+                return ;
+            }
+            clan_rankings.refresh(group, (*group).getClan());
+        }
+
+        /**
+         * A private function that removes a group from the rankings.
+         * @param
+         * group - the group to unrank.
+         * clan_name - the clan the group was ranked under.
+         */
+        void unrankGroup(const GroupPointer& group,
+                         const std::string& clan_name) {
+            all_rankings.erase(group);
+            clan_rankings.erase(group, clan_name);
+        }
+
+        /**
+         * A private function that replaces the ruler and counts the change,
+         * if the new ruler is a different group.
+         * @param
+         * new_ruler - the group that rules the mountain now, or nullptr if
+         * the mountain is empty.
+         */
+        void setRuler(const GroupPointer& new_ruler) {
+            if ((new_ruler != nullptr) && (new_ruler != ruler)) {
+                ruler_changes++;
+                MTM_COUNT(METRIC_RULER_CHANGES);
+            }
+            ruler = new_ruler;
+            stats.ruler = ruler.get();
+        }
+
         /**
          * A private function that help us who is the strongest group in the
          * area after the ruler (ruler is deleted first) , first searches for
@@ -21,20 +88,12 @@ namespace mtm{
          * A pointer to the strongest to belong to the clan - if theres one .
          * A pointer to the strongest group from any clan otherwize .
          */
-        GroupPointer findStrongestGroup(const std::string& clan_name) {
-            if (groups.size()==0){
-                return nullptr;
+        GroupPointer findStrongestGroup(const std::string& clan_name) const {
+            const GroupRanking* clan_ranking = clan_rankings.find(clan_name);
+            if (clan_ranking != nullptr) {
+                return (*clan_ranking).strongest();
             }
-            sortGroupsByStrongest();
-            for (unsigned int i = 0; i < groups.size(); i++) {
-                if ((*(groups[i])).getClan() == clan_name) {
-                    if ((*(groups[i])).getSize() != 0) {
-                            return groups[i];
-                        }
-                    }
-                }
-            return groups[0];//returns the strongest group that doesn't belong
-            // to the clan , we checked size so this exists for sure .
+            return all_rankings.strongest();
         }
 
     public:
@@ -77,6 +136,35 @@ namespace mtm{
          * group_name - the name of the group that leaves .
          */
         void groupLeave(const std::string& group_name);
+
+        /**
+         * Rank all the groups in the mountain again, by their current clan
+         * and power.
+         */
+        void refreshGroups();
+
+        /**
+         * See Area::appendRanked.
+         */
+        bool appendRanked(const GroupPointer& group);
+
+        /**
+         * Add to a footprint what a group of the given clan can change when
+         * it arrives to the mountain.
+         * @param clan The clan of the arriving group.
+         * @param clan_map The map that has all the clans.
+         * @param footprint The footprint to add to.
+         */
+        void addArrivalFootprint(const std::string& clan,
+                                 const map<string, Clan>& clan_map,
+                                 ArrivalFootprint& footprint) const;
+
+        /**
+         * Get the amount of times a different group started ruling the
+         * mountain, counting the first ruler.
+         * @return The amount of ruler changes.
+         */
+        int getRulerChanges() const;
     };
 
 }
@@ -2,6 +2,7 @@
 #define MTM4_SET_H
 
 #include "exceptions.h"
+#include "Metrics.h"
 
 namespace mtm{
     
@@ -363,9 +364,11 @@ namespace mtm{
          * element if the element wasn't inserted.
          */
         iterator insert(const Type& elem){
+            MTM_COUNT(METRIC_SET_OPERATIONS);
             if (find(elem) != const_iterator(NULL)){
                 return find(elem);
             }
+            MTM_COUNT(METRIC_SET_NODE_ALLOCATIONS);
             Node *temp = new Node(elem);
             temp->setNext(head);
             head = temp;
@@ -380,7 +383,8 @@ namespace mtm{
          * @param elem the element to remove.
          */
         void erase(const Type& elem){
-            if(contains(elem)){
+            MTM_COUNT(METRIC_SET_OPERATIONS);
+            if(find(elem) != const_iterator(NULL)){
                 if(head->getElement() == elem){
                     Node* temp = head;
                     head = head->getNext();
@@ -411,7 +415,16 @@ namespace mtm{
         int size() const{
             return setSize;
         }
-        
+
+        /**
+         * Get the bytes the nodes of the set take, without the memory their
+         * elements point to.
+         * @return The bytes of the nodes of the set.
+         */
+        long long nodeBytes() const{
+            return static_cast<long long>(setSize) * sizeof(Node);
+        }
+
         /**
          * Check if the set is empty.
          * @return true is the set is empty.
@@ -512,6 +525,7 @@ namespace mtm{
          * @return True if the element is in the set, false otherwise.
          */
         bool contains(const Type& elem) const{
+            MTM_COUNT(METRIC_SET_OPERATIONS);
             const_iterator c_f(find(elem));
             const_iterator c_n(NULL);
             return (const_iterator(find(elem)) != const_iterator(NULL));
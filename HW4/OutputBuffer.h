@@ -0,0 +1,111 @@
+#ifndef MTM4_OUTPUT_BUFFER_H
+#define MTM4_OUTPUT_BUFFER_H
+
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace mtm{
+
+    /**
+     * A buffer in front of an ostream, for writing a lot of small pieces of
+     * text fast: appending is a copy into the buffer, numbers are formatted
+     * in place, and the buffer is written to the ostream in one call when it
+     * fills up, without flushing the ostream.
+     * What is left in the buffer is written by flush, that has to be called
+     * at the end.
+     * The buffer is its own (SIZE bytes, for long outputs), or a buffer the
+     * caller gives it, like a small array on the stack for a short print,
+     * so writing allocates nothing.
+     */
+    class OutputBuffer{
+    public:
+        static const std::size_t SIZE = 1 << 16;
+        /**
+         * The size of a buffer on the stack for a short print, like a group
+         * or the names of a clan (a longer print is written in parts).
+         */
+        static const std::size_t STACK_SIZE = 1024;
+
+    private:
+        std::ostream& os;
+        std::unique_ptr<char[]> owned;
+        char* buffer;
+        std::size_t size;
+        std::size_t used;
+
+    public:
+        explicit OutputBuffer(std::ostream& os) : os(os),
+                owned(new char[SIZE]), buffer(owned.get()), size(SIZE),
+                used(0) {}
+
+        OutputBuffer(std::ostream& os, char* buffer, std::size_t size) :
+                os(os), owned(), buffer(buffer), size(size), used(0) {}
+
+        OutputBuffer(const OutputBuffer&) = delete;
+        OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+        void append(const char* text, std::size_t length) {
+            if (used + length > size) {
+                flush();
+                if (length > size) {
+                    os.write(text, length);
+                    return ;
+                }
+            }
+            std::memcpy(buffer + used, text, length);
+            used += length;
+        }
+
+        void append(const std::string& text) {
+            append(text.data(), text.size());
+        }
+
+        /**
+         * Append a string literal, without measuring it.
+         */
+        template<std::size_t LENGTH>
+        void append(const char (&text)[LENGTH]) {
+            append(text, LENGTH - 1);
+        }
+
+        void append(char c) {
+            if (used == size) {
+                flush();
+            }
+            buffer[used++] = c;
+        }
+
+        /**
+         * Append a number in decimal.
+         */
+        void appendNumber(long long number) {
+            //the digits are written from the last one, into the end of a
+            //buffer big enough for the longest number and its sign.
+            char digits[24];
+            char* first = digits + sizeof(digits);
+            unsigned long long value = number < 0 ?
+                    0ULL - static_cast<unsigned long long>(number) :
+                    static_cast<unsigned long long>(number);
+            do {
+                *--first = static_cast<char>('0' + value % 10);
+                value /= 10;
+            } while (value != 0);
+            if (number < 0) {
+                *--first = '-';
+            }
+            append(first, digits + sizeof(digits) - first);
+        }
+
+        /**
+         * Write what is in the buffer to the ostream.
+         */
+        void flush() {
+            os.write(buffer, used);
+            used = 0;
+        }
+    };
+} // namespace mtm
+
+#endif //MTM4_OUTPUT_BUFFER_H
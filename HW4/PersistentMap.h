@@ -0,0 +1,178 @@
+#ifndef MTM4_PERSISTENT_MAP_H
+#define MTM4_PERSISTENT_MAP_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mtm{
+
+    /**
+     * A map from names to values that is cheap to copy: a copy shares all
+     * of its nodes with the map it was copied from, and a change to one of
+     * them copies only the nodes on the way to the changed name.
+     * The names are kept in a trie of their hashes, DEPTH levels of WIDTH
+     * children, so find, insert and erase are O(DEPTH) plus a short scan of
+     * the names with the same hash bits.
+     *
+     * A node that no other map shares is changed in place, so many changes
+     * to a map between two copies of it copy every node at most once. A map
+     * can be read from many threads while another copy of it is changed, as
+     * long as each map object is only changed by one thread.
+     */
+    template<typename Value>
+    class PersistentMap{
+        static const int BITS = 5;
+        static const int WIDTH = 1 << BITS;
+        static const int DEPTH = 4;
+
+        struct Node{
+            std::shared_ptr<Node> children[WIDTH];
+            std::vector<std::pair<std::string, Value> > entries;
+        };
+        typedef std::shared_ptr<Node> NodePointer;
+
+        NodePointer root;
+        int count;
+
+        static int childIndex(size_t hash, int level) {
+            return static_cast<int>((hash >> (level * BITS)) & (WIDTH - 1));
+        }
+
+        /**
+         * A private function that makes a node safe to change: a new node
+         * if there is none, a copy of it if another map shares it.
+         * @param
+         * node - the node to change, replaced by the node that is safe.
+         */
+        static void own(NodePointer& node) {
+            if (node == nullptr) {
+                node = std::make_shared<Node>();
+            } else if (node.use_count() > 1) {
+                node = std::make_shared<Node>(*node);
+            }
+        }
+
+        static bool isEmpty(const Node& node) {
+            if (!node.entries.empty()) {
+                return false;
+            }
+            for (int i = 0; i < WIDTH; i++) {
+                if (node.children[i] != nullptr) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * A private function that removes a name from a subtree, and the
+         * nodes that are left empty.
+         * @return
+         * true if the name was in the subtree.
+         */
+        static bool eraseFrom(NodePointer& node, int level, size_t hash,
+                              const std::string& name) {
+            if (node == nullptr) {
+                return false;
+            }
+            if (level == DEPTH) {
+                for (unsigned int i = 0; i < (*node).entries.size(); i++) {
+                    if ((*node).entries[i].first == name) {
+                        own(node);
+                        (*node).entries.erase((*node).entries.begin() + i);
+                        if ((*node).entries.empty()) {
+                            node.reset();
+                        }
+                        return true;
+                    }
+                }
+                return false;
+            }
+            int index = childIndex(hash, level);
+            if ((*node).children[index] == nullptr) {
+                return false;
+            }
+            own(node);
+            bool erased = eraseFrom((*node).children[index], level + 1, hash,
+                                    name);
+            if (isEmpty(*node)) {
+                node.reset();
+            }
+            return erased;
+        }
+
+    public:
+        PersistentMap() : root(), count(0) {}
+
+        /**
+         * @param name The name to look for.
+         * @return The value of the name, or nullptr if it isn't in the map.
+         *  The value lives as long as the map doesn't change.
+         */
+        const Value* find(const std::string& name) const {
+            size_t hash = std::hash<std::string>()(name);
+            const Node* node = root.get();
+            for (int level = 0; (node != nullptr) && (level < DEPTH);
+                 level++) {
+                node = (*node).children[childIndex(hash, level)].get();
+            }
+            if (node == nullptr) {
+                return nullptr;
+            }
+            for (unsigned int i = 0; i < (*node).entries.size(); i++) {
+                if ((*node).entries[i].first == name) {
+                    return &((*node).entries[i].second);
+                }
+            }
+            return nullptr;
+        }
+
+        /**
+         * Set the value of a name, adding the name if it isn't in the map.
+         * The copies of the map don't change.
+         */
+        void insert(const std::string& name, const Value& value) {
+            size_t hash = std::hash<std::string>()(name);
+            NodePointer* node = &root;
+            for (int level = 0; level < DEPTH; level++) {
+                own(*node);
+                node = &((**node).children[childIndex(hash, level)]);
+            }
+            own(*node);
+            std::vector<std::pair<std::string, Value> >& entries =
+                    (**node).entries;
+            for (unsigned int i = 0; i < entries.size(); i++) {
+                if (entries[i].first == name) {
+                    entries[i].second = value;
+                    return ;
+                }
+            }
+            entries.push_back(std::make_pair(name, value));
+            count++;
+        }
+
+        /**
+         * Remove a name from the map. The copies of the map don't change.
+         * @return true if the name was in the map.
+         */
+        bool erase(const std::string& name) {
+            if (!eraseFrom(root, 0, std::hash<std::string>()(name), name)) {
+                return false;
+            }
+            count--;
+            return true;
+        }
+
+        /**
+         * @return The number of names in the map.
+         */
+        int size() const {
+            return count;
+        }
+    };
+} // namespace mtm
+
+#endif //MTM4_PERSISTENT_MAP_H
@@ -1,23 +1,62 @@
 #include "Plain.h"
+#include "Metrics.h"
+#include "Trace.h"
 using namespace mtm ;
 
 /**
  * Plain.cpp , all functions are explained in Plain.h .
  */
-Plain::Plain(const std::string& name) : Area(name) {}
+Plain::Plain(const std::string& name) : Area(name), clan_rankings() {}
 
 void Plain::groupArrive(const string& group_name, const string& clan,
                  map<string, Clan>& clan_map) {
+    MTM_TIME(METRIC_PLAIN_ARRIVALS);
+    MTM_TRACE("Plain::groupArrive");
     Area::groupArrive(group_name,clan,clan_map);
     int third_of_clan = ceil((clan_map.at(clan).getSize())/3);
     GroupPointer group_ptr = clan_map.at(clan).getGroup(group_name);
     if ((*group_ptr).getSize()<third_of_clan){
-        uniteGroups(clan,third_of_clan,group_ptr);
+        uniteGroups(clan,clan_map,third_of_clan,group_ptr);
         return ;
     }
     if ((*group_ptr).getSize()<MIN_SIZE_FOR_SPLIT) {
-        groups.insert(groups.begin(),group_ptr);
+        addRankedGroup(group_ptr);
         return ;
     }
     divideGroups(clan,clan_map,group_ptr);
-}
\ No newline at end of file
+}
+
+void Plain::groupLeave(const std::string& group_name) {
+    int group_index = findGroup(group_name) ;
+    if (group_index==-1) {
+        throw AreaGroupNotFound();
+    }
+    GroupPointer leaving = removeGroupAt(group_index);
+    clan_rankings.erase(leaving, (*leaving).getClan());
+}
+
+void Plain::refreshGroups() {
+    Area::refreshGroups();
+    clan_rankings.clear();
+    for (unsigned int i = 0; i < groups.size(); i++) {
+        clan_rankings.refresh(groups[i], (*(groups[i])).getClan());
+    }
+}
+
+bool Plain::appendRanked(const GroupPointer& group) {
+    return clan_rankings.append(group, (*group).getClan());
+}
+
+void Plain::addArrivalFootprint(const std::string& clan,
+                                const map<string, Clan>&,
+                                ArrivalFootprint& footprint) const {
+    //the group can unite with any group of its clan in the plain.
+    const GroupRanking* ranking = clan_rankings.find(clan);
+    if (ranking == nullptr) {
+        return ;
+    }
+    for (GroupRanking::const_iterator it = (*ranking).begin();
+         it != (*ranking).end(); ++it) {
+        footprint.names.push_back((**it).getName());
+    }
+}
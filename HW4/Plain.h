@@ -2,36 +2,66 @@
 #define PLAIN_PLAIN_H
 
 #include "Area.h"
-#include <sstream>
+#include "GroupRanking.h"
 
 namespace mtm{
     #define MIN_SIZE_FOR_SPLIT (10)
     /**
      * Plain
      */
-    class Plain : public Area {
+    class Plain final : public Area {
+        friend class MemoryAccounting;
+
+        /**
+         * The groups of every clan in the plain, strongest first, so a group
+         * that arrives only looks at the groups of its own clan.
+         */
+        ClanRankings clan_rankings ;
+
+        /**
+         * A private function that adds a group to the plain and ranks it.
+         * @param
+         * group - the group that got into the plain.
+         */
+        void addRankedGroup(const GroupPointer& group) {
+            addGroupToArea(group);
+            clan_rankings.refresh(group, (*group).getClan());
+        }
+
         /**
          * A private function that helps us unite a group that arrived to the
          * plain and need to unite with the strongest group in the area
          * from the same clan (which is not empty) .
          * @param
          * clan_name - the clan name .
+         * clan_map - the map that has the entire list of clans.
          * third_of_clan - a third of the clan population.
          * group - A pointer to the group we wish to unite.
          */
-        void  uniteGroups(const string& clan_name,int third_of_clan
-                ,GroupPointer group) {
-            sortGroupsByStrongest();
-            for (unsigned int i = 0; i < groups.size(); i++) {
-                if ((*(groups[i])).getClan() == clan_name) {
-                    if ((*(groups[i])).getSize() != 0 ){
-                        if ((*groups[i]).unite(*group, third_of_clan)) {
-                            return;
-                        }
+        void  uniteGroups(const string& clan_name, map<string, Clan>& clan_map,
+                          int third_of_clan, const GroupPointer& group) {
+            const GroupRanking* ranking = clan_rankings.find(clan_name);
+            string group_name = (*group).getName();
+            if (ranking != nullptr) {
+                for (GroupRanking::const_iterator it = (*ranking).begin();
+                     it != (*ranking).end(); ++it) {
+                    GroupPointer partner = *it ;
+                    string partner_name = (*partner).getName();
+                    if (!(*partner).unite(*group, third_of_clan)) {
+                        continue ;
                     }
+                    //the arriving group was emptied, refresh it first.
+                    clan_map.at(clan_name).refreshGroup(group_name);
+                    clan_map.at(clan_name).refreshGroup(partner_name);
+                    clan_rankings.refresh(partner, clan_name);
+                    reindexGroup(findGroup(partner_name));
+                    if ((*partner).getName() != group_name) {
+                        releaseName(group_name);
+                    }
+                    return;
                 }
             }// we didn't fine a group to unite with .
-            groups.insert(groups.begin(), group);
+            addRankedGroup(group);
         }
         /**
          * A Praivte function that helps us check if a certin group name
@@ -53,6 +83,32 @@ namespace mtm{
             return false ;
         }
 
+        /**
+         * A private function that chooses the name of a group divided from
+         * the given group, its name with "_i" added when i is the smallest
+         * number bigger than 1 that no group uses.
+         * The world's name index answers in O(1) amortized, an area that
+         * isn't in a world checks every candidate against every clan.
+         * @param
+         * clan_map - the map that hold the entire clans .
+         * group_name - the name of the group we split .
+         * @return
+         * the name for the new group .
+         */
+        string chooseSplitName(map<string, Clan>& clan_map,
+                               const string& group_name) {
+            if (getGroupNames() != nullptr) {
+                return (*getGroupNames()).splitName(group_name);
+            }
+            string name ;
+            int index = 2 ;
+            do {
+                name = group_name + "_" + std::to_string(index++);
+            }
+            while (checkIfNameExiest(clan_map,name));
+            return name ;
+        }
+
         /**
          * A private function that helps us dived a group into 2 groups
          * the other group will have the same name and with a "_i" when
@@ -63,21 +119,14 @@ namespace mtm{
          * group - a group pointer to the group we wish to split .
          */
         void divideGroups(const string& clan,map<string, Clan>& clan_map,
-                          GroupPointer group) {
-            string group_name= (*group).getName();
-            std::stringstream temp_name ;
-            int index = 2 ;
-            do {
-                temp_name.str("");
-                temp_name.clear();
-                temp_name<< group_name << "_" << index++ ;
-            }
-            while (checkIfNameExiest(clan_map,temp_name.str()));
-            Group new_group = (*group).divide(temp_name.str()) ;
-            clan_map.at(clan).addGroup(new_group);
-            GroupPointer group2 = clan_map.at(clan).getGroup(temp_name.str());
-            groups.insert(groups.begin(),group);
-            groups.insert(groups.begin(),group2);
+                          const GroupPointer& group) {
+            string new_name = chooseSplitName(clan_map, (*group).getName());
+            Group new_group = (*group).divide(new_name) ;
+            Clan& group_clan = clan_map.at(clan) ;
+            group_clan.refreshGroup((*group).getName());
+            group_clan.addGroup(new_group);
+            addRankedGroup(group);
+            addRankedGroup(group_clan.getGroup(new_name));
         }
 
     public:
@@ -114,6 +163,36 @@ namespace mtm{
          */
         void groupArrive(const string& group_name, const string& clan,
                                  map<string, Clan>& clan_map) ;
+
+        /**
+         * Get a group out of the plain.
+         * @param group_name The name of the leaving group.
+         * @throws AreaGroupNotFound If there is no group in the area with the
+         *  same name;
+         */
+        void groupLeave(const std::string& group_name);
+
+        /**
+         * Rank all the groups in the plain again, by their current clan and
+         * power.
+         */
+        void refreshGroups();
+
+        /**
+         * See Area::appendRanked.
+         */
+        bool appendRanked(const GroupPointer& group);
+
+        /**
+         * Add to a footprint what a group of the given clan can change when
+         * it arrives to the plain.
+         * @param clan The clan of the arriving group.
+         * @param clan_map The map that has all the clans.
+         * @param footprint The footprint to add to.
+         */
+        void addArrivalFootprint(const std::string& clan,
+                                 const map<string, Clan>& clan_map,
+                                 ArrivalFootprint& footprint) const;
     };
 
 }
@@ -0,0 +1,254 @@
+#include "ReachabilityIndex.h"
+#include <algorithm>
+#include <deque>
+
+using namespace mtm ;
+/**
+ * ReachabilityIndex.cpp , all functions are explained in ReachabilityIndex.h .
+ */
+
+ReachabilityIndex::ReachabilityIndex() : words(1), representatives(),
+                                         representative_areas(1, 0),
+                                         reaches(), reached_by(), roads(),
+                                         roads_into(), next_hops() {}
+
+int ReachabilityIndex::addArea() {
+    int id = reaches.size();
+    if (id == words * BITS) {
+        //the rows are full, make them all twice as long.
+        words *= 2;
+        representative_areas.resize(words, 0);
+        for (unsigned int i = 0; i < reaches.size(); i++) {
+            reaches[i].resize(words, 0);
+            reached_by[i].resize(words, 0);
+        }
+    }
+    representatives.push_back(id);
+    set(representative_areas, id);
+    reaches.push_back(Row(words, 0));
+    reached_by.push_back(Row(words, 0));
+    roads.push_back(std::vector<int>());
+    roads_into.push_back(std::vector<int>());
+    return id;
+}
+
+void ReachabilityIndex::addRoad(int from, int to) {
+    std::vector<int>& from_roads = roads[from];
+    if (std::find(from_roads.begin(), from_roads.end(), to) !=
+            from_roads.end()) {
+        return ;
+    }
+    from_roads.push_back(to);
+    roads_into[to].push_back(from);
+    //a new road can make paths shorter.
+    next_hops.clear();
+    int from_component = representatives[from];
+    int to_component = representatives[to];
+    if (test(reaches[from_component], to)) {
+        return ;
+    }
+    //everything that reaches 'from' (and 'from' itself) now reaches 'to' and
+    //everything 'to' reaches.
+    Row targets = reaches[to_component];
+    set(targets, to);
+    Row sources = reached_by[from_component];
+    set(sources, from);
+    addToRows(reaches, sources, targets, to);
+    addToRows(reached_by, targets, sources, from);
+    if (!test(targets, from)) {
+        return ;
+    }
+    //the road closed a cycle: the areas that reach 'from' and that 'to'
+    //reaches are now one component.
+    Row cycle = sources;
+    for (unsigned int i = 0; i < cycle.size(); i++) {
+        cycle[i] &= targets[i];
+    }
+    std::vector<int>& component_of = representatives;
+    Row& representative_rows = representative_areas;
+    forEachBit(cycle, [&component_of, &representative_rows,
+                       from_component](int area) {
+        component_of[area] = from_component;
+        if (area != from_component) {
+            reset(representative_rows, area);
+        }
+    });
+}
+
+void ReachabilityIndex::addRoads(const std::vector<std::vector<int> >& into) {
+    for (unsigned int to = 0; to < into.size(); to++) {
+        for (unsigned int i = 0; i < into[to].size(); i++) {
+            std::vector<int>& from_roads = roads[into[to][i]];
+            if (std::find(from_roads.begin(), from_roads.end(), to) ==
+                    from_roads.end()) {
+                from_roads.push_back(to);
+                roads_into[to].push_back(into[to][i]);
+            }
+        }
+    }
+    next_hops.clear();
+    std::vector<int> members;
+    std::vector<std::pair<int, int> > components = findComponents(members);
+    //a component reaches the areas its roads lead to, and everything their
+    //components reach. Those components were all found before it.
+    for (unsigned int i = 0; i < components.size(); i++) {
+        int component = components[i].first;
+        int end = i + 1 < components.size() ? components[i + 1].second :
+                  members.size();
+        Row& row = reaches[component];
+        for (int j = components[i].second; j < end; j++) {
+            const std::vector<int>& area_roads = roads[members[j]];
+            for (unsigned int k = 0; k < area_roads.size(); k++) {
+                set(row, area_roads[k]);
+                const Row& next = reaches[representatives[area_roads[k]]];
+                if (&next != &row) {
+                    for (int word = 0; word < words; word++) {
+                        row[word] |= next[word];
+                    }
+                }
+            }
+        }
+    }
+    //and the other way around, from the components nothing reaches.
+    for (int i = components.size() - 1; i >= 0; i--) {
+        int component = components[i].first;
+        int end = i + 1 < static_cast<int>(components.size()) ?
+                  components[i + 1].second : members.size();
+        Row& row = reached_by[component];
+        for (int j = components[i].second; j < end; j++) {
+            const std::vector<int>& area_roads = roads_into[members[j]];
+            for (unsigned int k = 0; k < area_roads.size(); k++) {
+                set(row, area_roads[k]);
+                const Row& previous =
+                        reached_by[representatives[area_roads[k]]];
+                if (&previous != &row) {
+                    for (int word = 0; word < words; word++) {
+                        row[word] |= previous[word];
+                    }
+                }
+            }
+        }
+    }
+}
+
+std::vector<std::pair<int, int> > ReachabilityIndex::findComponents(
+        std::vector<int>& members) {
+    int count = reaches.size();
+    std::vector<int> order(count, -1);
+    std::vector<int> low(count, 0);
+    std::vector<bool> on_stack(count, false);
+    std::vector<int> stack;
+    //the areas the search is in, and the next road of each of them.
+    std::vector<std::pair<int, unsigned int> > calls;
+    std::vector<std::pair<int, int> > components;
+    int counter = 0;
+    for (int root = 0; root < count; root++) {
+        if (order[root] != -1) {
+            continue ;
+        }
+        order[root] = low[root] = counter++;
+        stack.push_back(root);
+        on_stack[root] = true;
+        calls.push_back(std::make_pair(root, 0u));
+        while (!calls.empty()) {
+            int area = calls.back().first;
+            if (calls.back().second < roads[area].size()) {
+                int to = roads[area][calls.back().second++];
+                if (order[to] == -1) {
+                    order[to] = low[to] = counter++;
+                    stack.push_back(to);
+                    on_stack[to] = true;
+                    calls.push_back(std::make_pair(to, 0u));
+                } else if (on_stack[to]) {
+                    low[area] = std::min(low[area], order[to]);
+                }
+                continue ;
+            }
+            calls.pop_back();
+            if (!calls.empty()) {
+                int& parent_low = low[calls.back().first];
+                parent_low = std::min(parent_low, low[area]);
+            }
+            if (low[area] != order[area]) {
+                continue ;
+            }
+            components.push_back(std::make_pair(area,
+                                                static_cast<int>(
+                                                        members.size())));
+            int member;
+            do {
+                member = stack.back();
+                stack.pop_back();
+                on_stack[member] = false;
+                members.push_back(member);
+                representatives[member] = area;
+                if (member != area) {
+                    reset(representative_areas, member);
+                }
+            } while (member != area);
+        }
+    }
+    return components;
+}
+
+bool ReachabilityIndex::canReach(int from, int to) const {
+    return test(reaches[representatives[from]], to);
+}
+
+const std::vector<int>& ReachabilityIndex::getRoadsInto(int to) const {
+    return roads_into[to];
+}
+
+std::vector<int> ReachabilityIndex::shortestPath(int from, int to) {
+    std::vector<int> path;
+    if (!canReach(from, to)) {
+        return path;
+    }
+    const std::vector<int>& next = findNextHops(to);
+    int area = from;
+    do {
+        area = next[area];
+        path.push_back(area);
+    } while (area != to);
+    return path;
+}
+
+int ReachabilityIndex::size() const {
+    return reaches.size();
+}
+
+const std::vector<int>& ReachabilityIndex::findNextHops(int destination) {
+    std::unordered_map<int, std::vector<int> >::const_iterator it =
+            next_hops.find(destination);
+    if (it != next_hops.end()) {
+        return it->second;
+    }
+    if (next_hops.size() >= MAX_CACHED_DESTINATIONS) {
+        next_hops.clear();
+    }
+    //a breadth first search from the destination, on the roads backwards.
+    //The destination itself gets a next hop too, if it is on a cycle, so a
+    //path from an area to itself can be found.
+    std::vector<int>& next = next_hops[destination];
+    next.assign(reaches.size(), -1);
+    std::vector<bool> visited(reaches.size(), false);
+    std::deque<int> queue(1, destination);
+    visited[destination] = true;
+    while (!queue.empty()) {
+        int area = queue.front();
+        queue.pop_front();
+        const std::vector<int>& into = roads_into[area];
+        for (unsigned int i = 0; i < into.size(); i++) {
+            int previous = into[i];
+            if (previous == destination && next[destination] == -1) {
+                next[destination] = area;
+            }
+            if (!visited[previous]) {
+                visited[previous] = true;
+                next[previous] = area;
+                queue.push_back(previous);
+            }
+        }
+    }
+    return next;
+}
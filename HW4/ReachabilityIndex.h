@@ -0,0 +1,180 @@
+#ifndef MTM4_REACHABILITY_INDEX_H
+#define MTM4_REACHABILITY_INDEX_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mtm{
+
+    /**
+     * The roads between areas, by area ids (0, 1, 2, ... in the order the
+     * areas were added), with the transitive closure of the roads.
+     * For every area the closure keeps a row of bits of the areas it reaches
+     * (in one road or more), and a row of the areas that reach it. A new
+     * road only updates the rows of the areas whose reach it grows, so once
+     * an area reaches another, more roads between them cost nothing.
+     * Areas that reach each other reach the same areas, so when a road closes
+     * a cycle, all the areas on it are merged into one component that has
+     * one pair of rows (the rows of its representative area). A road updates
+     * the rows of components, not of every area.
+     * canReach is O(1). A shortest path is O(length of the path) once the
+     * next hops to its destination are known. They are found with one
+     * breadth first search, and kept until a road is added.
+     */
+    class ReachabilityIndex{
+        friend class MemoryAccounting;
+
+        typedef std::vector<std::uint64_t> Row;
+        static const int BITS = 64;
+        static const unsigned int MAX_CACHED_DESTINATIONS = 64;
+
+        int words;
+        std::vector<int> representatives;
+        Row representative_areas;
+        std::vector<Row> reaches;
+        std::vector<Row> reached_by;
+        std::vector<std::vector<int> > roads;
+        std::vector<std::vector<int> > roads_into;
+        std::unordered_map<int, std::vector<int> > next_hops;
+
+        static bool test(const Row& row, int bit) {
+            return (row[bit / BITS] >> (bit % BITS)) & 1;
+        }
+
+        static void set(Row& row, int bit) {
+            row[bit / BITS] |= std::uint64_t(1) << (bit % BITS);
+        }
+
+        static void reset(Row& row, int bit) {
+            row[bit / BITS] &= ~(std::uint64_t(1) << (bit % BITS));
+        }
+
+        /**
+         * A private function that adds to every row in a set of components,
+         * the bits of another row. A component whose row already has the
+         * given bit is skipped, because it already has all of them.
+         * @param
+         * rows - the rows of the components.
+         * components - the bits of the components to update.
+         * bits - the bits to add.
+         * bit - a bit that is in every row that has all the bits.
+         */
+        void addToRows(std::vector<Row>& rows, const Row& components,
+                       const Row& bits, int bit) {
+            Row representative_components = components;
+            for (unsigned int i = 0; i < components.size(); i++) {
+                representative_components[i] &= representative_areas[i];
+            }
+            forEachBit(representative_components, [&rows, &bits, bit](int c) {
+                Row& row = rows[c];
+                if (test(row, bit)) {
+                    return ;
+                }
+                for (unsigned int i = 0; i < row.size(); i++) {
+                    row[i] |= bits[i];
+                }
+            });
+        }
+
+        /**
+         * A private function that calls an action with every bit that is set
+         * in a row.
+         * @param
+         * row - the row of bits.
+         * action - called with the index of every bit that is set.
+         */
+        template<typename Action>
+        static void forEachBit(const Row& row, const Action& action) {
+            for (unsigned int i = 0; i < row.size(); i++) {
+                std::uint64_t bits = row[i];
+                while (bits != 0) {
+                    action(i * BITS + __builtin_ctzll(bits));
+                    bits &= bits - 1;
+                }
+            }
+        }
+
+        /**
+         * A private function that finds, for every area that reaches the
+         * destination, the next area on a shortest path to it.
+         * @param
+         * destination - the id of the destination area.
+         * @return
+         * the next hop of every area , -1 for the destination and for the
+         * areas that don't reach it .
+         */
+        const std::vector<int>& findNextHops(int destination);
+
+        /**
+         * A private function that merges the areas that reach each other into
+         * components, by the roads alone (Tarjan's algorithm), and sets the
+         * representatives of the areas.
+         * @param
+         * members - filled with the areas, component after component.
+         * @return
+         * the representative of every component, each component after all
+         * the components it reaches, and the index in members where its
+         * areas start.
+         */
+        std::vector<std::pair<int, int> > findComponents(
+                std::vector<int>& members);
+
+    public:
+        ReachabilityIndex();
+
+        /**
+         * Add an area, with no roads.
+         * @return The id of the new area.
+         */
+        int addArea();
+
+        /**
+         * Add a road. Adding a road that already exists does nothing.
+         * @param from The id of the area the road starts in.
+         * @param to The id of the area the road ends in.
+         */
+        void addRoad(int from, int to);
+
+        /**
+         * Add many roads at once, to an index that has areas and no roads.
+         * Works like adding the roads one by one, area after area, in the
+         * order they are given, but the closure is found once for all of
+         * them, in O(areas * (areas + roads) / 64).
+         * @param into The ids of the areas that have a road into every area.
+         */
+        void addRoads(const std::vector<std::vector<int> >& into);
+
+        /**
+         * @param from The id of an area.
+         * @param to The id of an area.
+         * @return true if there is a path of one road or more from the first
+         *  area to the second one.
+         */
+        bool canReach(int from, int to) const;
+
+        /**
+         * @param to The id of an area.
+         * @return The ids of the areas that have a road into the area, in
+         *  the order the roads were added.
+         */
+        const std::vector<int>& getRoadsInto(int to) const;
+
+        /**
+         * Find a path with the fewest roads between two areas.
+         * @param from The id of the area the path starts in.
+         * @param to The id of the area the path ends in.
+         * @return The ids of the areas on the path, without the first area
+         *  and with the last one. Empty if there is no path.
+         */
+        std::vector<int> shortestPath(int from, int to);
+
+        /**
+         * @return The number of areas.
+         */
+        int size() const;
+    };
+} // namespace mtm
+
+#endif //MTM4_REACHABILITY_INDEX_H
@@ -1,22 +1,66 @@
 #include "River.h"
+#include "Metrics.h"
+#include "Trace.h"
 using namespace mtm ;
 /**
  * River.cpp , all functions are explained in River.h .
  */
-River::River(const std::string& name) : Area(name) {}
+River::River(const std::string& name) : Area(name), tool_surplus(),
+                                        food_surplus() {}
 
 void River::groupArrive(const string& group_name, const string& clan,
                            map<string, Clan>& clan_map) {
+    MTM_TIME(METRIC_RIVER_ARRIVALS);
+    MTM_TRACE("River::groupArrive");
     Area::groupArrive(group_name,clan,clan_map);
     GroupPointer arrived_group = clan_map.at(clan).getGroup(group_name) ;
-    sortGroupsByStrongest();
-    for(unsigned int i=0 ; i<groups.size() ; i++){
-      if (clan_map.at(clan).isFriend(clan_map.at((*(groups[i])).getClan()))) {
-          if ((*arrived_group).trade(*(groups[i]))) {
-                break  ; //trade succeeded
-          }
-      }
+    GroupPointer partner = findTradePartner(arrived_group, clan_map);
+    if (partner != nullptr) {
+        unbucketGroup(partner, (*partner).getClan());
+        (*arrived_group).trade(*partner);
+        stats.trades++;
+        bucketGroup(partner);
+        recountGroup(findGroup((*partner).getName()));
+        //trading changes the power of both groups.
+        clan_map.at((*partner).getClan()).rerankGroup(partner);
+        clan_map.at(clan).rerankGroup(arrived_group);
     }
-    groups.insert(groups.begin(),arrived_group);
+    addGroupToArea(arrived_group);
+    bucketGroup(arrived_group);
 }
 
+void River::groupLeave(const std::string& group_name) {
+    int group_index = findGroup(group_name) ;
+    if (group_index==-1) {
+        throw AreaGroupNotFound();
+    }
+    GroupPointer leaving = removeGroupAt(group_index);
+    unbucketGroup(leaving, (*leaving).getClan());
+}
+
+void River::refreshGroups() {
+    Area::refreshGroups();
+    tool_surplus.clear();
+    food_surplus.clear();
+    for (unsigned int i = 0; i < groups.size(); i++) {
+        bucketGroup(groups[i]);
+    }
+}
+
+bool River::appendRanked(const GroupPointer& group) {
+    const Group& g = *group ;
+    if (g.getTools() > g.getFood()) {
+        return tool_surplus.append(group, g.getClan());
+    }
+    if (g.getFood() > g.getTools()) {
+        return food_surplus.append(group, g.getClan());
+    }
+    return true;
+}
+
+void River::addArrivalFootprint(const std::string&, const map<string, Clan>&,
+                                ArrivalFootprint&) const {
+    //a trade only changes the two groups, and both are in the river. The
+    //partner's clan only ranks the partner again (its people and its
+    //groups' names stay), under the lock of the clan leaders.
+}
@@ -2,12 +2,88 @@
 #define RIVER_H
 
 #include "Area.h"
+#include "GroupRanking.h"
 
 namespace mtm{
     /**
      * River
      */
-    class River : public Area {
+    class River final : public Area {
+        friend class MemoryAccounting;
+
+        /**
+         * The groups that have more tools than food, and the groups that
+         * have more food than tools, ranked strongest first per clan.
+         * Groups with as much tools as food can't trade, and are in neither.
+         */
+        ClanRankings tool_surplus ;
+        ClanRankings food_surplus ;
+
+        /**
+         * A private function that puts a group in the bucket that matches
+         * its current tools and food.
+         * @param
+         * group - the group to put in a bucket.
+         */
+        void bucketGroup(const GroupPointer& group) {
+            const Group& g = *group ;
+            if (g.getTools() > g.getFood()) {
+                tool_surplus.refresh(group, g.getClan());
+            } else if (g.getFood() > g.getTools()) {
+                food_surplus.refresh(group, g.getClan());
+            }
+        }
+
+        /**
+         * A private function that removes a group from both buckets.
+         * @param
+         * group - the group to remove.
+         * clan_name - the clan the group was bucketed under.
+         */
+        void unbucketGroup(const GroupPointer& group,
+                           const std::string& clan_name) {
+            tool_surplus.erase(group, clan_name);
+            food_surplus.erase(group, clan_name);
+        }
+
+        /**
+         * A private function that finds the strongest group a group can
+         * trade with: a group of a friendly clan (or the same clan) that
+         * has a surplus of the other resource.
+         * Only the strongest group of every clan in the matching bucket is
+         * checked.
+         * @param
+         * group - the group that wants to trade.
+         * clan_map - the map that has all the clans.
+         * @return
+         * the partner - if there's one ,
+         * nullptr - otherwize .
+         */
+        GroupPointer findTradePartner(const GroupPointer& group,
+                                      map<string, Clan>& clan_map) const {
+            const Group& g = *group ;
+            const ClanRankings* bucket = nullptr ;
+            if (g.getTools() > g.getFood()) {
+                bucket = &food_surplus ;
+            } else if (g.getFood() > g.getTools()) {
+                bucket = &tool_surplus ;
+            } else {
+                return nullptr ;
+            }
+            const Clan& clan = clan_map.at(g.getClan()) ;
+            GroupPointer partner = nullptr ;
+            for (ClanRankings::const_iterator it = (*bucket).begin();
+                 it != (*bucket).end(); it++) {
+                GroupPointer strongest = (it->second).strongest();
+                if ((partner != nullptr) && ((*partner) > (*strongest))) {
+                    continue ;
+                }
+                if (clan.isFriend(clan_map.at(it->first))) {
+                    partner = strongest ;
+                }
+            }
+            return partner ;
+        }
 
     public:
         /**
@@ -37,6 +113,36 @@ namespace mtm{
          */
         void groupArrive(const string& group_name, const string& clan,
                          map<string, Clan>& clan_map) ;
+
+        /**
+         * Get a group out of the river.
+         * @param group_name The name of the leaving group.
+         * @throws AreaGroupNotFound If there is no group in the area with the
+         *  same name;
+         */
+        void groupLeave(const std::string& group_name);
+
+        /**
+         * Put all the groups in the river in buckets again, by their current
+         * clan, power, tools and food.
+         */
+        void refreshGroups();
+
+        /**
+         * See Area::appendRanked.
+         */
+        bool appendRanked(const GroupPointer& group);
+
+        /**
+         * Add to a footprint what a group of the given clan can change when
+         * it arrives to the river.
+         * @param clan The clan of the arriving group.
+         * @param clan_map The map that has all the clans.
+         * @param footprint The footprint to add to.
+         */
+        void addArrivalFootprint(const std::string& clan,
+                                 const map<string, Clan>& clan_map,
+                                 ArrivalFootprint& footprint) const;
     };
 
 }
@@ -0,0 +1,73 @@
+#include "SharedMutex.h"
+#include <functional>
+#include <thread>
+
+using namespace mtm ;
+/**
+ * SharedMutex.cpp , all functions are explained in SharedMutex.h .
+ */
+
+SharedMutex::SharedMutex() : mutex(), readers_gate(), writers_gate(),
+                             readers(0), waiting_writers(0), writing(false) {}
+
+void SharedMutex::lock() {
+    std::unique_lock<std::mutex> guard(mutex);
+    waiting_writers++;
+    while (writing || (readers > 0)) {
+        writers_gate.wait(guard);
+    }
+    waiting_writers--;
+    writing = true;
+}
+
+void SharedMutex::unlock() {
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        writing = false;
+    }
+    writers_gate.notify_one();
+    readers_gate.notify_all();
+}
+
+void SharedMutex::lock_shared() {
+    std::unique_lock<std::mutex> guard(mutex);
+    while (writing || (waiting_writers > 0)) {
+        readers_gate.wait(guard);
+    }
+    readers++;
+}
+
+void SharedMutex::unlock_shared() {
+    bool last = false;
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        readers--;
+        last = (readers == 0) && (waiting_writers > 0);
+    }
+    if (last) {
+        writers_gate.notify_one();
+    }
+}
+
+void ShardedSharedMutex::lock() {
+    for (int i = 0; i < SHARDS; i++) {
+        shards[i].mutex.lock();
+    }
+}
+
+void ShardedSharedMutex::unlock() {
+    for (int i = SHARDS - 1; i >= 0; i--) {
+        shards[i].mutex.unlock();
+    }
+}
+
+int ShardedSharedMutex::lock_shared() {
+    int shard = std::hash<std::thread::id>()(std::this_thread::get_id()) %
+                SHARDS;
+    shards[shard].mutex.lock_shared();
+    return shard;
+}
+
+void ShardedSharedMutex::unlock_shared(int shard) {
+    shards[shard].mutex.unlock_shared();
+}
@@ -0,0 +1,116 @@
+#ifndef MTM4_SHARED_MUTEX_H
+#define MTM4_SHARED_MUTEX_H
+
+#include <condition_variable>
+#include <mutex>
+
+namespace mtm{
+
+    /**
+     * A readers/writer lock: many threads can hold it shared, or one thread
+     * can hold it alone.
+     * A writer that waits stops new readers from getting in, so a steady
+     * stream of readers can't keep the writer out forever.
+     * It has the functions of a C++17 std::shared_mutex, so std::lock_guard
+     * and std::unique_lock can hold it alone.
+     */
+    class SharedMutex{
+        std::mutex mutex;
+        std::condition_variable readers_gate;
+        std::condition_variable writers_gate;
+        int readers;
+        int waiting_writers;
+        bool writing;
+
+    public:
+        SharedMutex();
+
+        SharedMutex(const SharedMutex&) = delete;
+        SharedMutex& operator=(const SharedMutex&) = delete;
+
+        /**
+         * Wait until no thread holds the lock, and hold it alone.
+         */
+        void lock();
+
+        void unlock();
+
+        /**
+         * Wait until no thread holds the lock alone or waits to, and hold
+         * it shared.
+         */
+        void lock_shared();
+
+        void unlock_shared();
+    };
+
+    /**
+     * A readers/writer lock that is split into shards, so readers on
+     * different threads mostly don't touch the same memory.
+     * A reader holds the shard of its thread. A writer holds all the shards,
+     * and always takes them in order, from the first shard to the last, so
+     * two writers can't deadlock.
+     */
+    class ShardedSharedMutex{
+    public:
+        static const int SHARDS = 8;
+
+    private:
+        /**
+         * A shard, padded so two shards don't share a cache line.
+         */
+        struct Shard{
+            SharedMutex mutex;
+            char padding[64];
+        };
+        Shard shards[SHARDS];
+
+    public:
+        ShardedSharedMutex() = default;
+
+        ShardedSharedMutex(const ShardedSharedMutex&) = delete;
+        ShardedSharedMutex& operator=(const ShardedSharedMutex&) = delete;
+
+        /**
+         * Hold all the shards alone, in order.
+         */
+        void lock();
+
+        /**
+         * Release all the shards, in the opposite order.
+         */
+        void unlock();
+
+        /**
+         * Hold the shard of the calling thread shared.
+         * @return The shard to give to unlock_shared.
+         */
+        int lock_shared();
+
+        /**
+         * @param shard The shard lock_shared returned.
+         */
+        void unlock_shared(int shard);
+    };
+
+    /**
+     * Holds a ShardedSharedMutex shared for as long as it lives.
+     */
+    class SharedLock{
+        ShardedSharedMutex& mutex;
+        int shard;
+
+    public:
+        explicit SharedLock(ShardedSharedMutex& mutex) : mutex(mutex),
+                                                   shard(mutex.lock_shared()) {}
+
+        SharedLock(const SharedLock&) = delete;
+        SharedLock& operator=(const SharedLock&) = delete;
+
+        ~SharedLock() {
+            mutex.unlock_shared(shard);
+        }
+    };
+} // namespace mtm
+
+#endif //MTM4_SHARED_MUTEX_H
@@ -0,0 +1,268 @@
+#include "StateExport.h"
+#include "OutputBuffer.h"
+#include "World.h"
+
+using namespace mtm ;
+using std::string ;
+/**
+ * StateExport.cpp , all functions are explained in StateExport.h .
+ */
+
+namespace {
+    const char* const AREA_TYPE_NAMES[] = { "plain", "mountain", "river" };
+    //how many groups ahead of the one being written the export asks for:
+    //the groups are all over the heap, so without asking ahead every group
+    //is a wait for memory, one after the other.
+    const unsigned int PREFETCH_DISTANCE = 8;
+
+    void writeCsvField(OutputBuffer& output, const string& text) {
+        //one pass over the name, without a search for every character.
+        bool plain = true;
+        for (unsigned int i = 0; i < text.size(); i++) {
+            char c = text[i];
+            plain &= (c != ',') && (c != '"') && (c != '\r') && (c != '\n');
+        }
+        if (plain) {
+            output.append(text);
+            return ;
+        }
+        output.append('"');
+        for (unsigned int i = 0; i < text.size(); i++) {
+            if (text[i] == '"') {
+                output.append('"');
+            }
+            output.append(text[i]);
+        }
+        output.append('"');
+    }
+
+    void writeJsonString(OutputBuffer& output, const string& text) {
+        static const char HEX[] = "0123456789abcdef";
+        output.append('"');
+        //the characters that don't need escaping are appended in runs.
+        unsigned int run = 0;
+        for (unsigned int i = 0; i < text.size(); i++) {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            if ((c >= 0x20) && (c != '"') && (c != '\\')) {
+                continue ;
+            }
+            output.append(text.data() + run, i - run);
+            run = i + 1;
+            if ((c == '"') || (c == '\\')) {
+                output.append('\\');
+                output.append(static_cast<char>(c));
+            } else {
+                output.append("\\u00");
+                output.append(HEX[c >> 4]);
+                output.append(HEX[c & 15]);
+            }
+        }
+        output.append(text.data() + run, text.size() - run);
+        output.append('"');
+    }
+
+    /**
+     * Writes a field of a JSON object: a comma before it unless it is the
+     * first, and its quoted key.
+     */
+    template<std::size_t LENGTH>
+    void writeJsonKey(OutputBuffer& output, const char (&key)[LENGTH],
+                      bool first = false) {
+        if (!first) {
+            output.append(',');
+        }
+        output.append('"');
+        output.append(key);
+        output.append("\":");
+    }
+}
+
+void StateExport::writeCsv(const World& world, OutputBuffer& output) {
+    output.append("clan,groups,population\n");
+    for (map<string, Clan>::const_iterator it = world.clan_map.begin();
+         it != world.clan_map.end(); ++it) {
+        writeCsvField(output, it->first);
+        output.append(',');
+        output.appendNumber((it->second).groups.size());
+        output.append(',');
+        output.appendNumber((it->second).getSize());
+        output.append('\n');
+    }
+    output.append("\nclan,friend\n");
+    for (map<string, Clan>::const_iterator it = world.clan_map.begin();
+         it != world.clan_map.end(); ++it) {
+        const MtmSet<string>& friends = (it->second).friends;
+        for (MtmSet<string>::const_iterator name = friends.begin();
+             name != friends.end(); ++name) {
+            writeCsvField(output, it->first);
+            output.append(',');
+            writeCsvField(output, *name);
+            output.append('\n');
+        }
+    }
+    output.append("\narea,type,groups,power,ruler,fights,trades\n");
+    for (map<string, AreaSlot>::const_iterator it = world.areas_map.begin();
+         it != world.areas_map.end(); ++it) {
+        const AreaStats& stats = world.getArea(it->second).getStats();
+        writeCsvField(output, it->first);
+        output.append(',');
+        output.append(AREA_TYPE_NAMES[(it->second).type],
+                      std::strlen(AREA_TYPE_NAMES[(it->second).type]));
+        output.append(',');
+        output.appendNumber(stats.groups);
+        output.append(',');
+        output.appendNumber(stats.power);
+        output.append(',');
+        if (stats.ruler != nullptr) {
+            writeCsvField(output, (*stats.ruler).getName());
+        }
+        output.append(',');
+        output.appendNumber(stats.fights);
+        output.append(',');
+        output.appendNumber(stats.trades);
+        output.append('\n');
+    }
+    output.append("\ngroup,clan,area,children,adults,tools,food,morale\n");
+    for (map<string, AreaSlot>::const_iterator it = world.areas_map.begin();
+         it != world.areas_map.end(); ++it) {
+        const std::vector<GroupPointer>& groups =
+                world.getArea(it->second).getGroups();
+        for (unsigned int i = 0; i < groups.size(); i++) {
+            if (i + PREFETCH_DISTANCE < groups.size()) {
+                //a group spans 2 cache lines.
+                const char* ahead = reinterpret_cast<const char*>(
+                        groups[i + PREFETCH_DISTANCE].get());
+                __builtin_prefetch(ahead);
+                __builtin_prefetch(ahead + 64);
+            }
+            const Group& group = *(groups[i]);
+            writeCsvField(output, group.getName());
+            output.append(',');
+            writeCsvField(output, group.getClan());
+            output.append(',');
+            writeCsvField(output, it->first);
+            output.append(',');
+            output.appendNumber(group.getChildren());
+            output.append(',');
+            output.appendNumber(group.getAdults());
+            output.append(',');
+            output.appendNumber(group.getTools());
+            output.append(',');
+            output.appendNumber(group.getFood());
+            output.append(',');
+            output.appendNumber(group.getMorale());
+            output.append('\n');
+        }
+    }
+    output.append('\n');
+}
+
+void StateExport::writeJson(const World& world, OutputBuffer& output) {
+    output.append("{\"clans\":[");
+    for (map<string, Clan>::const_iterator it = world.clan_map.begin();
+         it != world.clan_map.end(); ++it) {
+        if (it != world.clan_map.begin()) {
+            output.append(',');
+        }
+        output.append("\n{");
+        writeJsonKey(output, "name", true);
+        writeJsonString(output, it->first);
+        writeJsonKey(output, "groups");
+        output.appendNumber((it->second).groups.size());
+        writeJsonKey(output, "population");
+        output.appendNumber((it->second).getSize());
+        writeJsonKey(output, "friends");
+        output.append('[');
+        const MtmSet<string>& friends = (it->second).friends;
+        for (MtmSet<string>::const_iterator name = friends.begin();
+             name != friends.end(); ++name) {
+            if (name != friends.begin()) {
+                output.append(',');
+            }
+            writeJsonString(output, *name);
+        }
+        output.append("]}");
+    }
+    output.append("\n],\n\"areas\":[");
+    for (map<string, AreaSlot>::const_iterator it = world.areas_map.begin();
+         it != world.areas_map.end(); ++it) {
+        const AreaStats& stats = world.getArea(it->second).getStats();
+        if (it != world.areas_map.begin()) {
+            output.append(',');
+        }
+        output.append("\n{");
+        writeJsonKey(output, "name", true);
+        writeJsonString(output, it->first);
+        writeJsonKey(output, "type");
+        output.append('"');
+        output.append(AREA_TYPE_NAMES[(it->second).type],
+                      std::strlen(AREA_TYPE_NAMES[(it->second).type]));
+        output.append('"');
+        writeJsonKey(output, "groups");
+        output.appendNumber(stats.groups);
+        writeJsonKey(output, "power");
+        output.appendNumber(stats.power);
+        writeJsonKey(output, "ruler");
+        if (stats.ruler != nullptr) {
+            writeJsonString(output, (*stats.ruler).getName());
+        } else {
+            output.append("null");
+        }
+        writeJsonKey(output, "fights");
+        output.appendNumber(stats.fights);
+        writeJsonKey(output, "trades");
+        output.appendNumber(stats.trades);
+        output.append('}');
+    }
+    output.append("\n],\n\"groups\":[");
+    bool first = true;
+    for (map<string, AreaSlot>::const_iterator it = world.areas_map.begin();
+         it != world.areas_map.end(); ++it) {
+        const std::vector<GroupPointer>& groups =
+                world.getArea(it->second).getGroups();
+        for (unsigned int i = 0; i < groups.size(); i++) {
+            if (i + PREFETCH_DISTANCE < groups.size()) {
+                //a group spans 2 cache lines.
+                const char* ahead = reinterpret_cast<const char*>(
+                        groups[i + PREFETCH_DISTANCE].get());
+                __builtin_prefetch(ahead);
+                __builtin_prefetch(ahead + 64);
+            }
+            const Group& group = *(groups[i]);
+            if (!first) {
+                output.append(',');
+            }
+            output.append("\n{");
+            first = false;
+            writeJsonKey(output, "name", true);
+            writeJsonString(output, group.getName());
+            writeJsonKey(output, "clan");
+            writeJsonString(output, group.getClan());
+            writeJsonKey(output, "area");
+            writeJsonString(output, it->first);
+            writeJsonKey(output, "children");
+            output.appendNumber(group.getChildren());
+            writeJsonKey(output, "adults");
+            output.appendNumber(group.getAdults());
+            writeJsonKey(output, "tools");
+            output.appendNumber(group.getTools());
+            writeJsonKey(output, "food");
+            output.appendNumber(group.getFood());
+            writeJsonKey(output, "morale");
+            output.appendNumber(group.getMorale());
+            output.append('}');
+        }
+    }
+    output.append("\n]}\n");
+}
+
+void StateExport::write(const World& world, std::ostream& os,
+                        ExportFormat format) {
+    OutputBuffer output(os);
+    if (format == EXPORT_JSON) {
+        writeJson(world, output);
+    } else {
+        writeCsv(world, output);
+    }
+    output.flush();
+}
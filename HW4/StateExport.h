@@ -0,0 +1,58 @@
+#ifndef MTM4_STATE_EXPORT_H
+#define MTM4_STATE_EXPORT_H
+
+#include <ostream>
+
+namespace mtm{
+
+    class World;
+    class OutputBuffer;
+
+    /**
+     * The formats a world can be exported in (World::exportState).
+     */
+    enum ExportFormat{ EXPORT_CSV, EXPORT_JSON };
+
+    /**
+     * Exports the state of a world for analysis: a table of the clans, of
+     * their friends, of the areas and of every group with its clan, area and
+     * stats.
+     *
+     * CSV has the tables one after the other, every table is its header line
+     * and then a line for every row, and an empty line ends it:
+     *      clan,groups,population
+     *      clan,friend
+     *      area,type,groups,power,ruler,fights,trades
+     *      group,clan,area,children,adults,tools,food,morale
+     * A name that has a comma, a quote or a line break is quoted. An area
+     * with no ruler has an empty ruler.
+     * JSON is one object with a "clans" array (every clan with its
+     * "friends"), an "areas" array (ruler is null if there is none) and a
+     * "groups" array, a line for every element.
+     * The clans and the areas are ordered by name, and the groups area by
+     * area, in the order the area has them.
+     *
+     * Everything is written through an OutputBuffer, straight from the
+     * world: no group is copied, and nothing is allocated per group.
+     */
+    class StateExport{
+        /**
+         * A private function that writes the tables as CSV.
+         */
+        static void writeCsv(const World& world, OutputBuffer& output);
+
+        /**
+         * A private function that writes the tables as JSON.
+         */
+        static void writeJson(const World& world, OutputBuffer& output);
+
+    public:
+        /**
+         * Write the state of a world to an ostream.
+         */
+        static void write(const World& world, std::ostream& os,
+                          ExportFormat format);
+    };
+} // namespace mtm
+
+#endif //MTM4_STATE_EXPORT_H
@@ -0,0 +1,100 @@
+#include "Trace.h"
+#include <iomanip>
+#include <unordered_set>
+#include <utility>
+
+using namespace mtm ;
+/**
+ * Trace.cpp , all functions are explained in Trace.h .
+ */
+
+struct Trace::Registry{
+    std::mutex mutex;
+    std::unordered_set<ThreadSpans*> threads;
+    std::vector<std::pair<int, Span> > ended;
+    int next_thread;
+    long long started;
+};
+
+std::atomic<bool> Trace::on(false);
+
+Trace::Registry& Trace::registry() {
+    static Registry instance;
+    return instance;
+}
+
+Trace::ThreadSpans::ThreadSpans() : mutex(), spans(), thread(0) {
+    Registry& trace = registry();
+    std::lock_guard<std::mutex> guard(trace.mutex);
+    thread = ++trace.next_thread;
+    trace.threads.insert(this);
+}
+
+Trace::ThreadSpans::~ThreadSpans() {
+    Registry& trace = registry();
+    std::lock_guard<std::mutex> guard(trace.mutex);
+    std::lock_guard<std::mutex> spans_guard(mutex);
+    for (unsigned int i = 0; i < spans.size(); i++) {
+        trace.ended.push_back(std::make_pair(thread, spans[i]));
+    }
+    trace.threads.erase(this);
+}
+
+void Trace::addSpan(const char* name, long long begin, long long end) {
+    if (!isOn()) {
+        return ;
+    }
+    ThreadSpans& thread = local();
+    Span span = { name, begin, end };
+    std::lock_guard<std::mutex> guard(thread.mutex);
+    thread.spans.push_back(span);
+}
+
+void Trace::start() {
+    Registry& trace = registry();
+    std::lock_guard<std::mutex> guard(trace.mutex);
+    for (std::unordered_set<ThreadSpans*>::const_iterator it =
+            trace.threads.begin(); it != trace.threads.end(); ++it) {
+        std::lock_guard<std::mutex> spans_guard((**it).mutex);
+        (**it).spans.clear();
+    }
+    trace.ended.clear();
+    trace.started = now();
+    on.store(true, std::memory_order_relaxed);
+}
+
+void Trace::stop(std::ostream& os) {
+    on.store(false, std::memory_order_relaxed);
+    std::vector<std::pair<int, Span> > spans;
+    Registry& trace = registry();
+    long long started;
+    {
+        std::lock_guard<std::mutex> guard(trace.mutex);
+        spans.swap(trace.ended);
+        for (std::unordered_set<ThreadSpans*>::const_iterator it =
+                trace.threads.begin(); it != trace.threads.end(); ++it) {
+            std::lock_guard<std::mutex> spans_guard((**it).mutex);
+            for (unsigned int i = 0; i < (**it).spans.size(); i++) {
+                spans.push_back(std::make_pair((**it).thread,
+                                               (**it).spans[i]));
+            }
+            (**it).spans.clear();
+        }
+        started = trace.started;
+    }
+    std::ios::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+    os << std::fixed << std::setprecision(3);
+    os << "{\"traceEvents\":[";
+    for (unsigned int i = 0; i < spans.size(); i++) {
+        const Span& span = spans[i].second;
+        os << (i == 0 ? "" : ",") << std::endl
+           << "{\"name\":\"" << span.name << "\",\"cat\":\"world\","
+           << "\"ph\":\"X\",\"ts\":" << (span.begin - started) / 1000.0
+           << ",\"dur\":" << (span.end - span.begin) / 1000.0
+           << ",\"pid\":1,\"tid\":" << spans[i].first << "}";
+    }
+    os << std::endl << "],\"displayTimeUnit\":\"ns\"}" << std::endl;
+    os.flags(flags);
+    os.precision(precision);
+}
@@ -0,0 +1,151 @@
+#ifndef MTM4_TRACE_H
+#define MTM4_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace mtm{
+
+    /**
+     * Trace spans of the simulation: what ran, on which thread, when and for
+     * how long, written in the Chrome trace JSON format (chrome://tracing
+     * or Perfetto open it).
+     *
+     * Tracing is turned on and off while the program runs. When it is off,
+     * a span only loads a flag. When it is on, every thread keeps its spans
+     * in its own buffer, that only the thread and stop lock, and stop
+     * writes the spans of all the threads, the ended ones too.
+     *
+     * Spans are made with MTM_TRACE, that does nothing when the build
+     * defines MTM_NO_METRICS (the WORLD_METRICS option of cmake), like the
+     * metrics (Metrics.h).
+     */
+    class Trace{
+        /**
+         * A span: its name, and when it began and ended, in nanoseconds of
+         * the steady clock.
+         */
+        struct Span{
+            const char* name;
+            long long begin;
+            long long end;
+        };
+
+        /**
+         * The spans of a thread, and the number the trace gives the thread.
+         */
+        struct ThreadSpans{
+            std::mutex mutex;
+            std::vector<Span> spans;
+            int thread;
+
+            /**
+             * Number the thread and register its spans.
+             */
+            ThreadSpans();
+
+            /**
+             * Move the spans to those of the ended threads, and unregister
+             * them.
+             */
+            ~ThreadSpans();
+        };
+
+        /**
+         * The buffers of the running threads, and the spans of the ended
+         * threads (Trace.cpp).
+         */
+        struct Registry;
+
+        static std::atomic<bool> on;
+
+        /**
+         * A private function that gets the registry, made on the first
+         * call.
+         */
+        static Registry& registry();
+
+        /**
+         * A private function that gets the spans of the thread that calls
+         * it, registering them on the first call.
+         */
+        static ThreadSpans& local() {
+            static thread_local ThreadSpans spans;
+            return spans;
+        }
+
+    public:
+        /**
+         * @return true if tracing is on.
+         */
+        static bool isOn() {
+            return on.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @return Now, in nanoseconds of the steady clock.
+         */
+        static long long now() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch())
+                    .count();
+        }
+
+        /**
+         * Keep a span of the calling thread, if tracing is on.
+         * @param name The name of the span, a string that lives as long as
+         *  the program (a literal).
+         * @param begin When it began, from now().
+         * @param end When it ended, from now().
+         */
+        static void addSpan(const char* name, long long begin,
+                            long long end);
+
+        /**
+         * Turn tracing on, and drop the spans of the last trace.
+         */
+        static void start();
+
+        /**
+         * Turn tracing off, and write the spans since start to the ostream
+         * as a Chrome trace: a "traceEvents" array of complete events ("ph"
+         * is "X"), with their start ("ts") and duration ("dur") in
+         * microseconds from the start of the trace, and the thread ("tid")
+         * they ran on.
+         * @param os The ostream to write into.
+         */
+        static void stop(std::ostream& os);
+    };
+
+    /**
+     * A span that begins when it is made and ends when it goes out of
+     * scope, if tracing was on when it began.
+     */
+    class TraceSpan{
+        const char* name;
+        long long begin;
+    public:
+        explicit TraceSpan(const char* name) : name(name),
+                begin(Trace::isOn() ? Trace::now() : -1) {}
+
+        TraceSpan(const TraceSpan&) = delete;
+        TraceSpan& operator=(const TraceSpan&) = delete;
+
+        ~TraceSpan() {
+            if (begin >= 0) {
+                Trace::addSpan(name, begin, Trace::now());
+            }
+        }
+    };
+} // namespace mtm
+
+#ifdef MTM_NO_METRICS
+#define MTM_TRACE(name) ((void)0)
+#else
+#define MTM_TRACE(name) mtm::TraceSpan trace_span(name)
+#endif
+
+#endif //MTM4_TRACE_H
@@ -0,0 +1,267 @@
+#include "UndoLog.h"
+#include "World.h"
+#include <algorithm>
+#include <set>
+
+using namespace mtm ;
+using std::string ;
+/**
+ * UndoLog.cpp , all functions are explained in UndoLog.h .
+ */
+
+UndoLog::UndoLog(World& world) : area_count(world.areas_by_id.size()),
+                                 groups(), saved_groups(), areas(),
+                                 saved_areas(), clans(), rosters(),
+                                 clan_names(), roads(), commands() {
+    world.group_names.beginUndo();
+}
+
+void UndoLog::saveGroup(const GroupPointer& group) {
+    if (saved_groups.insert(group.get()).second) {
+        groups.push_back(std::make_pair(group, *group));
+    }
+}
+
+void UndoLog::saveArea(World& world, const AreaSlot& slot) {
+    if ((slot.id >= area_count) || !saved_areas.insert(slot.id).second) {
+        return ;
+    }
+    const Area& area = world.getArea(slot);
+    AreaImage image = { slot.id, area.groups, nullptr, 0, area.stats.fights,
+                        area.stats.trades };
+    if (slot.type == MOUNTAIN) {
+        image.ruler = world.mountains[slot.index].ruler;
+        image.ruler_changes = world.mountains[slot.index].ruler_changes;
+    }
+    for (unsigned int i = 0; i < image.groups.size(); i++) {
+        saveGroup(image.groups[i]);
+    }
+    areas.push_back(std::move(image));
+}
+
+void UndoLog::saveClan(World& world, const string& clan_name) {
+    if (clans.count(clan_name) != 0) {
+        return ;
+    }
+    map<string, Clan>::const_iterator it = world.clan_map.find(clan_name);
+    if (it == world.clan_map.end()) {
+        clans[clan_name].reset();
+        return ;
+    }
+    Clan* saved = new Clan(it->second);
+    clans[clan_name].reset(saved);
+    if (rosters.erase(clan_name) != 0) {
+        //the clan saved its groups since the transaction began.
+        (*saved).undo();
+    }
+}
+
+void UndoLog::saveRoster(World& world, const string& clan_name) {
+    if ((clans.count(clan_name) != 0) || (rosters.count(clan_name) != 0)) {
+        return ;
+    }
+    map<string, Clan>::iterator it = world.clan_map.find(clan_name);
+    if (it == world.clan_map.end()) {
+        saveClan(world, clan_name);
+        return ;
+    }
+    (it->second).beginUndo();
+    rosters.insert(clan_name);
+}
+
+void UndoLog::saveAddClan(World& world, const string& clan_name) {
+    saveClan(world, clan_name);
+    clan_names.push_back(clan_name);
+}
+
+void UndoLog::saveArrival(World& world, const string& clan_name,
+                          const AreaSlot& destination) {
+    saveArea(world, destination);
+    saveRoster(world, clan_name);
+    ArrivalFootprint footprint;
+    World::ArrivalFootprintOf footprint_of = { clan_name, world.clan_map,
+                                               footprint };
+    world.visitArea(destination, footprint_of);
+    for (unsigned int i = 0; i < footprint.clans.size(); i++) {
+        saveRoster(world, footprint.clans[i]);
+    }
+}
+
+void UndoLog::saveMove(World& world, const string& group_name,
+                       const AreaSlot& source, const AreaSlot& destination) {
+    saveArea(world, source);
+    saveArrival(world, world.findClanThatHasGroup(group_name), destination);
+}
+
+void UndoLog::saveRoad(World& world, const AreaSlot& from,
+                       const AreaSlot& to) {
+    const std::vector<int>& into = world.reachability.getRoadsInto(to.id);
+    if (std::find(into.begin(), into.end(), from.id) == into.end()) {
+        roads.push_back(std::make_pair(from.id, to.id));
+    }
+}
+
+void UndoLog::saveFriends(World& world, const string& clan1,
+                          const string& clan2) {
+    saveClan(world, clan1);
+    saveClan(world, clan2);
+}
+
+void UndoLog::saveUnite(World& world, const string& clan1,
+                        const string& clan2, const string& new_name) {
+    if (world.used_clan_names.count(new_name) == 0) {
+        clan_names.push_back(new_name);
+    }
+    saveClan(world, new_name);
+    const string names[] = { clan1, clan2 };
+    for (int i = 0; i < 2; i++) {
+        const Clan& clan = world.clan_map.at(names[i]);
+        saveClan(world, names[i]);
+        //the friends of both clans become friends of the united clan.
+        for (std::unordered_set<string>::const_iterator it =
+                clan.friends_index.begin(); it != clan.friends_index.end();
+             ++it) {
+            saveClan(world, *it);
+        }
+        //the groups change clan, and their areas rank them again.
+        for (Clan::const_iterator it = clan.begin(); it != clan.end(); ++it) {
+            saveGroup(*it);
+            const Area* area = world.group_names.getArea((**it).getName());
+            if (area != nullptr) {
+                saveArea(world, world.areas_map.at((*area).getName()));
+            }
+        }
+    }
+}
+
+void UndoLog::record(const Command& command) {
+    commands.push_back(command);
+}
+
+const std::vector<Command>& UndoLog::getCommands() const {
+    return commands;
+}
+
+void UndoLog::commit(World& world) {
+    world.group_names.endUndo();
+    for (std::unordered_set<string>::const_iterator it = rosters.begin();
+         it != rosters.end(); ++it) {
+        world.clan_map.at(*it).endUndo();
+    }
+    //a clan that was united kept saving its groups in the united clan.
+    for (std::unordered_map<string, std::unique_ptr<Clan> >::const_iterator
+                 it = clans.begin(); it != clans.end(); ++it) {
+        map<string, Clan>::iterator clan = world.clan_map.find(it->first);
+        if (clan != world.clan_map.end()) {
+            (clan->second).endUndo();
+        }
+    }
+}
+
+void UndoLog::rollback(World& world) {
+    for (unsigned int i = 0; i < groups.size(); i++) {
+        *(groups[i].first) = groups[i].second;
+    }
+    for (std::unordered_set<string>::const_iterator it = rosters.begin();
+         it != rosters.end(); ++it) {
+        world.clan_map.at(*it).undo();
+        world.dirty_clans.insert(*it);
+    }
+    for (std::unordered_map<string, std::unique_ptr<Clan> >::const_iterator
+                 it = clans.begin(); it != clans.end(); ++it) {
+        world.clan_map.erase(it->first);
+        if (it->second != nullptr) {
+            world.clan_map.insert(std::pair<string, Clan>(
+                    it->first, *(it->second))).first->second.rankIn(
+                    &world.clan_leaders);
+        }
+        world.dirty_clans.insert(it->first);
+    }
+    for (unsigned int i = 0; i < clan_names.size(); i++) {
+        world.used_clan_names.erase(clan_names[i]);
+    }
+    //a group that traded is ranked again by its clan, even if the clan
+    //wasn't saved.
+    for (unsigned int i = 0; i < groups.size(); i++) {
+        map<string, Clan>::iterator clan =
+                world.clan_map.find((*(groups[i].first)).getClan());
+        if (clan != world.clan_map.end()) {
+            (clan->second).rerankGroup(groups[i].first);
+        }
+    }
+    world.group_names.undo();
+    for (unsigned int i = 0; i < areas.size(); i++) {
+        const AreaSlot& slot = world.areas_by_id[areas[i].id]->second;
+        Area& area = world.getArea(slot);
+        area.groups = areas[i].groups;
+        area.stats.fights = areas[i].fights;
+        area.stats.trades = areas[i].trades;
+        if (slot.type == MOUNTAIN) {
+            world.mountains[slot.index].ruler = areas[i].ruler;
+            world.mountains[slot.index].ruler_changes =
+                    areas[i].ruler_changes;
+        }
+        //the groups are back in their order, rank them again.
+        world.visitArea(slot, World::GroupsRefresh());
+        world.dirty_areas[slot.id] = true;
+    }
+    for (unsigned int i = 0; i < roads.size(); i++) {
+        if (roads[i].first < area_count) {
+            const AreaSlot& from = world.areas_by_id[roads[i].first]->second;
+            world.getArea(from).reachable_areas.erase(
+                    world.areas_by_id[roads[i].second]->first);
+        }
+    }
+    if (!roads.empty() ||
+            (static_cast<int>(world.areas_by_id.size()) != area_count)) {
+        rebuildReachability(world);
+    }
+    removeAddedAreas(world);
+}
+
+void UndoLog::removeAddedAreas(World& world) {
+    for (int id = world.areas_by_id.size() - 1; id >= area_count; id--) {
+        const AreaSlot slot = world.areas_by_id[id]->second;
+        world.getArea(slot).groups.clear();
+        if (slot.type == MOUNTAIN) {
+            world.mountains[slot.index].ruler = nullptr;
+            world.mountains[slot.index].ruler_changes = 0;
+        }
+        world.visitArea(slot, World::GroupsRefresh());
+        world.unpublishArea(id);
+        switch (slot.type) {
+            case PLAIN :
+                world.plains.pop_back();
+                break ;
+            case MOUNTAIN :
+                world.mountains.pop_back();
+                break ;
+            case RIVER :
+                world.rivers.pop_back();
+                break ;
+        }
+        world.areas_map.erase(world.areas_by_id[id]);
+        world.areas_by_id.pop_back();
+        world.dirty_areas.pop_back();
+        world.published_groups.pop_back();
+    }
+}
+
+void UndoLog::rebuildReachability(World& world) {
+    std::set<std::pair<int, int> > added(roads.begin(), roads.end());
+    std::vector<std::vector<int> > into(area_count);
+    ReachabilityIndex rebuilt;
+    for (int to = 0; to < area_count; to++) {
+        rebuilt.addArea();
+        const std::vector<int>& roads_into =
+                world.reachability.getRoadsInto(to);
+        for (unsigned int i = 0; i < roads_into.size(); i++) {
+            if ((roads_into[i] < area_count) &&
+                    (added.count(std::make_pair(roads_into[i], to)) == 0)) {
+                into[to].push_back(roads_into[i]);
+            }
+        }
+    }
+    rebuilt.addRoads(into);
+    world.reachability = std::move(rebuilt);
+}
@@ -0,0 +1,176 @@
+#ifndef MTM4_UNDO_LOG_H
+#define MTM4_UNDO_LOG_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "Clan.h"
+#include "CommandLog.h"
+
+namespace mtm{
+
+    class World;
+    struct AreaSlot;
+
+    /**
+     * The changes of a world transaction (World::beginTransaction), so the
+     * world can be put back the way it was when the transaction began.
+     *
+     * Before an operation of the transaction changes something for the
+     * first time, the log saves what it was:
+     *  - the stats of a group (its name, clan, people, tools, food and
+     *    morale).
+     *  - the groups of an area, in their order, and the ruler of a
+     *    mountain.
+     *  - a whole clan, or that there was no such clan, before it is added,
+     *    united or made friends with.
+     *  - the roads and the clan names that were added.
+     * A clan that groups only join or leave saves its own groups, like the
+     * name index of the world (GroupNames.h) saves its own names.
+     * Areas that were added are removed on rollback. Everything is saved
+     * once, before its first change, so the log and the rollback cost as
+     * much as the groups, areas and clans the transaction touched.
+     *
+     * It also keeps the commands of the transaction, for the journal to
+     * get them only if the transaction is committed.
+     */
+    class UndoLog{
+        /**
+         * The groups of an area, its ruler and its fights and trades, as
+         * they were.
+         */
+        struct AreaImage{
+            int id;
+            std::vector<GroupPointer> groups;
+            GroupPointer ruler;
+            int ruler_changes;
+            int fights;
+            int trades;
+        };
+
+        int area_count;
+        std::vector<std::pair<GroupPointer, Group> > groups;
+        std::unordered_set<const Group*> saved_groups;
+        std::vector<AreaImage> areas;
+        std::unordered_set<int> saved_areas;
+        std::unordered_map<std::string, std::unique_ptr<Clan> > clans;
+        std::unordered_set<std::string> rosters;
+        std::vector<std::string> clan_names;
+        std::vector<std::pair<int, int> > roads;
+        std::vector<Command> commands;
+
+        /**
+         * A private function that saves the stats of a group, if they
+         * weren't saved yet.
+         */
+        void saveGroup(const GroupPointer& group);
+
+        /**
+         * A private function that saves the groups of an area, their stats
+         * and its ruler, if the area was there when the transaction began
+         * and it wasn't saved yet.
+         */
+        void saveArea(World& world, const AreaSlot& slot);
+
+        /**
+         * A private function that saves a whole clan, or that there is no
+         * clan with the name, if it wasn't saved yet.
+         */
+        void saveClan(World& world, const std::string& clan_name);
+
+        /**
+         * A private function that lets a clan save its own groups before
+         * they join or leave it, if it wasn't saved yet.
+         */
+        void saveRoster(World& world, const std::string& clan_name);
+
+        /**
+         * A private function that removes the areas that were added in the
+         * transaction, from the last one.
+         */
+        void removeAddedAreas(World& world);
+
+        /**
+         * A private function that builds the reachability index again,
+         * without the roads and areas the transaction added.
+         */
+        void rebuildReachability(World& world);
+
+    public:
+        /**
+         * Start the log of a transaction.
+         * @param world The world, as it is when the transaction begins.
+         */
+        explicit UndoLog(World& world);
+
+        UndoLog(const UndoLog&) = delete;
+        UndoLog& operator=(const UndoLog&) = delete;
+
+        /**
+         * Save what a clan that will be added was: nothing.
+         */
+        void saveAddClan(World& world, const std::string& clan_name);
+
+        /**
+         * Save everything a group arriving to an area can change: the area
+         * and its groups, the clan of the group, and the clans of the groups
+         * it can fight.
+         */
+        void saveArrival(World& world, const std::string& clan_name,
+                         const AreaSlot& destination);
+
+        /**
+         * Save everything a move can change: the area the group leaves, and
+         * everything its arrival can change.
+         */
+        void saveMove(World& world, const std::string& group_name,
+                      const AreaSlot& source, const AreaSlot& destination);
+
+        /**
+         * Save a road that will be added, if there is no such road yet.
+         */
+        void saveRoad(World& world, const AreaSlot& from,
+                      const AreaSlot& to);
+
+        /**
+         * Save the clans that will become friends.
+         */
+        void saveFriends(World& world, const std::string& clan1,
+                         const std::string& clan2);
+
+        /**
+         * Save everything uniting two clans can change: both clans and
+         * their groups, the new name, the friends of both clans, and the
+         * areas their groups are in.
+         */
+        void saveUnite(World& world, const std::string& clan1,
+                       const std::string& clan2, const std::string& new_name);
+
+        /**
+         * Keep a command of the transaction, for the journal.
+         */
+        void record(const Command& command);
+
+        /**
+         * @return The commands of the transaction, in order.
+         */
+        const std::vector<Command>& getCommands() const;
+
+        /**
+         * Keep the world the way the transaction left it: stop saving.
+         */
+        void commit(World& world);
+
+        /**
+         * Put the world back the way it was when the transaction began.
+         * The areas and clans that were put back are published again by
+         * the next snapshot.
+         */
+        void rollback(World& world);
+    };
+} // namespace mtm
+
+#endif //MTM4_UNDO_LOG_H
@@ -0,0 +1,109 @@
+#include "WorkStealingPool.h"
+
+using namespace mtm ;
+/**
+ * WorkStealingPool.cpp , all functions are explained in WorkStealingPool.h .
+ */
+
+WorkStealingPool::WorkStealingPool(int size) : workers(), threads(),
+                                               state_mutex(), wake(), done(),
+                                               remaining(0), generation(0),
+                                               stopping(false) {
+    if (size < 1) {
+        size = 1;
+    }
+    for (int i = 0; i < size; i++) {
+        workers.push_back(std::unique_ptr<Worker>(new Worker()));
+    }
+    //worker 0 is the thread that calls run.
+    for (int i = 1; i < size; i++) {
+        threads.push_back(std::thread(&WorkStealingPool::threadMain, this, i));
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> guard(state_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (unsigned int i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+}
+
+void WorkStealingPool::run(const std::vector<Task>& tasks) {
+    if (tasks.empty()) {
+        return ;
+    }
+    remaining = tasks.size();
+    for (unsigned int i = 0; i < tasks.size(); i++) {
+        Worker& worker = *workers[i % workers.size()];
+        std::lock_guard<std::mutex> guard(worker.mutex);
+        worker.tasks.push_back(tasks[i]);
+    }
+    {
+        std::lock_guard<std::mutex> guard(state_mutex);
+        generation++;
+    }
+    wake.notify_all();
+    work(0);
+    std::unique_lock<std::mutex> guard(state_mutex);
+    while (remaining != 0) {
+        done.wait(guard);
+    }
+}
+
+int WorkStealingPool::size() const {
+    return workers.size();
+}
+
+bool WorkStealingPool::takeTask(int index, Task& task) {
+    {
+        Worker& own = *workers[index];
+        std::lock_guard<std::mutex> guard(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (unsigned int i = 1; i < workers.size(); i++) {
+        Worker& victim = *workers[(index + i) % workers.size()];
+        std::lock_guard<std::mutex> guard(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::work(int index) {
+    Task task;
+    while (takeTask(index, task)) {
+        task();
+        if (--remaining == 0) {
+            std::lock_guard<std::mutex> guard(state_mutex);
+            done.notify_all();
+        }
+    }
+}
+
+void WorkStealingPool::threadMain(int index) {
+    unsigned long seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(state_mutex);
+            while (!stopping && generation == seen) {
+                wake.wait(guard);
+            }
+            if (stopping) {
+                return ;
+            }
+            seen = generation;
+        }
+        work(index);
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef MTM4_WORK_STEALING_POOL_H
+#define MTM4_WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mtm{
+
+    /**
+     * A pool of threads that runs a set of tasks and waits for all of them.
+     * Every thread has its own queue of tasks. A thread takes tasks from the
+     * back of its own queue, and when it runs out, it steals tasks from the
+     * front of the queues of the other threads, so threads that got longer
+     * tasks don't hold the others back.
+     * The thread that calls run works on the tasks too.
+     */
+    class WorkStealingPool{
+        typedef std::function<void()> Task;
+        struct Worker{
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        std::vector<std::unique_ptr<Worker> > workers;
+        std::vector<std::thread> threads;
+        std::mutex state_mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        std::atomic<int> remaining;
+        unsigned long generation;
+        bool stopping;
+
+        /**
+         * A private function that takes the next task for a worker: from its
+         * own queue if it has one, otherwise from another worker.
+         * @param
+         * index - the number of the worker.
+         * task - where to put the task.
+         * @return
+         * true if a task was taken , false if all the queues are empty .
+         */
+        bool takeTask(int index, Task& task);
+
+        /**
+         * A private function that runs tasks until all the queues are empty.
+         * @param
+         * index - the number of the worker that runs them.
+         */
+        void work(int index);
+
+        /**
+         * The function every thread of the pool runs.
+         * @param
+         * index - the number of the worker of the thread.
+         */
+        void threadMain(int index);
+
+    public:
+        /**
+         * @param size The number of threads that run tasks, including the
+         *  thread that calls run. At least 1.
+         */
+        explicit WorkStealingPool(int size);
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        /**
+         * Stops all the threads of the pool.
+         */
+        ~WorkStealingPool();
+
+        /**
+         * Run tasks on the pool, and wait until all of them are done.
+         * Only one thread may call run at a time.
+         * @param tasks The tasks to run, in no particular order.
+         */
+        void run(const std::vector<Task>& tasks);
+
+        /**
+         * @return The number of threads that run tasks.
+         */
+        int size() const;
+    };
+} // namespace mtm
+
+#endif //MTM4_WORK_STEALING_POOL_H
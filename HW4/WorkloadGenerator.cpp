@@ -0,0 +1,132 @@
+#include "WorkloadGenerator.h"
+#include <algorithm>
+#include <cstdlib>
+
+using namespace mtm ;
+using std::string ;
+/**
+ * WorkloadGenerator.cpp , all functions are explained in WorkloadGenerator.h .
+ */
+
+WorkloadGenerator::WorkloadGenerator(int groups, unsigned int seed) :
+        groups(std::max(groups, 1)), clans(std::max(groups / 250, 4)),
+        areas(std::max(groups / 100, 6)), random(seed), phase(CLANS),
+        index(0), move_next(false), group_areas() {
+    group_areas.reserve(this->groups);
+}
+
+bool WorkloadGenerator::next(Command& command) {
+    while (phase != DONE) {
+        switch (phase) {
+            case CLANS :
+                if (index < clans) {
+                    command = Command::fromOperation(
+                            WorldOperation::addClan(clanName(index++)));
+                    return true;
+                }
+                break ;
+            case AREAS :
+                if (index < areas) {
+                    AreaType type = static_cast<AreaType>(index % 3);
+                    command = Command::fromOperation(
+                            WorldOperation::addArea(areaName(index++), type));
+                    return true;
+                }
+                break ;
+            case ROADS :
+                //three roads into every area: from both neighbours and
+                //from a random area.
+                if (index < 3 * areas) {
+                    int area = index / 3;
+                    int from = index % 3 == 0 ? (area + areas - 1) % areas :
+                               index % 3 == 1 ? (area + 1) % areas :
+                               pick(areas);
+                    index++;
+                    command = Command::fromOperation(
+                            WorldOperation::makeReachable(areaName(from),
+                                                          areaName(area)));
+                    return true;
+                }
+                break ;
+            case FRIENDS :
+                if (index < clans / 2) {
+                    index++;
+                    command = Command::fromOperation(
+                            WorldOperation::makeFriends(clanName(pick(clans)),
+                                                        clanName(pick(clans))));
+                    return true;
+                }
+                break ;
+            case GROUPS :
+                if (move_next) {
+                    move_next = false;
+                    command = Command::fromOperation(nextMove());
+                    return true;
+                }
+                if (index < groups) {
+                    int area = pick(areas);
+                    group_areas.push_back(area);
+                    move_next = index % 2 == 1;
+                    int children = pick(20);
+                    int adults = 1 + pick(40);
+                    command = Command::fromOperation(
+                            WorldOperation::addGroup(groupName(index++),
+                                    clanName(pick(clans)), children, adults,
+                                    areaName(area)));
+                    return true;
+                }
+                break ;
+            case UNITES :
+                //unites clan 2k with clan 2k+1, for a tenth of the clans.
+                if (index < clans / 10) {
+                    command = Command::fromOperation(
+                            WorldOperation::uniteClans(clanName(2 * index),
+                                    clanName(2 * index + 1),
+                                    "united" + std::to_string(index)));
+                    index++;
+                    return true;
+                }
+                break ;
+            case PRINTS :
+                if (index < std::max(groups / 100, 10)) {
+                    command = index % 10 == 9 ?
+                              Command::printClan(clanName(pick(clans))) :
+                              Command::printGroup(groupName(pick(groups)));
+                    index++;
+                    return true;
+                }
+                break ;
+            case DONE :
+                break ;
+        }
+        nextPhase();
+    }
+    return false;
+}
+
+WorldOperation WorkloadGenerator::nextMove() {
+    int group = pick(group_areas.size());
+    int step = pick(2) == 0 ? areas - 1 : 1;
+    group_areas[group] = (group_areas[group] + step) % areas;
+    return WorldOperation::moveGroup(groupName(group),
+                                     areaName(group_areas[group]));
+}
+
+int WorkloadGenerator::scenarioGroups(const string& scenario) {
+    if (scenario == "1k") {
+        return 1000;
+    }
+    if (scenario == "100k") {
+        return 100000;
+    }
+    if (scenario == "1m") {
+        return 1000000;
+    }
+    char* end = nullptr;
+    long groups = std::strtol(scenario.c_str(), &end, 10);
+    if (scenario.empty() || (*end != '\0') || (groups <= 0) ||
+            (groups > 100000000)) {
+        return 0;
+    }
+    return static_cast<int>(groups);
+}
@@ -0,0 +1,109 @@
+#ifndef MTM4_WORKLOAD_GENERATOR_H
+#define MTM4_WORKLOAD_GENERATOR_H
+
+#include <random>
+#include <string>
+#include <vector>
+#include "CommandLog.h"
+
+namespace mtm{
+
+    /**
+     * Generates a command log for a world with a given number of groups.
+     * The same number of groups and seed always give the same commands.
+     *
+     * The world has a clan for every 250 groups and an area for every 100
+     * groups (at least 4 clans and 6 areas). The area types take turns.
+     * Every area is reachable from the area before it and the area after
+     * it, and from one more random area.
+     * The commands come in this order:
+     *  - The clans and the areas, then the roads between the areas.
+     *  - Friendships between random clans.
+     *  - The groups, each added to a random clan and area. After every
+     *    second group, a random group that was already added moves to the
+     *    area next to it.
+     *  - Unites of some of the clans.
+     *  - Prints of some groups and clans.
+     * The generator doesn't run the rules of the areas, so some moves and
+     * prints name groups that already lost all their people, or were
+     * united into other groups. The world reports these as failures.
+     */
+    class WorkloadGenerator{
+        enum Phase{
+            CLANS, AREAS, ROADS, FRIENDS, GROUPS, UNITES, PRINTS, DONE
+        };
+        int groups;
+        int clans;
+        int areas;
+        std::mt19937 random;
+        Phase phase;
+        int index;
+        bool move_next;
+        std::vector<int> group_areas;
+
+        /**
+         * A private function that picks a random number.
+         * @param
+         * bound - the number of options.
+         * @return
+         * a number in [0, bound) .
+         */
+        int pick(int bound) {
+            return static_cast<int>(random() % static_cast<unsigned>(bound));
+        }
+
+        /**
+         * A private function that moves to the next phase of the log.
+         */
+        void nextPhase() {
+            phase = static_cast<Phase>(phase + 1);
+            index = 0;
+        }
+
+    public:
+        /**
+         * @param groups The number of groups to add, at least 1.
+         * @param seed The seed of the random choices.
+         */
+        explicit WorkloadGenerator(int groups, unsigned int seed = 2017);
+
+        /**
+         * Generate the next command.
+         * @param command Where to put the command.
+         * @return true if a command was generated, false if the log ended.
+         */
+        bool next(Command& command);
+
+        /**
+         * Generate a move of a random group that was already added, to the
+         * area before or after the area the generator thinks it is in.
+         * @return The move. There has to be a group already.
+         */
+        WorldOperation nextMove();
+
+        /**
+         * @param scenario "1k", "100k" or "1m", or a number of groups.
+         * @return The number of groups of the scenario, 0 if it isn't a
+         *  scenario.
+         */
+        static int scenarioGroups(const std::string& scenario);
+
+        /**
+         * The names the generator gives to the clans, areas and groups it
+         * adds, by the order they are added (from 0).
+         */
+        static std::string clanName(int clan) {
+            return "clan" + std::to_string(clan);
+        }
+
+        static std::string areaName(int area) {
+            return "area" + std::to_string(area);
+        }
+
+        static std::string groupName(int group) {
+            return "group" + std::to_string(group);
+        }
+    };
+} // namespace mtm
+
+#endif //MTM4_WORKLOAD_GENERATOR_H
@@ -1,4 +1,11 @@
 #include "World.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
 
 using namespace mtm ;
 using  std::ostream ;
@@ -6,132 +13,1012 @@ using std::endl;
 /**
  * World.cpp , all functions are explained in World.h .
  */
-World::World(): clan_map(),areas_map() {}
+World::World(): group_names(), clan_leaders(), clan_map(),
+                used_clan_names(), plains(),
+                mountains(), rivers(), areas_map(), reachability(),
+                areas_by_id(), scheduler(), current_tick(0),
+                scheduler_stats(), pool(), next_snapshot(),
+                published(new WorldSnapshot()), dirty_areas(), dirty_clans(),
+                published_groups(), journal(), checkpoint_position(),
+                transaction() {
+    scheduler_stats.events_processed = 0;
+    scheduler_stats.seconds = 0;
+    checkpoint_position.generation = -1;
+    checkpoint_position.offset = 0;
+}
 
 void World::addClan(const string& new_clan){
+    throwResult(tryAddClan(new_clan));
+}
+
+void World::addArea(const string& area_name, AreaType type){
+    throwResult(tryAddArea(area_name, type));
+}
+
+void World::addGroup(const string& group_name, const string& clan_name, int
+num_children, int num_adults, const string& area_name) {
+    throwResult(tryAddGroup(group_name, clan_name, num_children, num_adults,
+                            area_name));
+}
+
+void World::makeReachable(const string& from, const string& to){
+    throwResult(tryMakeReachable(from, to));
+}
+
+void World::moveGroup(const string& group_name, const string& destination){
+    throwResult(tryMoveGroup(group_name, destination));
+}
+
+bool World::canReach(const string& from, const string& to) const {
+    bool reachable = false;
+    throwResult(tryCanReach(from, to, reachable));
+    return reachable;
+}
+
+void World::moveGroupVia(const string& group_name, const string& destination){
+    throwResult(tryMoveGroupVia(group_name, destination));
+}
+
+void World::makeFriends(const string& clan1, const string& clan2) {
+    throwResult(tryMakeFriends(clan1, clan2));
+}
+
+void World::uniteClans(const string& clan1, const string& clan2, const
+string& new_name) {
+    throwResult(tryUniteClans(clan1, clan2, new_name));
+}
+
+WorldResult World::tryAddClan(const string& new_clan) {
+    MTM_TIME(METRIC_CALL_ADD_CLAN);
+    return journaled(applyAddClan(new_clan),
+                     WorldOperation::addClan(new_clan));
+}
+
+WorldResult World::tryAddArea(const string& area_name, AreaType type) {
+    MTM_TIME(METRIC_CALL_ADD_AREA);
+    return journaled(applyAddArea(area_name, type),
+                     WorldOperation::addArea(area_name, type));
+}
+
+WorldResult World::tryAddGroup(const string& group_name,
+                               const string& clan_name, int num_children,
+                               int num_adults, const string& area_name) {
+    MTM_TIME(METRIC_CALL_ADD_GROUP);
+    return journaled(applyAddGroup(group_name, clan_name, num_children,
+                                   num_adults, area_name, nullptr),
+                     WorldOperation::addGroup(group_name, clan_name,
+                                              num_children, num_adults,
+                                              area_name));
+}
+
+WorldResult World::tryMakeReachable(const string& from, const string& to) {
+    MTM_TIME(METRIC_CALL_MAKE_REACHABLE);
+    return journaled(applyMakeReachable(from, to, nullptr),
+                     WorldOperation::makeReachable(from, to));
+}
+
+WorldResult World::tryMoveGroup(const string& group_name,
+                                const string& destination) {
+    MTM_TIME(METRIC_CALL_MOVE_GROUP);
+    return journaled(applyMoveGroup(group_name, destination, nullptr),
+                     WorldOperation::moveGroup(group_name, destination));
+}
+
+WorldResult World::tryMoveGroupVia(const string& group_name,
+                                   const string& destination) {
+    MTM_TIME(METRIC_CALL_MOVE_GROUP_VIA);
+    return applyMoveGroupVia(group_name, destination, nullptr);
+}
+
+WorldResult World::tryMakeFriends(const string& clan1, const string& clan2) {
+    MTM_TIME(METRIC_CALL_MAKE_FRIENDS);
+    return journaled(applyMakeFriends(clan1, clan2, nullptr),
+                     WorldOperation::makeFriends(clan1, clan2));
+}
+
+WorldResult World::tryUniteClans(const string& clan1, const string& clan2,
+                                 const string& new_name) {
+    MTM_TIME(METRIC_CALL_UNITE_CLANS);
+    return journaled(applyUniteClans(clan1, clan2, new_name, nullptr),
+                     WorldOperation::uniteClans(clan1, clan2, new_name));
+}
+
+WorldResult World::tryCanReach(const string& from, const string& to,
+                               bool& reachable) const {
+    MTM_TIME(METRIC_CALL_CAN_REACH);
+    map<string,AreaSlot>::const_iterator from_it = areas_map.find(from);
+    map<string,AreaSlot>::const_iterator to_it = areas_map.find(to);
+    if ((from_it == areas_map.end()) || (to_it == areas_map.end())) {
+        return WORLD_AREA_NOT_FOUND ;
+    }
+    reachable = (from == to) ||
+                reachability.canReach(from_it->second.id, to_it->second.id);
+    return WORLD_SUCCESS ;
+}
+
+WorldResult World::apply(const WorldOperation& operation) {
+    MTM_TIME(METRIC_CALL_APPLY);
+    return journaled(applyOperation(operation, nullptr), operation);
+}
+
+std::vector<WorldResult> World::applyBatch(
+        const std::vector<WorldOperation>& operations) {
+    MTM_TIME(METRIC_CALL_APPLY_BATCH);
+    LookupCache cache;
+    std::vector<WorldResult> results;
+    results.reserve(operations.size());
+    for (unsigned int i = 0; i < operations.size(); i++) {
+        results.push_back(journaled(applyOperation(operations[i], &cache),
+                                    operations[i]));
+    }
+    return results;
+}
+
+std::vector<WorldResult> World::applyBatchConcurrently(
+        const std::vector<WorldOperation>& operations, int threads) {
+    MTM_TIME(METRIC_CALL_APPLY_BATCH_CONCURRENTLY);
+    if (transaction != nullptr) {
+        //the undo log isn't shared between threads.
+        return applyBatch(operations);
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    if ((pool == nullptr) || ((*pool).size() != threads)) {
+        pool.reset(new WorkStealingPool(threads));
+    }
+    std::vector<WorldResult> results(operations.size(), WORLD_SUCCESS);
+    //the operations that waited for a later wave, in order, all before the
+    //operation in 'next'.
+    std::vector<int> waiting;
+    unsigned int next = 0;
+    std::vector<string> keys;
+    while (!waiting.empty() || next < operations.size()) {
+        std::vector<int> wave;
+        std::vector<int> deferred;
+        std::unordered_set<string> wave_keys;
+        std::unordered_set<string> blocked_keys;
+        bool barrier = false;
+        unsigned int scanned = 0;
+        while (!barrier && scanned < waiting.size() + CONCURRENT_WINDOW &&
+               deferred.size() < CONCURRENT_DEFERRED) {
+            int index;
+            if (scanned < waiting.size()) {
+                index = waiting[scanned];
+            } else if (next < operations.size()) {
+                index = next;
+            } else {
+                break ;
+            }
+            const WorldOperation& operation = operations[index];
+            if (operation.type != MOVE_GROUP) {
+                if (!wave.empty()) {
+                    barrier = true;
+                    continue ;
+                }
+                results[index] = journaled(applyOperation(operation, nullptr),
+                                           operation);
+            } else {
+                keys.clear();
+                addMoveKeys(operation, keys);
+                bool conflict = false;
+                for (unsigned int i = 0; i < keys.size() && !conflict; i++) {
+                    conflict = (wave_keys.count(keys[i]) != 0) ||
+                               (blocked_keys.count(keys[i]) != 0);
+                }
+                if (conflict) {
+                    blocked_keys.insert(keys.begin(), keys.end());
+                    deferred.push_back(index);
+                } else {
+                    wave_keys.insert(keys.begin(), keys.end());
+                    wave.push_back(index);
+                }
+            }
+            if (scanned >= waiting.size()) {
+                next++;
+            }
+            scanned++;
+        }
+        //operations that were not scanned keep waiting, after the deferred.
+        for (unsigned int i = scanned; i < waiting.size(); i++) {
+            deferred.push_back(waiting[i]);
+        }
+        applyWave(wave, operations, results);
+        //the moves of a wave have no key in common, so any order of them is
+        //the order they were applied in.
+        for (unsigned int i = 0; i < wave.size(); i++) {
+            journaled(results[wave[i]], operations[wave[i]]);
+        }
+        waiting.swap(deferred);
+    }
+    return results;
+}
+
+void World::applyWave(const std::vector<int>& wave,
+                      const std::vector<WorldOperation>& operations,
+                      std::vector<WorldResult>& results) {
+    if ((wave.size() < 2) || ((*pool).size() == 1)) {
+        for (unsigned int i = 0; i < wave.size(); i++) {
+            const WorldOperation& move = operations[wave[i]];
+            results[wave[i]] = applyMoveGroup(move.first, move.second,
+                                              nullptr);
+        }
+        return ;
+    }
+    //a few tasks for every thread, so stealing can even out the work.
+    int task_count = std::min<int>(wave.size(), 4 * (*pool).size());
+    std::vector<std::function<void()> > tasks;
+    for (int task = 0; task < task_count; task++) {
+        int begin = wave.size() * task / task_count;
+        int end = wave.size() * (task + 1) / task_count;
+        tasks.push_back([this, &wave, &operations, &results, begin, end]() {
+            for (int i = begin; i < end; i++) {
+                const WorldOperation& move = operations[wave[i]];
+                results[wave[i]] = applyMoveGroup(move.first, move.second,
+                                                  nullptr);
+            }
+        });
+    }
+    group_names.setConcurrent(true);
+    clan_leaders.setConcurrent(true);
+    (*pool).run(tasks);
+    group_names.setConcurrent(false);
+    clan_leaders.setConcurrent(false);
+}
+
+long long World::schedule(long long tick, const WorldOperation& operation) {
+    long long id = 0;
+    throwResult(trySchedule(tick, operation, id));
+    return id;
+}
+
+WorldResult World::trySchedule(long long tick,
+                               const WorldOperation& operation,
+                               long long& id) {
+    MTM_TIME(METRIC_CALL_SCHEDULE);
+    if (transaction != nullptr) {
+        return WORLD_TRANSACTION_ACTIVE ;
+    }
+    if (tick < current_tick) {
+        return WORLD_INVALID_ARGUMENT ;
+    }
+    id = scheduler.schedule(tick, operation);
+    record(Command::schedule(tick, operation));
+    return WORLD_SUCCESS ;
+}
+
+std::vector<EventResult> World::advanceTo(long long tick) {
+    std::vector<EventResult> results;
+    throwResult(tryAdvanceTo(tick, results));
+    return results;
+}
+
+WorldResult World::tryAdvanceTo(long long tick,
+                                std::vector<EventResult>& results) {
+    MTM_TIME(METRIC_CALL_ADVANCE_TO);
+    if (transaction != nullptr) {
+        return WORLD_TRANSACTION_ACTIVE ;
+    }
+    if (tick < current_tick) {
+        return WORLD_INVALID_ARGUMENT ;
+    }
+    std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+    results.clear();
+    LookupCache cache;
+    while (scheduler.hasEventUntil(tick)) {
+        ScheduledEvent event = scheduler.takeNext();
+        current_tick = event.tick;
+        EventResult result = { event.tick, event.id,
+                               applyOperation(event.operation, &cache) };
+        results.push_back(result);
+    }
+    current_tick = tick;
+    record(Command::advance(tick));
+    scheduler_stats.events_processed += results.size();
+    scheduler_stats.seconds += std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+    return WORLD_SUCCESS ;
+}
+
+long long World::getCurrentTick() const {
+    return current_tick;
+}
+
+int World::getPendingEvents() const {
+    return scheduler.size();
+}
+
+SchedulerStats World::getSchedulerStats() const {
+    return scheduler_stats;
+}
+
+WorldResult World::applyOperation(const WorldOperation& operation,
+                                  LookupCache* cache) {
+    switch (operation.type) {
+        case ADD_CLAN :
+            return applyAddClan(operation.first);
+        case ADD_AREA :
+            return applyAddArea(operation.first, operation.area_type);
+        case MAKE_REACHABLE :
+            return applyMakeReachable(operation.first, operation.second,
+                                      cache);
+        case ADD_GROUP :
+            return applyAddGroup(operation.first, operation.second,
+                                 operation.children, operation.adults,
+                                 operation.third, cache);
+        case MOVE_GROUP :
+            return applyMoveGroup(operation.first, operation.second, cache);
+        case MAKE_FRIENDS :
+            return applyMakeFriends(operation.first, operation.second, cache);
+        case UNITE_CLANS :
+            return applyUniteClans(operation.first, operation.second,
+                                   operation.third, cache);
+    }
+    return WORLD_INVALID_ARGUMENT ;
+}
+
+WorldResult World::applyAddClan(const string& new_clan){
     if (new_clan.empty()){
-        throw WorldInvalidArgument() ;
+        return WORLD_INVALID_ARGUMENT ;
+    }
+    if (used_clan_names.count(new_clan) != 0){
+        return WORLD_CLAN_NAME_IS_TAKEN ;
     }
-    if (checkClanExiest(new_clan)){
-        throw WorldClanNameIsTaken() ;
+    if (transaction != nullptr) {
+        (*transaction).saveAddClan(*this, new_clan);
     }
-    Clan clan(new_clan);
-    clan_map.insert(std::pair<string,Clan>(new_clan,clan));
+    clan_map.insert(std::pair<string,Clan>(new_clan,Clan(new_clan))).
+            first->second.rankIn(&clan_leaders);
+    used_clan_names.insert(new_clan);
+    dirty_clans.insert(new_clan);
+    return WORLD_SUCCESS ;
 }
 
-void World::addArea(const string& area_name, AreaType type){
+WorldResult World::applyAddArea(const string& area_name, AreaType type){
     if (area_name.empty()){
-        throw WorldInvalidArgument() ;
+        return WORLD_INVALID_ARGUMENT ;
     }
     if (checkAreaExiest(area_name)){
-        throw WorldAreaNameIsTaken() ;
+        return WORLD_AREA_NAME_IS_TAKEN ;
     }
+    AreaSlot slot = { type, 0, reachability.addArea() };
     switch (type) {
-        case PLAIN : {
-            AreaPtr new_plain(new Plain(area_name));
-            areas_map.insert(std::pair<string, AreaPtr>(area_name, new_plain));
-            break;
-        }
-        case MOUNTAIN : {
-            AreaPtr new_mountain(new Mountain(area_name));
-            areas_map.insert(
-                    std::pair<string, AreaPtr>(area_name, new_mountain));
-            break;
-        }
-        case RIVER  : {
-            AreaPtr new_river (new River(area_name));
-           areas_map.insert(std::pair<string,AreaPtr>(area_name,new_river));
+        case PLAIN :
+            plains.emplace_back(area_name);
+            slot.index = plains.size() - 1;
+            break ;
+        case MOUNTAIN :
+            mountains.emplace_back(area_name);
+            slot.index = mountains.size() - 1;
+            break ;
+        case RIVER :
+            rivers.emplace_back(area_name);
+            slot.index = rivers.size() - 1;
             break ;
-        }
     }
+    areas_by_id.push_back(
+            areas_map.insert(std::pair<string,AreaSlot>(area_name,slot)).first);
+    getArea(slot).setGroupNames(&group_names);
+    dirty_areas.push_back(true);
+    published_groups.push_back(std::vector<PublishedGroup>());
+    return WORLD_SUCCESS ;
 }
 
-void World::addGroup(const string& group_name, const string& clan_name, int
-num_children, int num_adults, const string& area_name) {
+WorldResult World::applyAddGroup(const string& group_name,
+                                 const string& clan_name, int num_children,
+                                 int num_adults, const string& area_name,
+                                 LookupCache* cache) {
     if ((group_name.empty()) ||(num_children<0) || (num_adults<0) ||
             ((num_adults==0)&&(num_children==0))){
-        throw WorldInvalidArgument() ;
+        return WORLD_INVALID_ARGUMENT ;
     }
     if (checkIfGroupNameExiest(group_name)){
-        throw WorldGroupNameIsTaken() ;
+        return WORLD_GROUP_NAME_IS_TAKEN ;
+    }
+    Clan* clan = findClan(clan_name, cache);
+    if (clan == nullptr){
+        return WORLD_CLAN_NOT_FOUND ;
     }
-    if (!checkClanExiest(clan_name)){
-        throw WorldClanNotFound() ;
+    const AreaSlot* slot = findArea(area_name, cache);
+    if (slot == nullptr){
+        return WORLD_AREA_NOT_FOUND ;
     }
-    if (!checkAreaExiest(area_name)){
-        throw WorldAreaNotFound() ;
+    if (transaction != nullptr) {
+        (*transaction).saveArrival(*this, clan_name, *slot);
     }
     //adding the group to the clan map , then adding it to the area.
-    clan_map.at(clan_name).addGroup(Group(group_name,num_children,num_adults));
-    (*(areas_map.at(area_name))).groupArrive(group_name,clan_name,clan_map) ;
+    (*clan).addGroup(Group(group_name,num_children,num_adults));
+    GroupArrival arrival = { group_name, clan_name, clan_map };
+    visitArea(*slot, arrival);
+    dirty_areas[(*slot).id] = true;
+    return WORLD_SUCCESS ;
 }
 
-void World::makeReachable(const string& from, const string& to){
-    if ((!checkAreaExiest(from))|| (!checkAreaExiest(to)) ){
-        throw WorldAreaNotFound() ;
+WorldResult World::applyMakeReachable(const string& from, const string& to,
+                                      LookupCache* cache){
+    const AreaSlot* from_slot = findArea(from, cache);
+    const AreaSlot* to_slot = findArea(to, cache);
+    if ((from_slot == nullptr) || (to_slot == nullptr)){
+        return WORLD_AREA_NOT_FOUND ;
     }
-    (*areas_map.at(from)).addReachableArea(to);
+    if (transaction != nullptr) {
+        (*transaction).saveRoad(*this, *from_slot, *to_slot);
+    }
+    getArea(*from_slot).addReachableArea(to);
+    reachability.addRoad((*from_slot).id, (*to_slot).id);
+    return WORLD_SUCCESS ;
 }
 
-void World::moveGroup(const string& group_name, const string& destination){
-    if (!checkIfGroupNameExiest(group_name)){
-        throw WorldGroupNotFound() ;
+WorldResult World::applyMoveGroup(const string& group_name,
+                                  const string& destination,
+                                  LookupCache* cache){
+    Area* source = group_names.getArea(group_name);
+    if (source == nullptr){
+        return WORLD_GROUP_NOT_FOUND ;
     }
-    if ((!checkAreaExiest(destination))){
-        throw WorldAreaNotFound() ;
+    const AreaSlot* destination_slot = findArea(destination, cache);
+    if (destination_slot == nullptr){
+        return WORLD_AREA_NOT_FOUND ;
     }
-    if((*(areas_map.at(destination))).getGroupsNames().contains(group_name)) {
-        throw WorldGroupAlreadyInArea();
+    if (getArea(*destination_slot).hasGroup(group_name)) {
+        return WORLD_GROUP_ALREADY_IN_AREA ;
     }
-    string area_name = findAreaThatHasGroup(group_name);
-    if (!((*(areas_map.at(area_name))).isReachable(destination))){
-        throw WorldAreaNotReachable();
+    if (!((*source).isReachable(destination))){
+        return WORLD_AREA_NOT_REACHABLE ;
     }
-    string clan_name = findClanThatHasGroup(group_name);
-    //remove the group from the source area , than add it to the destination.
-    (*(areas_map.at(area_name))).groupLeave(group_name);
-    (*(areas_map.at(destination))).groupArrive(group_name,clan_name,clan_map);
+    moveGroupBetween(group_name, *findArea((*source).getName(), cache),
+                     *destination_slot);
+    return WORLD_SUCCESS ;
 }
 
-void World::makeFriends(const string& clan1, const string& clan2) {
-    if ((!checkClanExiest(clan1))||(!checkClanExiest(clan2))){
-        throw WorldClanNotFound() ;
+WorldResult World::applyMoveGroupVia(const string& group_name,
+                                     const string& destination,
+                                     LookupCache* cache){
+    Area* source = group_names.getArea(group_name);
+    if (source == nullptr){
+        return WORLD_GROUP_NOT_FOUND ;
+    }
+    const AreaSlot* destination_slot = findArea(destination, cache);
+    if (destination_slot == nullptr){
+        return WORLD_AREA_NOT_FOUND ;
     }
-    clan_map.at(clan1).makeFriend(clan_map.at(clan2));
+    if (getArea(*destination_slot).hasGroup(group_name)) {
+        return WORLD_GROUP_ALREADY_IN_AREA ;
+    }
+    const AreaSlot* source_slot = findArea((*source).getName(), cache);
+    std::vector<int> path = reachability.shortestPath((*source_slot).id,
+                                                      (*destination_slot).id);
+    if (path.empty()){
+        return WORLD_AREA_NOT_REACHABLE ;
+    }
+    for (unsigned int i = 0; i < path.size(); i++) {
+        const AreaSlot& hop = areas_by_id[path[i]]->second;
+        moveGroupBetween(group_name, *source_slot, hop);
+        record(Command::fromOperation(WorldOperation::moveGroup(
+                group_name, areas_by_id[path[i]]->first)));
+        if (group_names.getArea(group_name) != &getArea(hop)) {
+            break ;
+        }
+        source_slot = &hop;
+    }
+    return WORLD_SUCCESS ;
 }
 
-void World::uniteClans(const string& clan1, const string& clan2, const
-string& new_name) {
+WorldResult World::applyMakeFriends(const string& clan1, const string& clan2,
+                                    LookupCache* cache) {
+    Clan* first = findClan(clan1, cache);
+    Clan* second = findClan(clan2, cache);
+    if ((first == nullptr)||(second == nullptr)){
+        return WORLD_CLAN_NOT_FOUND ;
+    }
+    if (transaction != nullptr) {
+        (*transaction).saveFriends(*this, clan1, clan2);
+    }
+    (*first).makeFriend(*second);
+    return WORLD_SUCCESS ;
+}
+
+WorldResult World::applyUniteClans(const string& clan1, const string& clan2,
+                                   const string& new_name,
+                                   LookupCache* cache) {
     if (new_name.empty()){
-        throw WorldInvalidArgument() ;
+        return WORLD_INVALID_ARGUMENT ;
+    }
+    if ((used_clan_names.count(new_name) != 0) && (new_name != clan1) &&
+            (new_name != clan2)){
+        return WORLD_CLAN_NAME_IS_TAKEN ;
+    }
+    Clan* first = findClan(clan1, cache);
+    Clan* second = findClan(clan2, cache);
+    if ((first == nullptr)||(second == nullptr)){
+        return WORLD_CLAN_NOT_FOUND ;
     }
-    if (checkClanExiest(new_name)){
-        throw WorldClanNameIsTaken() ;
+    if (first == second){
+        return WORLD_CLAN_CANT_UNITE ;
     }
-    if ((!checkClanExiest(clan1))||(!checkClanExiest(clan2))){
-        throw WorldClanNotFound() ;
+    if (transaction != nullptr) {
+        (*transaction).saveUnite(*this, clan1, clan2, new_name);
     }
-    clan_map.at(clan1).unite(clan_map.at(clan2),new_name) ;
-    Clan temp_clan = clan_map.at(clan1) ;
+    (*first).unite(*second,new_name) ;
+    Clan united_clan = std::move(*first) ;
     clan_map.erase(clan1);
     clan_map.erase(clan2);
-    clan_map.insert(std::pair<string,Clan>(new_name,temp_clan));
+    clan_map.insert(std::pair<string,Clan>(new_name,std::move(united_clan))).
+            first->second.rankIn(&clan_leaders);
+    used_clan_names.insert(new_name);
+    dirty_clans.insert(clan1);
+    dirty_clans.insert(clan2);
+    dirty_clans.insert(new_name);
+    if (cache != nullptr) {
+        (*cache).clans.erase(clan1);
+        (*cache).clans.erase(clan2);
+    }
     makeFriendsUnitedClan(clan_map.at(new_name)) ;
+    //the groups changed clan and morale , let their areas rank them again.
+    refreshAreasOfClan(clan_map.at(new_name), cache);
+    return WORLD_SUCCESS ;
 }
 
-void World::printGroup(std::ostream& os, const string& group_name) const {
-    if (!checkIfGroupNameExiest(group_name)){
-        throw WorldGroupNotFound() ;
+void World::throwResult(WorldResult result) {
+    if (result != WORLD_SUCCESS) {
+        MTM_COUNT(static_cast<Metric>(METRIC_THROWN_INVALID_ARGUMENT +
+                                      result - WORLD_INVALID_ARGUMENT));
+    }
+    switch (result) {
+        case WORLD_SUCCESS :
+            return ;
+        case WORLD_INVALID_ARGUMENT :
+            throw WorldInvalidArgument() ;
+        case WORLD_GROUP_NAME_IS_TAKEN :
+            throw WorldGroupNameIsTaken() ;
+        case WORLD_CLAN_NAME_IS_TAKEN :
+            throw WorldClanNameIsTaken() ;
+        case WORLD_AREA_NAME_IS_TAKEN :
+            throw WorldAreaNameIsTaken() ;
+        case WORLD_GROUP_NOT_FOUND :
+            throw WorldGroupNotFound() ;
+        case WORLD_CLAN_NOT_FOUND :
+            throw WorldClanNotFound() ;
+        case WORLD_AREA_NOT_FOUND :
+            throw WorldAreaNotFound() ;
+        case WORLD_GROUP_ALREADY_IN_AREA :
+            throw WorldGroupAlreadyInArea() ;
+        case WORLD_AREA_NOT_REACHABLE :
+            throw WorldAreaNotReachable() ;
+        case WORLD_CLAN_CANT_UNITE :
+            throw ClanCantUnite() ;
+        case WORLD_TRANSACTION_ACTIVE :
+            throw WorldTransactionActive() ;
+    }
+}
+
+void World::saveCheckpoint(const string& path) {
+    checkNoTransaction();
+    if (journal != nullptr) {
+        (*journal).sync();
+        checkpoint_position = (*journal).getPosition();
+    }
+    Checkpoint::save(*this, path);
+    if (journal != nullptr) {
+        (*journal).restart();
+    }
+}
+
+std::unique_ptr<World> World::loadCheckpoint(const string& path) {
+    std::unique_ptr<World> world(new World());
+    Checkpoint::load(*world, path);
+    return world;
+}
+
+std::unique_ptr<World> World::fork() const {
+    std::ostringstream checkpoint;
+    Checkpoint::write(*this, checkpoint);
+    return forkFrom(checkpoint.str());
+}
+
+std::unique_ptr<World> World::forkFrom(const string& checkpoint) const {
+    std::unique_ptr<World> child(new World());
+    Checkpoint::read(*child, checkpoint.data(), checkpoint.size());
+    (*child).checkpoint_position.generation = -1;
+    (*child).checkpoint_position.offset = 0;
+    //the areas keep their groups in the same order, so the published groups
+    //of this world fit the fork too.
+    (*child).next_snapshot = next_snapshot;
+    (*child).published = std::atomic_load(&published);
+    (*child).dirty_areas = dirty_areas;
+    (*child).dirty_clans = dirty_clans;
+    (*child).published_groups = published_groups;
+    return child;
+}
+
+std::vector<ScenarioResult> World::runScenarios(
+        const std::vector<std::vector<WorldOperation> >& scenarios,
+        int threads) {
+    if (threads < 1) {
+        threads = 1;
+    }
+    if ((pool == nullptr) || ((*pool).size() != threads)) {
+        pool.reset(new WorkStealingPool(threads));
+    }
+    std::ostringstream written;
+    Checkpoint::write(*this, written);
+    const string checkpoint = written.str();
+    std::vector<ScenarioResult> results(scenarios.size());
+    std::vector<std::function<void()> > tasks;
+    for (unsigned int i = 0; i < scenarios.size(); i++) {
+        tasks.push_back([this, &checkpoint, &scenarios, &results, i]() {
+            std::chrono::steady_clock::time_point start =
+                    std::chrono::steady_clock::now();
+            std::unique_ptr<World> child = forkFrom(checkpoint);
+            std::vector<WorldResult> applied =
+                    (*child).applyBatch(scenarios[i]);
+            ScenarioResult& result = results[i];
+            result.succeeded = std::count(applied.begin(), applied.end(),
+                                          WORLD_SUCCESS);
+            result.failed = applied.size() - result.succeeded;
+            result.stats = (*((*child).snapshot())).getStats();
+            result.seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start).count();
+        });
+    }
+    (*pool).run(tasks);
+    return results;
+}
+
+void World::openJournal(const string& path, int sync_every,
+                        int sync_millis) {
+    checkNoTransaction();
+    journal.reset();
+    journal.reset(new Journal(path, checkpoint_position.generation + 1,
+                              sync_every, sync_millis));
+}
+
+void World::syncJournal() {
+    if (journal != nullptr) {
+        (*journal).sync();
+    }
+}
+
+JournalStats World::getJournalStats() const {
+    if (journal != nullptr) {
+        return (*journal).getStats();
+    }
+    JournalStats stats = { 0, 0, 0 };
+    return stats;
+}
+
+void World::beginTransaction() {
+    checkNoTransaction();
+    transaction.reset(new UndoLog(*this));
+}
+
+void World::commit() {
+    if (transaction == nullptr) {
+        throw WorldNoTransaction() ;
+    }
+    std::unique_ptr<UndoLog> committed = std::move(transaction);
+    (*committed).commit(*this);
+    const std::vector<Command>& commands = (*committed).getCommands();
+    for (unsigned int i = 0; i < commands.size(); i++) {
+        (*journal).record(commands[i]);
+    }
+}
+
+void World::rollback() {
+    if (transaction == nullptr) {
+        throw WorldNoTransaction() ;
+    }
+    std::unique_ptr<UndoLog> rolled_back = std::move(transaction);
+    (*rolled_back).rollback(*this);
+}
+
+bool World::inTransaction() const {
+    return transaction != nullptr;
+}
+
+std::unique_ptr<World> World::recover(const string& checkpoint_path,
+                                      const string& journal_path,
+                                      int sync_every, int sync_millis) {
+    std::unique_ptr<World> world;
+    if (std::ifstream(checkpoint_path.c_str()).good()) {
+        world = loadCheckpoint(checkpoint_path);
+    } else {
+        world.reset(new World());
+    }
+    std::ifstream input(journal_path.c_str(),
+                        std::ios::binary | std::ios::ate);
+    long long end = input ? static_cast<long long>(input.tellg()) : 0;
+    //a journal without a whole header has nothing in it.
+    if (end >= Journal::headerSize()) {
+        input.seekg(0);
+        long long kept = (*world).replayJournal(input, end);
+        input.close();
+        if ((kept < end) && (truncate(journal_path.c_str(), kept) != 0)) {
+            throw JournalCantWrite();
+        }
+    }
+    (*world).openJournal(journal_path, sync_every, sync_millis);
+    return world;
+}
+
+long long World::replayJournal(std::istream& input, long long end) {
+    long long generation = Journal::readHeader(input);
+    long long kept = 0;
+    try {
+        CommandReader reader(input);
+        if (generation == checkpoint_position.generation) {
+            if ((checkpoint_position.offset < Journal::headerSize()) ||
+                    (checkpoint_position.offset > end)) {
+                throw JournalBadFormat();
+            }
+            input.seekg(checkpoint_position.offset);
+        } else if (generation != checkpoint_position.generation + 1) {
+            throw JournalBadFormat();
+        }
+        kept = input.tellg();
+        Command command;
+        while (reader.next(command)) {
+            WorldResult result = WORLD_SUCCESS;
+            if (command.type == ADVANCE) {
+                advanceTo(command.tick);
+            } else if (command.tick >= 0) {
+                schedule(command.tick, command.toOperation());
+            } else if (command.isOperation()) {
+                result = apply(command.toOperation());
+            }
+            if (result != WORLD_SUCCESS) {
+                throw JournalBadFormat();
+            }
+            kept = input.tellg();
+        }
+    } catch (const CommandLogTruncated&) {
+        //the last command was cut by a crash, so it was never synced.
+    } catch (const CommandLogBadCommand&) {
+        throw JournalBadFormat();
+    } catch (const WorldInvalidArgument&) {
+        throw JournalBadFormat();
+    }
+    return kept;
+}
+
+std::shared_ptr<const WorldSnapshot> World::snapshot() {
+    std::unordered_set<string> changed_clans;
+    changed_clans.swap(dirty_clans);
+    for (unsigned int id = 0; id < dirty_areas.size(); id++) {
+        if (dirty_areas[id]) {
+            updateSnapshotArea(id, changed_clans);
+            dirty_areas[id] = false;
+        }
     }
-    os <<*(clan_map.at(findClanThatHasGroup(group_name)).getGroup(group_name));
-    os <<"Group's current area: "<< findAreaThatHasGroup(group_name) << endl ;
+    for (std::unordered_set<string>::const_iterator it =
+            changed_clans.begin(); it != changed_clans.end(); ++it) {
+        map<string,Clan>::const_iterator clan = clan_map.find(*it);
+        if (clan == clan_map.end()) {
+            next_snapshot.clans.erase(*it);
+            continue ;
+        }
+        std::ostringstream os;
+        os << clan->second;
+        next_snapshot.clans.insert(*it, os.str());
+    }
+    next_snapshot.stats.clans = next_snapshot.clans.size();
+    next_snapshot.stats.areas = areas_map.size();
+    next_snapshot.stats.groups = next_snapshot.groups.size();
+    next_snapshot.tick = current_tick;
+    std::shared_ptr<const WorldSnapshot> snapshot(
+            new WorldSnapshot(next_snapshot));
+    std::atomic_store(&published, snapshot);
+    return snapshot;
+}
+
+std::shared_ptr<const WorldSnapshot> World::getSnapshot() const {
+    return std::atomic_load(&published);
+}
+
+void World::updateSnapshotArea(int id,
+                               std::unordered_set<string>& changed_clans) {
+    const AreaSlot& slot = areas_by_id[id]->second;
+    const Area& area = getArea(slot);
+    std::vector<PublishedGroup>& old_groups = published_groups[id];
+    std::vector<bool> kept(old_groups.size(), false);
+    std::vector<PublishedGroup> groups;
+    GroupNamesView view = area.getGroupsNamesView();
+    const std::vector<GroupPointer>& area_groups = area.getGroups();
+    groups.reserve(view.size());
+    for (GroupNamesView::const_iterator it = view.begin(); it != view.end();
+         ++it) {
+        unsigned int index = groups.size();
+        const Group& group = *(area_groups[index]);
+        //an area only moves its last group when a group leaves, so most
+        //groups are where they were.
+        if ((index < old_groups.size()) &&
+                (old_groups[index].name == *it)) {
+            kept[index] = true;
+            groups.push_back(std::move(old_groups[index]));
+            if (groups.back().sameAs(group)) {
+                continue ;
+            }
+        } else {
+            groups.push_back(PublishedGroup());
+        }
+        groups.back().update(group);
+        std::ostringstream os;
+        os << group << "Group's current area: " << area.getName() << endl;
+        WorldSnapshot::GroupView updated = { os.str(), group.getClan(),
+                                             group.getSize() };
+        const WorldSnapshot::GroupView* old =
+                next_snapshot.groups.find(*it);
+        if (old != nullptr) {
+            changed_clans.insert((*old).clan);
+            next_snapshot.stats.population -= (*old).size;
+        }
+        changed_clans.insert(updated.clan);
+        next_snapshot.stats.population += updated.size;
+        next_snapshot.groups.insert(*it, updated);
+    }
+    //a group that left the area moved to another changed area, or is gone.
+    for (unsigned int i = 0; i < old_groups.size(); i++) {
+        const string& name = old_groups[i].name;
+        if (kept[i] || (group_names.getArea(name) != nullptr)) {
+            continue ;
+        }
+        const WorldSnapshot::GroupView* old = next_snapshot.groups.find(name);
+        if (old != nullptr) {
+            changed_clans.insert((*old).clan);
+            next_snapshot.stats.population -= (*old).size;
+            next_snapshot.groups.erase(name);
+        }
+    }
+    old_groups.swap(groups);
+    int changes = slot.type == MOUNTAIN ?
+                  mountains[slot.index].getRulerChanges() : 0;
+    const int* old_changes = next_snapshot.ruler_changes.find(area.getName());
+    next_snapshot.stats.ruler_changes += changes -
+            (old_changes == nullptr ? 0 : *old_changes);
+    next_snapshot.ruler_changes.insert(area.getName(), changes);
+}
+
+void World::unpublishArea(int id) {
+    const string& name = areas_by_id[id]->first;
+    if (next_snapshot.ruler_changes.find(name) == nullptr) {
+        return ;
+    }
+    updateSnapshotArea(id, dirty_clans);
+    next_snapshot.ruler_changes.erase(name);
+}
+
+int World::getRulerChanges(const string& area_name) const {
+    int changes = 0;
+    throwResult(tryGetRulerChanges(area_name, changes));
+    return changes;
+}
+
+const AreaStats& World::areaStats(const string& area_name) const {
+    const AreaStats* stats = nullptr;
+    throwResult(tryAreaStats(area_name, stats));
+    return *stats;
+}
+
+void World::dumpMetrics(std::ostream& os) {
+    Metrics::dump(os);
+}
+
+void World::startTrace() {
+    Trace::start();
+}
+
+void World::stopTrace(std::ostream& os) {
+    Trace::stop(os);
+}
+
+MemoryReport World::memoryReport() const {
+    return MemoryAccounting::measure(*this);
+}
+
+void World::exportState(std::ostream& os, ExportFormat format) const {
+    StateExport::write(*this, os, format);
+}
+
+void World::printGroup(std::ostream& os, const string& group_name) const {
+    throwResult(tryPrintGroup(os, group_name));
 }
 
 void World::printClan(std::ostream& os, const string& clan_name) const {
-    if (!checkClanExiest(clan_name)) {
-        throw WorldClanNotFound() ;
+    throwResult(tryPrintClan(os, clan_name));
+}
+
+std::vector<const Group*> World::topGroups(int k) const {
+    std::vector<const Group*> groups;
+    throwResult(tryTopGroups(k, groups));
+    return groups;
+}
+
+std::vector<const Group*> World::topGroupsOfClan(const string& clan_name,
+                                                 int k) const {
+    std::vector<const Group*> groups;
+    throwResult(tryTopGroupsOfClan(clan_name, k, groups));
+    return groups;
+}
+
+WorldResult World::tryGetRulerChanges(const string& area_name,
+                                      int& changes) const {
+    MTM_TIME(METRIC_CALL_GET_RULER_CHANGES);
+    map<string,AreaSlot>::const_iterator it = areas_map.find(area_name);
+    if (it == areas_map.end()) {
+        return WORLD_AREA_NOT_FOUND ;
+    }
+    const AreaSlot& slot = it->second;
+    changes = slot.type == MOUNTAIN ?
+              mountains[slot.index].getRulerChanges() : 0;
+    return WORLD_SUCCESS ;
+}
+
+WorldResult World::tryAreaStats(const string& area_name,
+                                const AreaStats*& stats) const {
+    MTM_TIME(METRIC_CALL_AREA_STATS);
+    map<string,AreaSlot>::const_iterator it = areas_map.find(area_name);
+    if (it == areas_map.end()) {
+        return WORLD_AREA_NOT_FOUND ;
+    }
+    stats = &(getArea(it->second).getStats());
+    return WORLD_SUCCESS ;
+}
+
+WorldResult World::tryPrintGroup(std::ostream& os,
+                                 const string& group_name) const {
+    MTM_TIME(METRIC_CALL_PRINT_GROUP);
+    GroupPointer group = group_names.getGroup(group_name);
+    if (group == nullptr){
+        return WORLD_GROUP_NOT_FOUND ;
+    }
+    char buffer[OutputBuffer::STACK_SIZE];
+    OutputBuffer output(os, buffer, sizeof(buffer));
+    (*group).print(output);
+    output.append("Group's current area: ");
+    const Area* area = group_names.getArea(group_name);
+    if (area != nullptr) {
+        output.append((*area).getName());
+    }
+    output.append('\n');
+    output.flush();
+    return WORLD_SUCCESS ;
+}
+
+WorldResult World::tryPrintClan(std::ostream& os,
+                                const string& clan_name) const {
+    MTM_TIME(METRIC_CALL_PRINT_CLAN);
+    map<string,Clan>::const_iterator it = clan_map.find(clan_name);
+    if (it == clan_map.end()) {
+        return WORLD_CLAN_NOT_FOUND ;
+    }
+    os << it->second ;
+    return WORLD_SUCCESS ;
+}
+
+WorldResult World::tryTopGroups(int k,
+                                std::vector<const Group*>& groups) const {
+    MTM_TIME(METRIC_CALL_TOP_GROUPS);
+    if (k < 0) {
+        return WORLD_INVALID_ARGUMENT ;
+    }
+    clan_leaders.top(k, groups);
+    return WORLD_SUCCESS ;
+}
+
+WorldResult World::tryTopGroupsOfClan(const string& clan_name, int k,
+                                      std::vector<const Group*>& groups)
+                                      const {
+    MTM_TIME(METRIC_CALL_TOP_GROUPS_OF_CLAN);
+    if (k < 0) {
+        return WORLD_INVALID_ARGUMENT ;
+    }
+    map<string,Clan>::const_iterator it = clan_map.find(clan_name);
+    if (it == clan_map.end()) {
+        return WORLD_CLAN_NOT_FOUND ;
     }
-    os << clan_map.at(clan_name) ;
+    takeStrongest((it->second).getRanking(), k, groups);
+    return WORLD_SUCCESS ;
 }
 
 
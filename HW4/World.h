@@ -7,16 +7,313 @@
 #include "Plain.h"
 #include "Mountain.h"
 #include "River.h"
+#include "WorldOperation.h"
+#include "ReachabilityIndex.h"
+#include "EventScheduler.h"
+#include "WorkStealingPool.h"
+#include "WorldSnapshot.h"
+#include "Checkpoint.h"
+#include "Journal.h"
+#include "UndoLog.h"
+#include "MemoryReport.h"
+#include "StateExport.h"
 #include <map>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace mtm{
-    typedef std::shared_ptr<Area> AreaPtr;
 
-    enum AreaType{ PLAIN, MOUNTAIN, RIVER };
+    /**
+     * Where an area is kept in the world: the type says which of the world's
+     * area containers has it, and index is its place in that container.
+     * id is the number of the area in the world's reachability index.
+     */
+    struct AreaSlot{
+        AreaType type;
+        int index;
+        int id;
+    };
     
+    /**
+     * A group as it was when the world took its last snapshot.
+     */
+    struct PublishedGroup{
+        string name;
+        string clan;
+        int children;
+        int adults;
+        int tools;
+        int food;
+        int morale;
+
+        /**
+         * @return true if the group still looks the same.
+         */
+        bool sameAs(const Group& group) const {
+            return (children == group.getChildren()) &&
+                   (adults == group.getAdults()) &&
+                   (tools == group.getTools()) &&
+                   (food == group.getFood()) &&
+                   (morale == group.getMorale()) &&
+                   (clan == group.getClan());
+        }
+
+        /**
+         * Make the published group look like the group does now.
+         */
+        void update(const Group& group) {
+            name = group.getName();
+            clan = group.getClan();
+            children = group.getChildren();
+            adults = group.getAdults();
+            tools = group.getTools();
+            food = group.getFood();
+            morale = group.getMorale();
+        }
+    };
+
+    /**
+     * What a scenario of World::runScenarios did to its fork of the world:
+     * how many of its operations succeeded and failed, the totals of the
+     * fork after them, and how long forking and applying took.
+     */
+    struct ScenarioResult{
+        int succeeded;
+        int failed;
+        SnapshotStats stats;
+        double seconds;
+    };
+
     class World{
+        friend class Checkpoint;
+        friend class UndoLog;
+        friend class MemoryAccounting;
+        friend class StateExport;
+
+        GroupNames group_names;
+        /**
+         * The clans of clan_map ordered by their strongest groups, for
+         * topGroups. Every clan in clan_map is in it (Clan::rankIn), and it
+         * is declared first so it outlives the clans.
+         */
+        ClanLeaders clan_leaders;
         map<string, Clan> clan_map;
-        map<string, AreaPtr>areas_map ;
+        /**
+         * Every clan name that was ever used in the world, including the
+         * names of clans that were united into a new clan.
+         */
+        std::unordered_set<string> used_clan_names;
+        /**
+         * The areas are kept by value, every type in its own container, so
+         * the world calls the rules of every area type directly (no virtual
+         * dispatch), and a pass over the areas of one type walks adjacent
+         * memory. A deque never moves its elements, so the areas can be
+         * pointed to.
+         */
+        std::deque<Plain> plains;
+        std::deque<Mountain> mountains;
+        std::deque<River> rivers;
+        map<string, AreaSlot> areas_map ;
+        /**
+         * The roads between the areas, and the areas by their ids.
+         */
+        ReachabilityIndex reachability;
+        std::vector<map<string, AreaSlot>::const_iterator> areas_by_id;
+        /**
+         * The operations that were scheduled for future ticks.
+         */
+        EventScheduler scheduler;
+        long long current_tick;
+        SchedulerStats scheduler_stats;
+        /**
+         * The threads that apply moves in parallel, created by the first
+         * concurrent batch.
+         */
+        std::unique_ptr<WorkStealingPool> pool;
+        /**
+         * The snapshot that is built from every change since the world was
+         * created, the last snapshot that was published, and what changed
+         * since then: the areas by id (every area a group got into, out of,
+         * or changed in), and the clans that were added or united.
+         * published_groups has the groups every area had when the last
+         * snapshot was taken, in the order the area had them, so the groups
+         * of a changed area that didn't change are found without looking
+         * them up.
+         */
+        WorldSnapshot next_snapshot;
+        std::shared_ptr<const WorldSnapshot> published;
+        std::vector<char> dirty_areas;
+        std::unordered_set<string> dirty_clans;
+        std::vector<std::vector<PublishedGroup> > published_groups;
+        /**
+         * The journal every change is written to, if one was opened, and the
+         * place in the journal the last checkpoint that was saved or loaded
+         * got to (generation -1 before the first one).
+         */
+        std::unique_ptr<Journal> journal;
+        JournalPosition checkpoint_position;
+        /**
+         * The undo log of the transaction that began and wasn't committed or
+         * rolled back yet, nullptr if there is none.
+         */
+        std::unique_ptr<UndoLog> transaction;
+
+        /**
+         * The number of operations a concurrent batch looks ahead of the
+         * first operation it didn't apply yet, to fill a wave.
+         */
+        static const int CONCURRENT_WINDOW = 4096;
+
+        /**
+         * The number of moves a wave can put off before it stops looking
+         * ahead. Every wave scans the moves that were put off again, so
+         * without a bound a batch that conflicts a lot costs O(window) for
+         * every few moves.
+         */
+        static const unsigned int CONCURRENT_DEFERRED = 64;
+
+        /**
+         * A function object that makes a group arrive to an area.
+         */
+        struct GroupArrival{
+            const string& group_name;
+            const string& clan_name;
+            map<string, Clan>& clan_map;
+            template<typename AreaKind>
+            void operator()(AreaKind& area) const {
+                area.AreaKind::groupArrive(group_name, clan_name, clan_map);
+            }
+        };
+
+        /**
+         * A function object that makes a group leave an area.
+         */
+        struct GroupDeparture{
+            const string& group_name;
+            template<typename AreaKind>
+            void operator()(AreaKind& area) const {
+                area.AreaKind::groupLeave(group_name);
+            }
+        };
+
+        /**
+         * A function object that adds to a footprint what a group can change
+         * when it arrives to an area.
+         */
+        struct ArrivalFootprintOf{
+            const string& clan_name;
+            const map<string, Clan>& clan_map;
+            ArrivalFootprint& footprint;
+            template<typename AreaKind>
+            void operator()(AreaKind& area) const {
+                area.AreaKind::addArrivalFootprint(clan_name, clan_map,
+                                                   footprint);
+            }
+        };
+
+        /**
+         * A function object that makes an area refresh its groups.
+         */
+        struct GroupsRefresh{
+            template<typename AreaKind>
+            void operator()(AreaKind& area) const {
+                area.AreaKind::refreshGroups();
+            }
+        };
+
+        /**
+         * A private function that calls an action with the area in the given
+         * slot, as its real type.
+         * @param
+         * slot - the slot of the area.
+         * action - a function object with an operator() for every area type.
+         */
+        template<typename Action>
+        void visitArea(const AreaSlot& slot, const Action& action) {
+            switch (slot.type) {
+                case PLAIN :
+                    action(plains[slot.index]);
+                    break ;
+                case MOUNTAIN :
+                    action(mountains[slot.index]);
+                    break ;
+                case RIVER :
+                    action(rivers[slot.index]);
+                    break ;
+            }
+        }
+
+        /**
+         * A private function that calls an action with every area in the
+         * world, one area type after the other.
+         * @param
+         * action - a function object with an operator() for every area type.
+         */
+        template<typename Action>
+        void forEachArea(const Action& action) {
+            for (unsigned int i = 0; i < plains.size(); i++) {
+                action(plains[i]);
+            }
+            for (unsigned int i = 0; i < mountains.size(); i++) {
+                action(mountains[i]);
+            }
+            for (unsigned int i = 0; i < rivers.size(); i++) {
+                action(rivers[i]);
+            }
+        }
+
+        /**
+         * The clans and areas a batch already looked up, so an operation
+         * that uses the same names again doesn't search the world again.
+         * The clans and areas are never moved, so pointing to them is safe
+         * for as long as they stay in the world.
+         */
+        struct LookupCache{
+            std::unordered_map<string, Clan*> clans;
+            std::unordered_map<string, const AreaSlot*> areas;
+        };
+
+        /**
+         * A private function that returns the area in the given slot, for
+         * the functions that all the area types share.
+         * @param
+         * slot - the slot of the area.
+         * @return
+         * the area in the slot .
+         */
+        const Area& getArea(const AreaSlot& slot) const {
+            switch (slot.type) {
+                case PLAIN :
+                    return plains[slot.index];
+                case MOUNTAIN :
+                    return mountains[slot.index];
+                default :
+                    return rivers[slot.index];
+            }
+        }
+        Area& getArea(const AreaSlot& slot) {
+            return const_cast<Area&>(
+                    static_cast<const World&>(*this).getArea(slot));
+        }
+        /**
+         * A private function that takes the first k groups of a ranking.
+         * @param
+         * ranking - the ranking to take the groups from.
+         * k - the amount of groups to take.
+         * groups - set to the groups, strongest first.
+         */
+        static void takeStrongest(const GroupRanking& ranking, int k,
+                                  std::vector<const Group*>& groups) {
+            groups.clear();
+            groups.reserve(std::min(k, ranking.size()));
+            for (GroupRanking::const_iterator it = ranking.begin();
+                 (it != ranking.end()) && ((int)groups.size() < k); ++it) {
+                groups.push_back((*it).get());
+            }
+        }
+
         /**
          * A private function that helps us check if a clan name alraedy
          * exiest.
@@ -43,31 +340,12 @@ namespace mtm{
          * false - otherwize ;
          */
         bool checkAreaExiest(const string& area_name) const {
-            map<string,AreaPtr>::const_iterator c_it= areas_map.find(area_name);
+            map<string,AreaSlot>::const_iterator c_it=areas_map.find(area_name);
             if (c_it==areas_map.end()){
                 return false ;
             }
             return true;
         }
-        /**
-         * A private function that helps us find the name of the area
-         * that has the relvent group.
-         * @param
-         * group_name - the group we wish to find.
-         * @return
-         * the name of the area we found the group in .
-         * "" - an empty string otherwize .
-         */
-        string findAreaThatHasGroup(const string& group_name) const {
-            map<string,AreaPtr>::const_iterator c_it = areas_map.begin();
-            while (c_it!=areas_map.end()) {
-                if ((*(c_it->second)).getGroupsNames().contains(group_name)){
-                    return c_it->first ;
-                }
-                c_it++;
-            }
-            return "" ;
-        }
         /**
          * A private function that helps us find the name of the clan
          * that has the relvent group.
@@ -78,14 +356,11 @@ namespace mtm{
          * "" - an empty string otherwize .
          */
         string findClanThatHasGroup(const string& group_name) const {
-            map<string,Clan>::const_iterator c_it = clan_map.begin();
-            while (c_it!=clan_map.end()) {
-                if ((c_it->second).doesContain(group_name)){
-                    return c_it->first ;
-                }
-                c_it++;
+            GroupPointer group = group_names.getGroup(group_name);
+            if (group == nullptr) {
+                return "" ;
             }
-            return "" ;
+            return (*group).getClan() ;
         }
         /**
          * A private function that helps us make all the new united clan
@@ -113,14 +388,300 @@ namespace mtm{
          * false - otherwize .
             */
         bool checkIfGroupNameExiest(const string& name) const {
-            for (std::map<string,Clan>::const_iterator it=clan_map.begin();
-                 it!= clan_map.end() ; it++) {
-                if ((it->second).doesContain(name)){
-                    return true ;
+            return group_names.contains(name);
+        }
+
+        /**
+         * A private function that finds a clan, through the cache if there
+         * is one.
+         * @param
+         * clan_name - the name of the clan.
+         * cache - the lookups of the current batch, or nullptr.
+         * @return
+         * the clan , nullptr if there is no such clan .
+         */
+        Clan* findClan(const string& clan_name, LookupCache* cache) {
+            if (cache != nullptr) {
+                std::unordered_map<string, Clan*>::const_iterator it =
+                        (*cache).clans.find(clan_name);
+                if (it != (*cache).clans.end()) {
+                    return it->second ;
                 }
             }
-            return false ;
+            map<string,Clan>::iterator c_it = clan_map.find(clan_name);
+            Clan* clan = c_it == clan_map.end() ? nullptr : &(c_it->second);
+            if ((cache != nullptr) && (clan != nullptr)) {
+                (*cache).clans[clan_name] = clan ;
+            }
+            return clan ;
+        }
+
+        /**
+         * A private function that finds the slot of an area, through the
+         * cache if there is one.
+         * @param
+         * area_name - the name of the area.
+         * cache - the lookups of the current batch, or nullptr.
+         * @return
+         * the slot of the area , nullptr if there is no such area .
+         */
+        const AreaSlot* findArea(const string& area_name, LookupCache* cache) {
+            if (cache != nullptr) {
+                std::unordered_map<string, const AreaSlot*>::const_iterator
+                        it = (*cache).areas.find(area_name);
+                if (it != (*cache).areas.end()) {
+                    return it->second ;
+                }
+            }
+            map<string,AreaSlot>::const_iterator a_it =
+                    areas_map.find(area_name);
+            const AreaSlot* slot =
+                    a_it == areas_map.end() ? nullptr : &(a_it->second);
+            if ((cache != nullptr) && (slot != nullptr)) {
+                (*cache).areas[area_name] = slot ;
+            }
+            return slot ;
+        }
+
+        /**
+         * A private function that refreshes the groups of every area that
+         * has a group of the given clan.
+         * @param
+         * clan - the clan whose groups changed.
+         * cache - the lookups of the current batch, or nullptr.
+         */
+        void refreshAreasOfClan(const Clan& clan, LookupCache* cache) {
+            std::unordered_set<const Area*> refreshed;
+            for (Clan::const_iterator it = clan.begin(); it != clan.end();
+                 ++it) {
+                const Area* area = group_names.getArea((**it).getName());
+                if ((area != nullptr) && refreshed.insert(area).second) {
+                    const AreaSlot* slot = findArea((*area).getName(), cache);
+                    visitArea(*slot, GroupsRefresh());
+                    dirty_areas[(*slot).id] = true;
+                }
+            }
+        }
+
+        /**
+         * A private function that moves a group from one area to another,
+         * with no checks.
+         * @param
+         * group_name - the name of the group.
+         * source - the slot of the area the group is in.
+         * destination - the slot of the area the group moves to.
+         */
+        void moveGroupBetween(const string& group_name, const AreaSlot& source,
+                              const AreaSlot& destination) {
+            string clan_name = findClanThatHasGroup(group_name);
+            if (transaction != nullptr) {
+                (*transaction).saveMove(*this, group_name, source,
+                                        destination);
+            }
+            //remove the group from the source area , than add it to the
+            //destination.
+            GroupDeparture departure = { group_name };
+            visitArea(source, departure);
+            GroupArrival arrival = { group_name, clan_name, clan_map };
+            visitArea(destination, arrival);
+            //the moves of a concurrent wave are in different areas, so they
+            //mark different elements.
+            dirty_areas[source.id] = true;
+            dirty_areas[destination.id] = true;
+        }
+
+        /**
+         * A private function that adds the keys of the name families a name
+         * belongs to: the names divided from it ("<name>_<i>"), and, if it
+         * was divided from another name, the family of that name.
+         * @param
+         * group_name - the name.
+         * own_family - false to add only the family it was divided from.
+         * keys - the keys to add to.
+         */
+        static void addNameKeys(const string& group_name, bool own_family,
+                                std::vector<string>& keys) {
+            if (own_family) {
+                keys.push_back("n" + group_name);
+            }
+            string base;
+            int suffix;
+            if (GroupNames::splitSuffix(group_name, base, suffix)) {
+                keys.push_back("n" + base);
+            }
+        }
+
+        /**
+         * A private function that finds everything a move can change: the
+         * area the group leaves, the area it arrives to, the clans of the
+         * groups it changes, and the name families it can take a name from
+         * or free a name in. Two moves that have no key in common can be
+         * applied in any order, with the same result.
+         * @param
+         * move - a MOVE_GROUP operation.
+         * keys - the keys to add to.
+         */
+        void addMoveKeys(const WorldOperation& move,
+                         std::vector<string>& keys) {
+            addNameKeys(move.first, true, keys);
+            GroupPointer group = group_names.getGroup(move.first);
+            Area* source = group_names.getArea(move.first);
+            if ((group == nullptr) || (source == nullptr)) {
+                return ;
+            }
+            keys.push_back("a" + (*source).getName());
+            keys.push_back("c" + (*group).getClan());
+            const AreaSlot* destination = findArea(move.second, nullptr);
+            if (destination == nullptr) {
+                return ;
+            }
+            keys.push_back("a" + move.second);
+            ArrivalFootprint footprint;
+            ArrivalFootprintOf footprint_of = { (*group).getClan(), clan_map,
+                                                footprint };
+            visitArea(*destination, footprint_of);
+            for (unsigned int i = 0; i < footprint.clans.size(); i++) {
+                keys.push_back("c" + footprint.clans[i]);
+            }
+            for (unsigned int i = 0; i < footprint.names.size(); i++) {
+                addNameKeys(footprint.names[i], false, keys);
+            }
+        }
+
+        /**
+         * A private function that applies moves that have no key in common,
+         * on the pool.
+         * @param
+         * wave - the indexes of the moves.
+         * operations - the operations of the batch.
+         * results - where to put the result of every move.
+         */
+        void applyWave(const std::vector<int>& wave,
+                       const std::vector<WorldOperation>& operations,
+                       std::vector<WorldResult>& results);
+
+        /**
+         * A private function that brings next_snapshot up to date with an
+         * area that changed: the prints of its groups, the groups that are
+         * gone from the world, and its ruler changes.
+         * @param
+         * id - the id of the area.
+         * changed_clans - where to add the clans whose groups changed.
+         */
+        void updateSnapshotArea(int id, std::unordered_set<string>&
+                                changed_clans);
+
+        /**
+         * A private function that takes an area that has no groups out of
+         * next_snapshot, with the groups that were only in it, if a
+         * snapshot published it.
+         * @param
+         * id - the id of the area.
+         */
+        void unpublishArea(int id);
+
+        /**
+         * The private versions of the public functions with the same names.
+         * They report a failure with a WorldResult instead of throwing, and
+         * the world doesn't change when they fail.
+         * cache - the lookups of the current batch, or nullptr.
+         */
+        WorldResult applyAddClan(const string& new_clan);
+        WorldResult applyAddArea(const string& area_name, AreaType type);
+        WorldResult applyAddGroup(const string& group_name,
+                                  const string& clan_name, int num_children,
+                                  int num_adults, const string& area_name,
+                                  LookupCache* cache);
+        WorldResult applyMakeReachable(const string& from, const string& to,
+                                       LookupCache* cache);
+        WorldResult applyMoveGroup(const string& group_name,
+                                   const string& destination,
+                                   LookupCache* cache);
+        WorldResult applyMoveGroupVia(const string& group_name,
+                                      const string& destination,
+                                      LookupCache* cache);
+        WorldResult applyMakeFriends(const string& clan1, const string& clan2,
+                                     LookupCache* cache);
+        WorldResult applyUniteClans(const string& clan1, const string& clan2,
+                                    const string& new_name,
+                                    LookupCache* cache);
+        WorldResult applyOperation(const WorldOperation& operation,
+                                   LookupCache* cache);
+
+        /**
+         * A private function that writes an operation to the journal, if the
+         * world has one and the operation succeeded.
+         * @param
+         * result - the result of the operation.
+         * operation - the operation.
+         * @return
+         * the result.
+         */
+        WorldResult journaled(WorldResult result,
+                              const WorldOperation& operation) {
+            if (result == WORLD_SUCCESS) {
+                record(Command::fromOperation(operation));
+            }
+            return result;
+        }
+
+        /**
+         * A private function that writes a command to the journal, if the
+         * world has one. The commands of a transaction wait in its undo log
+         * until it is committed.
+         * @param
+         * command - the command.
+         */
+        void record(const Command& command) {
+            if (journal == nullptr) {
+                return ;
+            }
+            if (transaction != nullptr) {
+                (*transaction).record(command);
+            } else {
+                (*journal).record(command);
+            }
         }
+
+        /**
+         * A private function that throws if a transaction began and wasn't
+         * committed or rolled back yet.
+         */
+        void checkNoTransaction() const {
+            if (transaction != nullptr) {
+                throw WorldTransactionActive() ;
+            }
+        }
+
+        /**
+         * A private function that applies the commands of a journal that
+         * come after the last checkpoint, up to a command that a crash cut.
+         * @param
+         * input - the journal, at its start.
+         * end - the size of the journal.
+         * @return
+         * the end of the last command that was applied.
+         */
+        long long replayJournal(std::istream& input, long long end);
+
+        /**
+         * A private function that creates a fork of the world from a
+         * checkpoint of it in memory. Many threads can fork the same world
+         * at once.
+         * @param
+         * checkpoint - the world, written by Checkpoint::write.
+         * @return
+         * the fork.
+         */
+        std::unique_ptr<World> forkFrom(const string& checkpoint) const;
+
+        /**
+         * A private function that throws the exception that matches a
+         * result. Does nothing for WORLD_SUCCESS.
+         * @param
+         * result - the result of an operation.
+         */
+        static void throwResult(WorldResult result);
     public:
         /**
          * Empty constructor
@@ -207,6 +768,37 @@ namespace mtm{
          */
         void moveGroup(const string& group_name, const string& destination);
         
+        /**
+         * Check if a group in one area can get to another area, in one move
+         * or more.
+         * @param from The name of the area the group is in.
+         * @param to The name of the area the group wants to get to.
+         * @return true if there is a path of reachable areas from the first
+         *  area to the second one, or if it is the same area.
+         * @throws WorldAreaNotFound If at least one of the areas isn't in
+         *  the world.
+         */
+        bool canReach(const string& from, const string& to) const;
+
+        /**
+         * Move a group to destination area, through the fewest areas on the
+         * way. The group arrives to every area on the way, by the rules of
+         * that area, and leaves it for the next one. If the group doesn't
+         * exist anymore after it arrives to an area (it lost all its people,
+         * or united with another group), it stops there.
+         * @param group_name The name of the group that should move
+         * @param destination The name of the area the group should move to.
+         * @throws WorldGroupNotFound If there is no group with the given
+         *  name in the world.
+         * @throws WorldAreaNotFound If there is no area with the given name
+         *  in the world.
+         * @throws WorldGroupAlreadyInArea If the group is already in the
+         *  destination area.
+         * @throws WorldAreaNotReachable If there is no path of reachable
+         *  areas from the area the group is in to the destination.
+         */
+        void moveGroupVia(const string& group_name, const string& destination);
+
         /**
          * Make to clans friends.
          * @param clan1 The name of one of the clans to become friends.
@@ -229,7 +821,325 @@ namespace mtm{
          */
         void uniteClans(const string& clan1, const string& clan2, const
         string& new_name);
+
+        /**
+         * Apply one operation to the world, without throwing.
+         * @param operation The operation to apply.
+         * @return WORLD_SUCCESS if the operation was applied, otherwise the
+         *  result that matches the exception the World function of the
+         *  operation would throw. A failed operation doesn't change the
+         *  world.
+         */
+        WorldResult apply(const WorldOperation& operation);
+
+        /**
+         * Apply operations to the world one after the other, without
+         * throwing. An operation that fails doesn't stop the batch, and the
+         * operations after it are applied to the world as it is.
+         * The clans and areas that an operation looks up are remembered for
+         * the rest of the batch, so a bulk import that adds many groups to
+         * the same clans and areas looks every name up only once.
+         * @param operations The operations to apply, in order.
+         * @return The result of every operation, in the same order (see
+         *  apply).
+         */
+        std::vector<WorldResult> applyBatch(
+                const std::vector<WorldOperation>& operations);
+
+        /**
+         * Apply operations to the world like applyBatch, with the moves
+         * applied in parallel. The results, and the world after the batch,
+         * are the same as applyBatch gives.
+         * Consecutive moves that can't affect each other (they touch
+         * different areas, clans and group names) are applied together, as a
+         * wave, on a pool of threads. A move that can affect a move of the
+         * wave waits for the next wave, with the moves after it that it can
+         * affect. Every operation that isn't a move is applied alone, after
+         * all the operations before it.
+         * In a transaction, the operations are applied one after the other,
+         * like applyBatch.
+         * @param operations The operations to apply, in order.
+         * @param threads The number of threads to apply the moves on.
+         * @return The result of every operation, in the same order.
+         */
+        std::vector<WorldResult> applyBatchConcurrently(
+                const std::vector<WorldOperation>& operations, int threads);
+
+        /**
+         * Schedule an operation to be applied when the world advances to a
+         * given tick. The world starts at tick 0.
+         * @param tick The tick to apply the operation at.
+         * @param operation The operation to apply (a move, a unite, making
+         *  friends, or any other operation).
+         * @return The id of the event. Events get increasing ids in the order
+         *  they are scheduled.
+         * @throws WorldInvalidArgument If the tick already passed (it is
+         *  before the current tick).
+         * @throws WorldTransactionActive If a transaction wasn't committed
+         *  or rolled back yet.
+         */
+        long long schedule(long long tick, const WorldOperation& operation);
+
+        /**
+         * Advance the world to a given tick, and apply all the events that
+         * were scheduled until it (including it), by the order of their
+         * ticks. Events of the same tick are applied in the order they were
+         * scheduled. A failed event doesn't stop the others.
+         * @param tick The tick to advance to.
+         * @return The results of the events that were applied, in the order
+         *  they were applied.
+         * @throws WorldInvalidArgument If the tick is before the current
+         *  tick.
+         * @throws WorldTransactionActive If a transaction wasn't committed
+         *  or rolled back yet.
+         */
+        std::vector<EventResult> advanceTo(long long tick);
+
+        /**
+         * @return The tick the world advanced to.
+         */
+        long long getCurrentTick() const;
+
+        /**
+         * @return The number of events that were scheduled and were not
+         *  applied yet.
+         */
+        int getPendingEvents() const;
+
+        /**
+         * @return How many events the world applied so far, and how long it
+         *  took.
+         */
+        SchedulerStats getSchedulerStats() const;
         
+        /**
+         * Save the world to a binary checkpoint file (see Checkpoint.h). The
+         * file is written next to the path and renamed over it once it is
+         * synced, so a crash leaves the last checkpoint whole. If the world
+         * has a journal, the checkpoint remembers the place it got to in the
+         * journal, and the journal starts its next generation.
+         * @param path The file to write.
+         * @throws CheckpointCantOpen If the file can't be written.
+         * @throws JournalCantWrite If the journal can't be written.
+         * @throws WorldTransactionActive If a transaction wasn't committed
+         *  or rolled back yet.
+         */
+        void saveCheckpoint(const string& path);
+
+        /**
+         * Create a world from a checkpoint file, as it was when it was
+         * saved, without applying the operations that built it.
+         * @param path The file to read.
+         * @return The world.
+         * @throws CheckpointCantOpen If the file can't be read.
+         * @throws CheckpointBadFormat If the file isn't a checkpoint of this
+         *  version, or it is damaged.
+         * @throws CheckpointTruncated If the file ends in the middle.
+         */
+        static std::unique_ptr<World> loadCheckpoint(const string& path);
+
+        /**
+         * Create a world that starts the same as this one, and then changes
+         * on its own (to try out operations without changing this world).
+         * The fork is a full copy, not a copy-on-write one: the world is
+         * written as a checkpoint in memory and loaded into the fork, so it
+         * costs O(groups), as much as saving and loading a checkpoint. Only
+         * the snapshots of this world are shared, so the snapshot() of the
+         * fork only costs what changed after the fork. The fork has no
+         * journal.
+         * @return The fork.
+         */
+        std::unique_ptr<World> fork() const;
+
+        /**
+         * Fork the world once for every scenario, apply every scenario to
+         * its own fork as a batch, on up to the given number of threads, and
+         * report what every scenario did. This world doesn't change.
+         * The world is written once, and every fork loads a full copy of it
+         * (see fork).
+         * @param scenarios The operations of every scenario.
+         * @param threads The number of threads, at least 1.
+         * @return The result of every scenario, in the order of the
+         *  scenarios.
+         */
+        std::vector<ScenarioResult> runScenarios(
+                const std::vector<std::vector<WorldOperation> >& scenarios,
+                int threads);
+
+        /**
+         * Write every change of the world from now on to a journal (see
+         * Journal.h): every operation that succeeds (a moveGroupVia as the
+         * moves it made), every schedule and every advanceTo. Open it on an
+         * empty world, or right after a checkpoint, so the checkpoint and the
+         * journal have all the world between them.
+         * @param path The file of the journal. A journal that is already
+         *  there is added to.
+         * @param sync_every The number of changes to sync together.
+         * @param sync_millis The most time between syncs, while the world
+         *  changes.
+         * @throws JournalCantOpen If the file can't be opened.
+         * @throws JournalBadFormat If the file isn't a journal.
+         * @throws WorldTransactionActive If a transaction wasn't committed
+         *  or rolled back yet.
+         */
+        void openJournal(const string& path, int sync_every, int sync_millis);
+
+        /**
+         * Sync every change that was written to the journal. Does nothing if
+         * the world has no journal.
+         * @throws JournalCantWrite If the journal can't be written.
+         */
+        void syncJournal();
+
+        /**
+         * @return How much was written to the journal since it was opened,
+         *  all 0 if the world has no journal.
+         */
+        JournalStats getJournalStats() const;
+
+        /**
+         * Build a world again after a crash: load its checkpoint (or start
+         * from an empty world if there is none), apply the changes in the
+         * journal that came after it, and go on writing the journal. A
+         * change that a crash cut in the middle is dropped from the journal.
+         * @param checkpoint_path The last checkpoint of the world.
+         * @param journal_path The journal of the world.
+         * @param sync_every The number of changes to sync together.
+         * @param sync_millis The most time between syncs.
+         * @return The world.
+         * @throws CheckpointException If the checkpoint can't be loaded.
+         * @throws JournalBadFormat If the journal doesn't go on from the
+         *  checkpoint, or its changes don't apply to it.
+         * @throws JournalCantOpen If the journal can't be opened.
+         * @throws JournalCantWrite If the cut change can't be dropped.
+         */
+        static std::unique_ptr<World> recover(const string& checkpoint_path,
+                                              const string& journal_path,
+                                              int sync_every,
+                                              int sync_millis);
+
+        /**
+         * Begin a transaction: the operations from now on can be taken back
+         * together with rollback, or kept with commit. The world changes as
+         * usual in the transaction, and before every change the undo log
+         * saves what it changes (UndoLog.h), so a rollback costs as much as
+         * the operations of the transaction did, not as much as the world.
+         * The journal gets the operations of the transaction only when it
+         * is committed. Scheduling, advancing, saving a checkpoint and
+         * opening a journal wait for the transaction to end.
+         * @throws WorldTransactionActive If a transaction already began and
+         *  wasn't committed or rolled back yet.
+         */
+        void beginTransaction();
+
+        /**
+         * Keep the operations of the transaction, and end it.
+         * @throws WorldNoTransaction If no transaction began.
+         * @throws JournalCantWrite If the journal can't be written.
+         */
+        void commit();
+
+        /**
+         * Put the world back the way it was when the transaction began, and
+         * end it.
+         * @throws WorldNoTransaction If no transaction began.
+         */
+        void rollback();
+
+        /**
+         * @return true if a transaction began and wasn't committed or rolled
+         *  back yet.
+         */
+        bool inTransaction() const;
+
+        /**
+         * Publish a snapshot of the world as it is now: the prints of its
+         * groups and clans, the ruler changes of its areas, and its totals.
+         * Only the areas and clans that changed since the last snapshot are
+         * printed again, the rest is shared with the last snapshot.
+         * @return The snapshot. It never changes, and threads can query it
+         *  without locking while the world changes.
+         */
+        std::shared_ptr<const WorldSnapshot> snapshot();
+
+        /**
+         * @return The last snapshot that was published, or an empty one if
+         *  there was none. Any thread can call it while another thread
+         *  changes the world or publishes a snapshot.
+         */
+        std::shared_ptr<const WorldSnapshot> getSnapshot() const;
+
+        /**
+         * Get the amount of times the ruler of a mountain changed.
+         * @param area_name The name of the area.
+         * @return The amount of ruler changes in the area, 0 if the area
+         *  isn't a mountain.
+         * @throws WorldAreaNotFound If there is no area with the given name
+         *  in the world.
+         */
+        int getRulerChanges(const string& area_name) const;
+
+        /**
+         * Get the live stats of an area (AreaStats in Area.h): the people of
+         * every clan in it, its groups and their power, its ruler, and its
+         * fights and trades so far. The area keeps them as its groups
+         * change, so getting them only costs finding the area.
+         * @param area_name The name of the area.
+         * @return The stats. They are valid until the next change to the
+         *  world.
+         * @throws WorldAreaNotFound If there is no area with the given name
+         *  in the world.
+         */
+        const AreaStats& areaStats(const string& area_name) const;
+
+        /**
+         * Print the metrics of the simulation (Metrics.h) to the ostream, in
+         * the Prometheus text format: the fights, trades, unites, divides and
+         * ruler changes, the MtmSet operations and allocations, the arrivals
+         * to every type of area, and the calls and exceptions of the world,
+         * with histograms of how long the arrivals and the calls took.
+         * The metrics count what all the worlds of the process did, on all
+         * of their threads.
+         * @param os The ostream to print into.
+         */
+        static void dumpMetrics(std::ostream& os);
+
+        /**
+         * Start a trace (Trace.h) of the arrivals, fights, trades and sorts
+         * of all the worlds of the process. Until the trace stops, every one
+         * of them is kept as a span.
+         */
+        static void startTrace();
+
+        /**
+         * Stop the trace, and write its spans to the ostream in the Chrome
+         * trace JSON format.
+         * @param os The ostream to write into.
+         */
+        static void stopTrace(std::ostream& os);
+
+        /**
+         * Measure the memory of the world (MemoryReport.h): the bytes of its
+         * groups, the control blocks of their shared pointers, the MtmSet
+         * nodes, the heap buffers of the strings, the nodes of the maps and
+         * the buffers of the vectors, for every clan, every area and the
+         * indexes of the whole world. It walks the whole world, so it is
+         * meant for diagnostics, not for every operation.
+         * @return The memory of the world.
+         */
+        MemoryReport memoryReport() const;
+
+        /**
+         * Export the state of the world for analysis (StateExport.h): the
+         * clans, their friends, the areas with their stats, and every group
+         * with its clan, area and stats, as CSV tables or as JSON.
+         * The world is written in one pass through a buffer, without copying
+         * or sorting the groups, and without flushing the ostream.
+         * @param os The ostream to write into.
+         * @param format EXPORT_CSV or EXPORT_JSON.
+         */
+        void exportState(std::ostream& os, ExportFormat format) const;
+
         /**
          * Print a group to the ostream, using the group output function (<<).
          * Add to it another line (after the last one of a regular print) of
@@ -250,6 +1160,83 @@ namespace mtm{
          *  in the world.
          */
         void printClan(std::ostream& os, const string& clan_name) const;
+
+        /**
+         * Get the strongest groups in the world, in the order of the groups
+         * comparison operators (the strongest first). Every clan keeps its
+         * groups ranked as they change, and the world keeps the clans
+         * ordered by their strongest groups, so it costs O(k log k) by
+         * merging the rankings of the clans, and the groups aren't copied.
+         * @param k The amount of groups to get. If the world has less groups,
+         *  all of them are returned.
+         * @return The groups. They are valid until the next change to the
+         *  world.
+         * @throws WorldInvalidArgument If k is negative.
+         */
+        std::vector<const Group*> topGroups(int k) const;
+
+        /**
+         * Get the strongest groups of a clan, like topGroups. It costs
+         * O(k + log c) for c clans.
+         * @param clan_name The name of the clan.
+         * @param k The amount of groups to get.
+         * @return The groups, the strongest first. They are valid until the
+         *  next change to the world.
+         * @throws WorldInvalidArgument If k is negative.
+         * @throws WorldClanNotFound If there is no clan with the given name
+         *  in the world.
+         */
+        std::vector<const Group*> topGroupsOfClan(const string& clan_name,
+                                                  int k) const;
+
+        /**
+         * The versions of the functions above that don't throw, for callers
+         * that expect many of their calls to fail (a stream of commands that
+         * wasn't checked, a reader that looks up names that may be gone).
+         * They return WORLD_SUCCESS, or the result that matches the
+         * exception the throwing function would throw, and then the world,
+         * the stream and the out parameter don't change. The throwing
+         * functions call them and throw the matching exception.
+         * reachable - set to what canReach returns.
+         * id - set to what schedule returns.
+         * results - set to what advanceTo returns.
+         * changes - set to what getRulerChanges returns.
+         * stats - set to what areaStats returns.
+         * groups - set to what topGroups or topGroupsOfClan returns.
+         */
+        WorldResult tryAddClan(const string& new_clan);
+        WorldResult tryAddArea(const string& area_name, AreaType type);
+        WorldResult tryAddGroup(const string& group_name,
+                                const string& clan_name, int num_children,
+                                int num_adults, const string& area_name);
+        WorldResult tryMakeReachable(const string& from, const string& to);
+        WorldResult tryMoveGroup(const string& group_name,
+                                 const string& destination);
+        WorldResult tryMoveGroupVia(const string& group_name,
+                                    const string& destination);
+        WorldResult tryMakeFriends(const string& clan1, const string& clan2);
+        WorldResult tryUniteClans(const string& clan1, const string& clan2,
+                                  const string& new_name);
+        WorldResult tryCanReach(const string& from, const string& to,
+                                bool& reachable) const;
+        WorldResult trySchedule(long long tick,
+                                const WorldOperation& operation,
+                                long long& id);
+        WorldResult tryAdvanceTo(long long tick,
+                                 std::vector<EventResult>& results);
+        WorldResult tryGetRulerChanges(const string& area_name,
+                                       int& changes) const;
+        WorldResult tryAreaStats(const string& area_name,
+                                 const AreaStats*& stats) const;
+        WorldResult tryPrintGroup(std::ostream& os,
+                                  const string& group_name) const;
+        WorldResult tryPrintClan(std::ostream& os,
+                                 const string& clan_name) const;
+        WorldResult tryTopGroups(int k,
+                                 std::vector<const Group*>& groups) const;
+        WorldResult tryTopGroupsOfClan(const string& clan_name, int k,
+                                       std::vector<const Group*>& groups)
+                                       const;
     };
     
 } // namespace mtm
@@ -0,0 +1,107 @@
+#ifndef MTM4_WORLD_OPERATION_H
+#define MTM4_WORLD_OPERATION_H
+
+#include <string>
+
+namespace mtm{
+
+    enum AreaType{ PLAIN, MOUNTAIN, RIVER };
+
+    /**
+     * The result of a world operation that doesn't throw. Every failure
+     * matches the exception the throwing function would throw.
+     */
+    enum WorldResult{
+        WORLD_SUCCESS,
+        WORLD_INVALID_ARGUMENT,         // WorldInvalidArgument
+        WORLD_GROUP_NAME_IS_TAKEN,      // WorldGroupNameIsTaken
+        WORLD_CLAN_NAME_IS_TAKEN,       // WorldClanNameIsTaken
+        WORLD_AREA_NAME_IS_TAKEN,       // WorldAreaNameIsTaken
+        WORLD_GROUP_NOT_FOUND,          // WorldGroupNotFound
+        WORLD_CLAN_NOT_FOUND,           // WorldClanNotFound
+        WORLD_AREA_NOT_FOUND,           // WorldAreaNotFound
+        WORLD_GROUP_ALREADY_IN_AREA,    // WorldGroupAlreadyInArea
+        WORLD_AREA_NOT_REACHABLE,       // WorldAreaNotReachable
+        WORLD_CLAN_CANT_UNITE,          // ClanCantUnite
+        WORLD_TRANSACTION_ACTIVE        // WorldTransactionActive
+    };
+
+    enum WorldOperationType{
+        ADD_CLAN, ADD_AREA, MAKE_REACHABLE, ADD_GROUP, MOVE_GROUP,
+        MAKE_FRIENDS, UNITE_CLANS
+    };
+
+    /**
+     * One mutating call on a world, stored as data so it can be applied in a
+     * batch. Build it with the static functions, that take the same
+     * arguments as the matching World function.
+     *
+     * The names are kept in first, second and third, in the order the World
+     * function takes them:
+     *  ADD_CLAN        - first: clan
+     *  ADD_AREA        - first: area, area_type
+     *  MAKE_REACHABLE  - first: from, second: to
+     *  ADD_GROUP       - first: group, second: clan, third: area,
+     *                    children, adults
+     *  MOVE_GROUP      - first: group, second: destination
+     *  MAKE_FRIENDS    - first: clan1, second: clan2
+     *  UNITE_CLANS     - first: clan1, second: clan2, third: new name
+     */
+    struct WorldOperation{
+        WorldOperationType type;
+        std::string first;
+        std::string second;
+        std::string third;
+        int children;
+        int adults;
+        AreaType area_type;
+
+        static WorldOperation addClan(const std::string& clan) {
+            return WorldOperation(ADD_CLAN, clan, "", "");
+        }
+
+        static WorldOperation addArea(const std::string& area, AreaType type) {
+            WorldOperation operation(ADD_AREA, area, "", "");
+            operation.area_type = type;
+            return operation;
+        }
+
+        static WorldOperation makeReachable(const std::string& from,
+                                            const std::string& to) {
+            return WorldOperation(MAKE_REACHABLE, from, to, "");
+        }
+
+        static WorldOperation addGroup(const std::string& group,
+                                       const std::string& clan, int children,
+                                       int adults, const std::string& area) {
+            WorldOperation operation(ADD_GROUP, group, clan, area);
+            operation.children = children;
+            operation.adults = adults;
+            return operation;
+        }
+
+        static WorldOperation moveGroup(const std::string& group,
+                                        const std::string& destination) {
+            return WorldOperation(MOVE_GROUP, group, destination, "");
+        }
+
+        static WorldOperation makeFriends(const std::string& clan1,
+                                          const std::string& clan2) {
+            return WorldOperation(MAKE_FRIENDS, clan1, clan2, "");
+        }
+
+        static WorldOperation uniteClans(const std::string& clan1,
+                                         const std::string& clan2,
+                                         const std::string& new_name) {
+            return WorldOperation(UNITE_CLANS, clan1, clan2, new_name);
+        }
+
+    private:
+        WorldOperation(WorldOperationType type, const std::string& first,
+                       const std::string& second, const std::string& third) :
+                type(type), first(first), second(second), third(third),
+                children(0), adults(0), area_type(PLAIN) {}
+    };
+} // namespace mtm
+
+#endif //MTM4_WORLD_OPERATION_H
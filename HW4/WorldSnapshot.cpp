@@ -0,0 +1,50 @@
+#include "WorldSnapshot.h"
+#include "exceptions.h"
+
+using namespace mtm ;
+/**
+ * WorldSnapshot.cpp , all functions are explained in WorldSnapshot.h .
+ */
+
+WorldSnapshot::WorldSnapshot() : groups(), clans(), ruler_changes(),
+                                 stats(), tick(0) {
+    stats.clans = 0;
+    stats.areas = 0;
+    stats.groups = 0;
+    stats.population = 0;
+    stats.ruler_changes = 0;
+}
+
+void WorldSnapshot::printGroup(std::ostream& os,
+                               const std::string& group_name) const {
+    const GroupView* group = groups.find(group_name);
+    if (group == nullptr) {
+        throw WorldGroupNotFound();
+    }
+    os << (*group).printed;
+}
+
+void WorldSnapshot::printClan(std::ostream& os,
+                              const std::string& clan_name) const {
+    const std::string* clan = clans.find(clan_name);
+    if (clan == nullptr) {
+        throw WorldClanNotFound();
+    }
+    os << *clan;
+}
+
+int WorldSnapshot::getRulerChanges(const std::string& area_name) const {
+    const int* changes = ruler_changes.find(area_name);
+    if (changes == nullptr) {
+        throw WorldAreaNotFound();
+    }
+    return *changes;
+}
+
+SnapshotStats WorldSnapshot::getStats() const {
+    return stats;
+}
+
+long long WorldSnapshot::getTick() const {
+    return tick;
+}
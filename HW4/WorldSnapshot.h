@@ -0,0 +1,86 @@
+#ifndef MTM4_WORLD_SNAPSHOT_H
+#define MTM4_WORLD_SNAPSHOT_H
+
+#include <ostream>
+#include <string>
+#include "PersistentMap.h"
+
+namespace mtm{
+
+    /**
+     * The totals of a world at the time of a snapshot.
+     */
+    struct SnapshotStats{
+        int clans;
+        int areas;
+        int groups;
+        long long population;
+        long long ruler_changes;
+    };
+
+    /**
+     * The state of a world at one moment, that doesn't change anymore.
+     * Any number of threads can query a snapshot without locking, while the
+     * world goes on changing.
+     * A snapshot keeps what its queries print, not the groups and clans
+     * themselves, and shares everything that didn't change with the
+     * snapshot before it, so taking a snapshot costs as much as the areas
+     * and clans that changed since the last one.
+     */
+    class WorldSnapshot{
+        friend class World;
+
+        /**
+         * What the snapshot knows about a group: its printGroup output, its
+         * clan and its size.
+         */
+        struct GroupView{
+            std::string printed;
+            std::string clan;
+            int size;
+        };
+        PersistentMap<GroupView> groups;
+        PersistentMap<std::string> clans;
+        PersistentMap<int> ruler_changes;
+        SnapshotStats stats;
+        long long tick;
+
+        WorldSnapshot();
+
+    public:
+        /**
+         * Print a group, the same as World::printGroup did when the
+         * snapshot was taken.
+         * @throws WorldGroupNotFound If there was no group with the given
+         *  name.
+         */
+        void printGroup(std::ostream& os, const std::string& group_name) const;
+
+        /**
+         * Print a clan, the same as World::printClan did when the snapshot
+         * was taken.
+         * @throws WorldClanNotFound If there was no clan with the given name.
+         */
+        void printClan(std::ostream& os, const std::string& clan_name) const;
+
+        /**
+         * @return The amount of times the ruler of an area changed, 0 if the
+         *  area isn't a mountain.
+         * @throws WorldAreaNotFound If there was no area with the given name.
+         */
+        int getRulerChanges(const std::string& area_name) const;
+
+        /**
+         * @return The number of clans, areas and groups, the people in all
+         *  the groups, and the ruler changes of all the mountains.
+         */
+        SnapshotStats getStats() const;
+
+        /**
+         * @return The tick the world was at when the snapshot was taken.
+         */
+        long long getTick() const;
+    };
+} // namespace mtm
+
+#endif //MTM4_WORLD_SNAPSHOT_H
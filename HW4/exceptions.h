@@ -43,6 +43,22 @@ namespace mtm{
     NEW_EXCEPTION(WorldAreaNotFound, WorldException);
     NEW_EXCEPTION(WorldGroupAlreadyInArea, WorldException);
     NEW_EXCEPTION(WorldAreaNotReachable, WorldException);
+    NEW_EXCEPTION(WorldTransactionActive, WorldException);
+    NEW_EXCEPTION(WorldNoTransaction, WorldException);
+
+    NEW_EXCEPTION(CommandLogException, std::exception);
+    NEW_EXCEPTION(CommandLogBadCommand, CommandLogException);
+    NEW_EXCEPTION(CommandLogTruncated, CommandLogException);
+
+    NEW_EXCEPTION(CheckpointException, std::exception);
+    NEW_EXCEPTION(CheckpointCantOpen, CheckpointException);
+    NEW_EXCEPTION(CheckpointBadFormat, CheckpointException);
+    NEW_EXCEPTION(CheckpointTruncated, CheckpointException);
+
+    NEW_EXCEPTION(JournalException, std::exception);
+    NEW_EXCEPTION(JournalCantOpen, JournalException);
+    NEW_EXCEPTION(JournalCantWrite, JournalException);
+    NEW_EXCEPTION(JournalBadFormat, JournalException);
     
     
     NEW_EXCEPTION(MTMSetException, std::exception);
@@ -2,6 +2,23 @@
 #include "testMacros.h"
 #include "exceptions.h"
 #include "World.h"
+#include "ConcurrentWorld.h"
+#include "CommandLog.h"
+#include "WorkloadGenerator.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "OutputBuffer.h"
+#include <sstream>
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <cstdio>
+#include <set>
+#include <map>
+#include <algorithm>
+#include <list>
+#include <csignal>
+#include <sys/resource.h>
 using namespace mtm;
 
 bool testWorldConstractor(){
@@ -189,6 +206,29 @@ bool testWorldUniteClans () {
     return true;
 }
 
+bool testWorldUniteClansMovesGroups() {
+    World w ;
+    w.addClan("Arryn");
+    w.addClan("Royce");
+    w.addClan("Baelish");
+    w.addArea("TheEyrie",MOUNTAIN);
+    w.addGroup("Yohn","Royce",0,10,"TheEyrie");
+    w.uniteClans("Arryn","Royce","TheVale");
+    //Petyr fights Yohn, the ruler, and wins.
+    w.addGroup("Petyr","Baelish",0,50,"TheEyrie");
+    std::ostringstream os;
+    w.printGroup(os,"Yohn");
+    ASSERT_TRUE(VerifyOutput(os, "Group's name: Yohn\n"
+                                 "Group's clan: TheVale\n"
+                                 "Group's children: 0\n"
+                                 "Group's adults: 6\n"
+                                 "Group's tools: 20\n"
+                                 "Group's food: 15\n"
+                                 "Group's morale: 56\n"
+                                 "Group's current area: TheEyrie\n"));
+    return true;
+}
+
 bool testWorldPrintGroup() {
     World w ;
     w.addClan("TheNorth");
@@ -295,6 +335,1476 @@ bool testWorldPrintClan(){
     return true ;
 }
 
+bool testWorldAreaLeaveArrive() {
+    World w ;
+    w.addClan("TheNorth");
+    w.addArea("Bravos",RIVER);
+    w.addArea("Pentos",RIVER);
+    w.makeReachable("Bravos","Pentos");
+    w.makeReachable("Pentos","Bravos");
+    w.addGroup("Stark","TheNorth",1,1,"Bravos");
+    w.addGroup("Karstark","TheNorth",2,2,"Bravos");
+    w.addGroup("Umber","TheNorth",3,3,"Bravos");
+    w.addGroup("Mormont","TheNorth",4,4,"Bravos");
+    ASSERT_NO_EXCEPTION(w.moveGroup("Stark","Pentos"));
+    ASSERT_EXCEPTION(w.moveGroup("Mormont","Bravos"),WorldGroupAlreadyInArea);
+    ASSERT_EXCEPTION(w.moveGroup("Stark","Pentos"),WorldGroupAlreadyInArea);
+    ASSERT_NO_EXCEPTION(w.moveGroup("Umber","Pentos"));
+    ASSERT_NO_EXCEPTION(w.moveGroup("Stark","Bravos"));
+    ASSERT_EXCEPTION(w.moveGroup("Karstark","Bravos"),WorldGroupAlreadyInArea);
+    std::ostringstream os;
+    w.printGroup(os,"Mormont");
+    ASSERT_TRUE(os.str().find("Group's current area: Bravos\n") !=
+                string::npos);
+    os.str("");
+    w.printGroup(os,"Umber");
+    ASSERT_TRUE(os.str().find("Group's current area: Pentos\n") !=
+                string::npos);
+    return true ;
+}
+
+bool testWorldMountainRulerChanges() {
+    World w ;
+    w.addClan("Arryn");
+    w.addClan("Baelish");
+    w.addClan("Corbray");
+    w.addArea("TheEyrie",MOUNTAIN);
+    w.addArea("TheVale",PLAIN);
+    w.makeReachable("TheEyrie","TheVale");
+    w.makeReachable("TheVale","TheEyrie");
+    ASSERT_EXCEPTION(w.getRulerChanges("Gulltown"),WorldAreaNotFound);
+    ASSERT_TRUE(w.getRulerChanges("TheVale") == 0);
+    w.addGroup("Jon","Arryn",0,10,"TheEyrie"); //first ruler
+    w.addGroup("Robin","Arryn",0,1,"TheEyrie"); //weaker, same clan
+    w.addGroup("Petyr","Baelish",0,5,"TheEyrie"); //loses to Jon
+    ASSERT_TRUE(w.getRulerChanges("TheEyrie") == 1);
+    w.moveGroup("Jon","TheVale"); //Robin is the strongest of Arryn
+    ASSERT_TRUE(w.getRulerChanges("TheEyrie") == 2);
+    w.addGroup("Lyn","Corbray",1,1,"TheEyrie"); //beats Robin, not Petyr
+    ASSERT_TRUE(w.getRulerChanges("TheEyrie") == 3);
+    ASSERT_EXCEPTION(w.moveGroup("Robin","TheVale"),WorldGroupNotFound);
+    w.moveGroup("Lyn","TheVale"); //no Corbray left, Petyr rules
+    ASSERT_TRUE(w.getRulerChanges("TheEyrie") == 4);
+    w.moveGroup("Petyr","TheVale"); //nobody rules
+    ASSERT_TRUE(w.getRulerChanges("TheEyrie") == 4);
+    w.moveGroup("Petyr","TheEyrie");
+    ASSERT_TRUE(w.getRulerChanges("TheEyrie") == 5);
+    return true ;
+}
+
+bool testWorldRiverTradePartner() {
+    World w ;
+    w.addClan("TheNorth");
+    w.addClan("TheVale");
+    w.addClan("TheIronIslands");
+    w.addArea("Trident",RIVER);
+    w.makeFriends("TheNorth","TheVale");
+    w.addGroup("Arryn","TheVale",0,2,"Trident"); //more tools
+    w.addGroup("Greyjoy","TheIronIslands",0,10,"Trident"); //more tools
+    w.addGroup("Stark","TheNorth",10,0,"Trident"); //trades with Arryn
+    std::ostringstream os;
+    w.printGroup(os,"Stark");
+    ASSERT_TRUE(VerifyOutput(os, "Group's name: Stark\n"
+                                 "Group's clan: TheNorth\n"
+                                 "Group's children: 10\n"
+                                 "Group's adults: 0\n"
+                                 "Group's tools: 6\n"
+                                 "Group's food: 14\n"
+                                 "Group's morale: 77\n"
+                                 "Group's current area: Trident\n"));
+    w.printGroup(os,"Greyjoy");
+    ASSERT_TRUE(VerifyOutput(os, "Group's name: Greyjoy\n"
+                                 "Group's clan: TheIronIslands\n"
+                                 "Group's children: 0\n"
+                                 "Group's adults: 10\n"
+                                 "Group's tools: 40\n"
+                                 "Group's food: 30\n"
+                                 "Group's morale: 77\n"
+                                 "Group's current area: Trident\n"));
+    w.makeFriends("TheNorth","TheIronIslands");
+    w.addGroup("Karstark","TheNorth",10,0,"Trident"); //trades with Greyjoy
+    w.printGroup(os,"Karstark");
+    ASSERT_TRUE(VerifyOutput(os, "Group's name: Karstark\n"
+                                 "Group's clan: TheNorth\n"
+                                 "Group's children: 10\n"
+                                 "Group's adults: 0\n"
+                                 "Group's tools: 8\n"
+                                 "Group's food: 12\n"
+                                 "Group's morale: 77\n"
+                                 "Group's current area: Trident\n"));
+    return true ;
+}
+
+bool testWorldSplitNameReuse() {
+    World w ;
+    w.addClan("Dothraki");
+    w.addClan("Giants");
+    w.addArea("GrassSea",PLAIN);
+    w.addArea("Skagos",MOUNTAIN);
+    w.addArea("Rhoyne",RIVER);
+    w.makeReachable("GrassSea","Skagos");
+    w.makeReachable("Skagos","Rhoyne");
+    w.makeReachable("Rhoyne","Skagos");
+    w.makeReachable("Rhoyne","GrassSea");
+    w.addGroup("Titan","Giants",0,100,"Skagos");
+    w.addGroup("Horde","Dothraki",20,20,"GrassSea"); //splits to Horde_2
+    ASSERT_NO_EXCEPTION(w.moveGroup("Horde_2","Skagos"));
+    for (int i = 0; i < 4; ++i) { //loses to Titan until nobody is left
+        ASSERT_NO_EXCEPTION(w.moveGroup("Horde_2","Rhoyne"));
+        ASSERT_NO_EXCEPTION(w.moveGroup("Horde_2","Skagos"));
+    }
+    ASSERT_EXCEPTION(w.moveGroup("Horde_2","Rhoyne"),WorldGroupNotFound);
+    w.moveGroup("Horde","Skagos");
+    w.moveGroup("Horde","Rhoyne");
+    w.moveGroup("Horde","GrassSea"); //splits again, Horde_2 is free
+    std::ostringstream os;
+    w.printGroup(os,"Horde_2");
+    ASSERT_TRUE(os.str().find("Group's current area: GrassSea\n") !=
+                string::npos);
+    return true ;
+}
+
+bool testWorldApplyBatch() {
+    World w ;
+    std::vector<WorldOperation> operations;
+    operations.push_back(WorldOperation::addClan("Beyond"));
+    operations.push_back(WorldOperation::addClan("Beyond"));
+    operations.push_back(WorldOperation::addArea("Hardhome",RIVER));
+    operations.push_back(WorldOperation::addArea("TheFist",MOUNTAIN));
+    operations.push_back(WorldOperation::makeReachable("Hardhome","Wall"));
+    operations.push_back(WorldOperation::makeReachable("Hardhome","TheFist"));
+    operations.push_back(WorldOperation::addGroup("Wildlings","Beyond",10,10,
+                                                  "Hardhome"));
+    operations.push_back(WorldOperation::addGroup("Thenns","Beyond",0,0,
+                                                  "Hardhome"));
+    operations.push_back(WorldOperation::addGroup("Wildlings","Beyond",1,1,
+                                                  "TheFist"));
+    operations.push_back(WorldOperation::addGroup("Thenns","North",1,1,
+                                                  "Hardhome"));
+    operations.push_back(WorldOperation::moveGroup("Wildlings","Hardhome"));
+    operations.push_back(WorldOperation::moveGroup("Wildlings","TheFist"));
+    operations.push_back(WorldOperation::moveGroup("Wildlings","Hardhome"));
+    operations.push_back(WorldOperation::makeFriends("Beyond","North"));
+    operations.push_back(WorldOperation::addClan("North"));
+    operations.push_back(WorldOperation::uniteClans("Beyond","Beyond","Free"));
+    operations.push_back(WorldOperation::uniteClans("Beyond","North","Free"));
+    operations.push_back(WorldOperation::addGroup("Thenns","Beyond",1,1,
+                                                  "TheFist"));
+    operations.push_back(WorldOperation::addClan("Beyond"));
+    std::vector<WorldResult> results = w.applyBatch(operations);
+    WorldResult expected[] = { WORLD_SUCCESS, WORLD_CLAN_NAME_IS_TAKEN,
+            WORLD_SUCCESS, WORLD_SUCCESS, WORLD_AREA_NOT_FOUND,
+            WORLD_SUCCESS, WORLD_SUCCESS, WORLD_INVALID_ARGUMENT,
+            WORLD_GROUP_NAME_IS_TAKEN, WORLD_CLAN_NOT_FOUND,
+            WORLD_GROUP_ALREADY_IN_AREA, WORLD_SUCCESS,
+            WORLD_AREA_NOT_REACHABLE, WORLD_CLAN_NOT_FOUND, WORLD_SUCCESS,
+            WORLD_CLAN_CANT_UNITE, WORLD_SUCCESS, WORLD_CLAN_NOT_FOUND,
+            WORLD_CLAN_NAME_IS_TAKEN };
+    ASSERT_TRUE(results.size() == operations.size());
+    for (unsigned int i = 0; i < results.size(); ++i) {
+        ASSERT_TRUE(results[i] == expected[i]);
+    }
+    ASSERT_TRUE(w.apply(WorldOperation::addGroup("Thenns","Free",1,1,
+                                                 "TheFist")) == WORLD_SUCCESS);
+    std::ostringstream os;
+    w.printClan(os,"Free");
+    ASSERT_TRUE(os.str().find("Wildlings") != string::npos);
+    ASSERT_TRUE(os.str().find("Thenns") != string::npos);
+    ASSERT_EXCEPTION(w.addClan("North"),WorldClanNameIsTaken);
+    return true ;
+}
+
+bool testCommandLogRoundTrip() {
+    std::vector<Command> commands;
+    WorkloadGenerator generator(300, 7);
+    Command command;
+    while (generator.next(command)) {
+        commands.push_back(command);
+    }
+    commands.push_back(Command::printClan("clan0"));
+    commands.push_back(Command::schedule(3, WorldOperation::moveGroup("a",
+                                                                      "b")));
+    commands.push_back(Command::advance(7));
+    for (int binary = 0; binary < 2; ++binary) {
+        std::stringstream log;
+        CommandWriter writer(log, binary == 1);
+        for (unsigned int i = 0; i < commands.size(); ++i) {
+            writer.write(commands[i]);
+        }
+        CommandReader reader(log);
+        ASSERT_TRUE(reader.isBinary() == (binary == 1));
+        for (unsigned int i = 0; i < commands.size(); ++i) {
+            ASSERT_TRUE(reader.next(command));
+            ASSERT_TRUE(command.type == commands[i].type);
+            ASSERT_TRUE(command.first == commands[i].first);
+            ASSERT_TRUE(command.second == commands[i].second);
+            ASSERT_TRUE(command.third == commands[i].third);
+            ASSERT_TRUE(command.children == commands[i].children);
+            ASSERT_TRUE(command.adults == commands[i].adults);
+            ASSERT_TRUE(command.area_type == commands[i].area_type);
+            ASSERT_TRUE(command.tick == commands[i].tick);
+        }
+        ASSERT_TRUE(!reader.next(command));
+    }
+    std::istringstream text("# a comment\n\nclan add North\n"
+                            "area add Wall mountain\nmove Crows\n"
+                            "print clan North\nat 4 move Crows Wall\n"
+                            "advance 9\nat 4 advance 9\n");
+    CommandReader reader(text);
+    ASSERT_TRUE(reader.next(command) && command.type == CLAN_ADD);
+    ASSERT_TRUE(reader.next(command) && command.area_type == MOUNTAIN);
+    ASSERT_EXCEPTION(reader.next(command),CommandLogBadCommand);
+    ASSERT_TRUE(reader.getLine() == 5);
+    ASSERT_TRUE(reader.next(command) && command.type == PRINT_CLAN);
+    ASSERT_TRUE(reader.next(command) && command.type == MOVE);
+    ASSERT_TRUE(command.tick == 4 && command.second == "Wall");
+    ASSERT_TRUE(reader.next(command) && command.type == ADVANCE);
+    ASSERT_TRUE(command.tick == 9);
+    ASSERT_EXCEPTION(reader.next(command),CommandLogBadCommand);
+    std::string cut("\x7fWLOG\x01\x03\x05\0\0\0Cro", 13);
+    std::istringstream binary(cut);
+    CommandReader binary_reader(binary);
+    ASSERT_EXCEPTION(binary_reader.next(command),CommandLogTruncated);
+    return true ;
+}
+
+bool testWorldMoveGroupVia() {
+    World w ;
+    w.addClan("Nights");
+    w.addClan("Others");
+    const char* names[] = { "Castle", "Shadow", "Tower", "Fist", "Lands",
+                            "Cave" };
+    AreaType types[] = { PLAIN, RIVER, PLAIN, MOUNTAIN, RIVER, PLAIN };
+    for (int i = 0; i < 6; ++i) {
+        w.addArea(names[i],types[i]);
+    }
+    for (int i = 0; i < 4; ++i) { //Castle -> Shadow -> Tower -> Fist -> Lands
+        w.makeReachable(names[i],names[i + 1]);
+    }
+    w.makeReachable("Lands","Castle");
+    ASSERT_TRUE(w.canReach("Castle","Lands"));
+    ASSERT_TRUE(w.canReach("Fist","Shadow"));
+    ASSERT_TRUE(w.canReach("Cave","Cave"));
+    ASSERT_TRUE(!w.canReach("Castle","Cave"));
+    ASSERT_TRUE(!w.canReach("Cave","Castle"));
+    ASSERT_EXCEPTION(w.canReach("Castle","Wall"),WorldAreaNotFound);
+    w.addGroup("Rangers","Nights",0,10,"Castle");
+    ASSERT_EXCEPTION(w.moveGroup("Rangers","Tower"),WorldAreaNotReachable);
+    ASSERT_EXCEPTION(w.moveGroupVia("Rangers","Cave"),WorldAreaNotReachable);
+    ASSERT_EXCEPTION(w.moveGroupVia("Rangers","Castle"),
+                     WorldGroupAlreadyInArea);
+    ASSERT_EXCEPTION(w.moveGroupVia("Builders","Tower"),WorldGroupNotFound);
+    ASSERT_EXCEPTION(w.moveGroupVia("Rangers","Wall"),WorldAreaNotFound);
+    ASSERT_NO_EXCEPTION(w.moveGroupVia("Rangers","Tower"));
+    std::ostringstream os;
+    w.printGroup(os,"Rangers");
+    ASSERT_TRUE(os.str().find("current area: Tower\n") != string::npos);
+    //a shortcut makes the path from Tower to Castle shorter.
+    w.makeReachable("Tower","Lands");
+    ASSERT_NO_EXCEPTION(w.moveGroupVia("Rangers","Castle"));
+    ASSERT_TRUE(w.getRulerChanges("Fist") == 0);
+    //the group dies on the way in Fist, and doesn't go on to Gate.
+    w.addArea("Gate",RIVER);
+    w.makeReachable("Fist","Gate");
+    w.addGroup("Walkers","Others",0,100,"Fist");
+    w.addGroup("Recruits","Nights",1,0,"Shadow");
+    w.makeReachable("Shadow","Fist");
+    ASSERT_NO_EXCEPTION(w.moveGroupVia("Recruits","Gate"));
+    ASSERT_EXCEPTION(w.printGroup(os,"Recruits"),WorldGroupNotFound);
+    ASSERT_TRUE(w.getRulerChanges("Fist") == 1);
+    return true ;
+}
+
+bool testWorldScheduler() {
+    World w ;
+    w.addClan("Starks");
+    w.addClan("Boltons");
+    w.addClan("Freys");
+    w.addArea("Winterfell",PLAIN);
+    w.addArea("Dreadfort",RIVER);
+    w.makeReachable("Winterfell","Dreadfort");
+    w.makeReachable("Dreadfort","Winterfell");
+    w.addGroup("Bastards","Starks",0,10,"Winterfell");
+    ASSERT_TRUE(w.schedule(5,WorldOperation::moveGroup("Bastards",
+                                                       "Dreadfort")) == 0);
+    ASSERT_TRUE(w.schedule(3,WorldOperation::moveGroup("Bastards",
+                                                       "Dreadfort")) == 1);
+    ASSERT_TRUE(w.schedule(5,WorldOperation::moveGroup("Bastards",
+                                                       "Winterfell")) == 2);
+    w.schedule(8,WorldOperation::makeFriends("Starks","Boltons"));
+    w.schedule(9,WorldOperation::uniteClans("Boltons","Freys","North"));
+    ASSERT_TRUE(w.getPendingEvents() == 5);
+    ASSERT_TRUE(w.advanceTo(2).empty());
+    std::vector<EventResult> results = w.advanceTo(5);
+    ASSERT_TRUE(results.size() == 3);
+    ASSERT_TRUE(results[0].id == 1 && results[0].tick == 3);
+    ASSERT_TRUE(results[0].result == WORLD_SUCCESS);
+    ASSERT_TRUE(results[1].id == 0 && results[1].tick == 5);
+    ASSERT_TRUE(results[1].result == WORLD_GROUP_ALREADY_IN_AREA);
+    ASSERT_TRUE(results[2].id == 2 && results[2].result == WORLD_SUCCESS);
+    std::ostringstream os;
+    w.printGroup(os,"Bastards");
+    ASSERT_TRUE(os.str().find("current area: Winterfell\n") != string::npos);
+    ASSERT_TRUE(w.getCurrentTick() == 5);
+    ASSERT_EXCEPTION(w.advanceTo(4),WorldInvalidArgument);
+    ASSERT_EXCEPTION(w.schedule(4,WorldOperation::addClan("Late")),
+                     WorldInvalidArgument);
+    results = w.advanceTo(100);
+    ASSERT_TRUE(results.size() == 2);
+    ASSERT_TRUE(results[1].result == WORLD_SUCCESS);
+    ASSERT_NO_EXCEPTION(w.printClan(os,"North"));
+    ASSERT_TRUE(w.getPendingEvents() == 0);
+    ASSERT_TRUE(w.getSchedulerStats().events_processed == 5);
+    return true ;
+}
+
+/**
+ * Builds a generated world, then applies generated moves to it, in parallel
+ * or not, and prints everything the world shows.
+ */
+static string applyGeneratedMoves(int threads, std::vector<WorldResult>&
+results) {
+    World w ;
+    WorkloadGenerator generator(3000, 11);
+    Command command;
+    std::vector<string> clans;
+    std::vector<string> areas;
+    while (generator.next(command)) {
+        if (command.isOperation()) {
+            w.apply(command.toOperation());
+        }
+        if (command.type == CLAN_ADD) {
+            clans.push_back(command.first);
+        } else if (command.type == AREA_ADD) {
+            areas.push_back(command.first);
+        }
+    }
+    std::vector<WorldOperation> moves;
+    for (int i = 0; i < 6000; ++i) {
+        moves.push_back(generator.nextMove());
+        if (i % 1000 == 999) {
+            moves.push_back(WorldOperation::addClan("late" +
+                                                    std::to_string(i)));
+        }
+    }
+    results = threads == 0 ? w.applyBatch(moves) :
+              w.applyBatchConcurrently(moves, threads);
+    std::ostringstream os;
+    for (unsigned int i = 0; i < clans.size(); ++i) {
+        try {
+            w.printClan(os, clans[i]);
+        } catch (const WorldClanNotFound&) {}
+    }
+    for (int i = 0; i < 3000; ++i) {
+        string name = "group" + std::to_string(i);
+        for (int split = 1; split < 4; ++split) {
+            try {
+                w.printGroup(os, name);
+            } catch (const WorldGroupNotFound&) {}
+            name = "group" + std::to_string(i) + "_" +
+                   std::to_string(split + 1);
+        }
+    }
+    for (unsigned int i = 0; i < areas.size(); ++i) {
+        os << w.getRulerChanges(areas[i]) << " ";
+    }
+    return os.str();
+}
+
+bool testWorldApplyBatchConcurrently() {
+    std::vector<WorldResult> sequential_results;
+    string sequential = applyGeneratedMoves(0, sequential_results);
+    for (int threads = 1; threads <= 4; threads += 3) {
+        std::vector<WorldResult> results;
+        ASSERT_TRUE(applyGeneratedMoves(threads, results) == sequential);
+        ASSERT_TRUE(results == sequential_results);
+    }
+    return true ;
+}
+
+bool testConcurrentWorldReaders() {
+    World w ;
+    ConcurrentWorld concurrent ;
+    WorkloadGenerator generator(500, 5);
+    Command command;
+    while (generator.next(command)) {
+        if (command.isOperation()) {
+            w.apply(command.toOperation());
+            concurrent.apply(command.toOperation());
+        }
+    }
+    std::atomic<bool> stop(false);
+    std::atomic<int> reads(0);
+    std::atomic<int> bad_reads(0);
+    std::vector<std::thread> readers;
+    for (int reader = 0; reader < 3; ++reader) {
+        readers.push_back(std::thread([&concurrent, &stop, &reads, &bad_reads,
+                                       reader]() {
+            int i = reader;
+            while (!stop) {
+                std::ostringstream os;
+                string name = WorkloadGenerator::groupName(i++ % 500);
+                try {
+                    concurrent.printGroup(os, name);
+                    if (os.str().find("Group's name: " + name) != 0) {
+                        bad_reads++;
+                    }
+                } catch (const WorldGroupNotFound&) {}
+                concurrent.printClan(os, WorkloadGenerator::clanName(2));
+                reads++;
+            }
+        }));
+    }
+    for (int i = 0; i < 2000; ++i) {
+        WorldOperation move = generator.nextMove();
+        ASSERT_TRUE(w.apply(move) == concurrent.apply(move));
+    }
+    while (reads < 3) {
+        std::this_thread::yield();
+    }
+    stop = true;
+    for (unsigned int i = 0; i < readers.size(); ++i) {
+        readers[i].join();
+    }
+    ASSERT_TRUE(bad_reads == 0);
+    for (int i = 0; i < 500; ++i) {
+        std::ostringstream expected;
+        std::ostringstream os;
+        string name = WorkloadGenerator::groupName(i);
+        try {
+            w.printGroup(expected, name);
+        } catch (const WorldGroupNotFound&) {}
+        try {
+            concurrent.printGroup(os, name);
+        } catch (const WorldGroupNotFound&) {}
+        ASSERT_TRUE(os.str() == expected.str());
+    }
+    return true ;
+}
+
+/**
+ * Prints everything a snapshot shows about the groups and clans of a
+ * generated world of 800 groups.
+ */
+static string printSnapshot(const WorldSnapshot& snapshot) {
+    std::ostringstream os;
+    for (int i = 0; i < 8; ++i) {
+        try {
+            snapshot.printClan(os, WorkloadGenerator::clanName(i));
+        } catch (const WorldClanNotFound&) {}
+    }
+    for (int i = 0; i < 800; ++i) {
+        string name = WorkloadGenerator::groupName(i);
+        for (int split = 1; split < 4; ++split) {
+            try {
+                snapshot.printGroup(os, name);
+            } catch (const WorldGroupNotFound&) {}
+            name = WorkloadGenerator::groupName(i) + "_" +
+                   std::to_string(split + 1);
+        }
+    }
+    SnapshotStats stats = snapshot.getStats();
+    os << stats.clans << " " << stats.areas << " " << stats.groups << " "
+       << stats.population << " " << stats.ruler_changes;
+    return os.str();
+}
+
+bool testWorldSnapshot() {
+    World w ;
+    World once ;
+    WorkloadGenerator generator(800, 3);
+    Command command;
+    while (generator.next(command)) {
+        if (command.isOperation()) {
+            w.apply(command.toOperation());
+            once.apply(command.toOperation());
+        }
+    }
+    std::shared_ptr<const WorldSnapshot> first = w.snapshot();
+    ASSERT_TRUE(w.getSnapshot() == first);
+    string first_printed = printSnapshot(*first);
+    std::ostringstream os;
+    w.printGroup(os, "group1");
+    ASSERT_TRUE(first_printed.find(os.str()) != string::npos);
+    ASSERT_EXCEPTION((*first).printGroup(os, "nobody"), WorldGroupNotFound);
+    ASSERT_EXCEPTION((*first).printClan(os, "nobody"), WorldClanNotFound);
+    for (int i = 0; i < 2000; ++i) {
+        WorldOperation move = generator.nextMove();
+        w.apply(move);
+        once.apply(move);
+        if (i % 500 == 0) {
+            w.snapshot();
+        }
+    }
+    w.uniteClans("clan1", "clan3", "clan5");
+    once.uniteClans("clan1", "clan3", "clan5");
+    std::shared_ptr<const WorldSnapshot> last = w.snapshot();
+    ASSERT_TRUE(printSnapshot(*first) == first_printed);
+    ASSERT_TRUE(printSnapshot(*last) == printSnapshot(*(once.snapshot())));
+    ASSERT_TRUE(printSnapshot(*last) != first_printed);
+    std::ostringstream expected;
+    std::ostringstream printed;
+    w.printClan(expected, "clan5");
+    (*last).printClan(printed, "clan5");
+    ASSERT_TRUE(printed.str() == expected.str());
+    ASSERT_EXCEPTION((*last).printClan(printed, "clan3"), WorldClanNotFound);
+    return true ;
+}
+
+static string readFile(const string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return string((std::istreambuf_iterator<char>(in)),
+                  std::istreambuf_iterator<char>());
+}
+
+bool testWorldCheckpoint() {
+    World w ;
+    WorkloadGenerator generator(800, 5);
+    Command command;
+    while (generator.next(command)) {
+        if (command.isOperation()) {
+            w.apply(command.toOperation());
+        }
+    }
+    for (int i = 0; i < 1000; ++i) {
+        w.apply(generator.nextMove());
+    }
+    w.uniteClans("clan0", "clan2", "clan6");
+    w.advanceTo(4);
+    w.schedule(7, WorldOperation::uniteClans("clan1", "clan3", "clan7"));
+    w.schedule(9, generator.nextMove());
+    const string path = "testWorldCheckpoint.wckp";
+    w.saveCheckpoint(path);
+    std::unique_ptr<World> loaded = World::loadCheckpoint(path);
+    ASSERT_TRUE(printSnapshot(*(loaded->snapshot())) ==
+                printSnapshot(*(w.snapshot())));
+    ASSERT_TRUE(loaded->getCurrentTick() == 4);
+    ASSERT_TRUE(loaded->getPendingEvents() == 2);
+    //the rankings are loaded in order, the same as the ones that were saved.
+    std::vector<const Group*> saved_top = w.topGroups(1 << 30);
+    std::vector<const Group*> loaded_top = loaded->topGroups(1 << 30);
+    ASSERT_TRUE(saved_top.size() == loaded_top.size());
+    for (unsigned int i = 0; i < saved_top.size(); ++i) {
+        ASSERT_TRUE((*(saved_top[i])).getName() ==
+                    (*(loaded_top[i])).getName());
+    }
+    std::vector<const Group*> clan_top = loaded->topGroupsOfClan("clan6", 5);
+    ASSERT_TRUE(clan_top.size() == w.topGroupsOfClan("clan6", 5).size());
+    for (int i = 0; i < 1000; ++i) {
+        WorldOperation move = generator.nextMove();
+        ASSERT_TRUE(loaded->apply(move) == w.apply(move));
+    }
+    std::vector<EventResult> expected = w.advanceTo(10);
+    std::vector<EventResult> results = loaded->advanceTo(10);
+    ASSERT_TRUE(results.size() == 2 && expected.size() == 2);
+    for (int i = 0; i < 2; ++i) {
+        ASSERT_TRUE(results[i].id == expected[i].id);
+        ASSERT_TRUE(results[i].result == expected[i].result);
+    }
+    ASSERT_TRUE(printSnapshot(*(loaded->snapshot())) ==
+                printSnapshot(*(w.snapshot())));
+    ASSERT_TRUE(loaded->canReach("area0", "area1") ==
+                w.canReach("area0", "area1"));
+    string saved = readFile(path);
+    std::ofstream(path, std::ios::binary) << saved.substr(0, saved.size() / 2);
+    ASSERT_EXCEPTION(World::loadCheckpoint(path), CheckpointTruncated);
+    std::ofstream(path, std::ios::binary) << "WLOG" << saved.substr(4);
+    ASSERT_EXCEPTION(World::loadCheckpoint(path), CheckpointBadFormat);
+    std::remove(path.c_str());
+    ASSERT_EXCEPTION(World::loadCheckpoint(path), CheckpointCantOpen);
+    return true ;
+}
+
+bool testWorldJournalRecover() {
+    const string checkpoint = "testWorldJournalRecover.wckp";
+    const string journal = "testWorldJournalRecover.wjnl";
+    std::remove(checkpoint.c_str());
+    std::remove(journal.c_str());
+    World w ;
+    w.openJournal(journal, 16, 1000);
+    WorkloadGenerator generator(400, 11);
+    Command command;
+    while (generator.next(command)) {
+        if (command.isOperation()) {
+            w.apply(command.toOperation());
+        }
+    }
+    w.schedule(3, generator.nextMove());
+    w.advanceTo(2);
+    std::vector<WorldOperation> batch;
+    for (int i = 0; i < 300; ++i) {
+        batch.push_back(generator.nextMove());
+    }
+    w.applyBatch(batch);
+    w.saveCheckpoint(checkpoint);
+    string old_journal = readFile(journal);
+    w.applyBatchConcurrently(batch, 2);
+    bool moved = false;
+    for (int i = 0; !moved; ++i) {
+        try {
+            w.moveGroupVia(WorkloadGenerator::groupName(i), "area2");
+            moved = true;
+        } catch (const WorldException&) {}
+    }
+    w.schedule(6, WorldOperation::uniteClans("clan0", "clan1", "clan4"));
+    w.advanceTo(8);
+    w.schedule(9, generator.nextMove());
+    w.syncJournal();
+    ASSERT_TRUE(w.getJournalStats().records > 600);
+    string expected = printSnapshot(*(w.snapshot()));
+    std::unique_ptr<World> recovered = World::recover(checkpoint, journal,
+                                                      16, 1000);
+    ASSERT_TRUE(printSnapshot(*(recovered->snapshot())) == expected);
+    ASSERT_TRUE(recovered->getCurrentTick() == 8);
+    ASSERT_TRUE(recovered->getPendingEvents() == 1);
+    recovered.reset();
+    //a crash in the middle of a command cuts it, and it is dropped.
+    string synced = readFile(journal);
+    std::ofstream(journal, std::ios::binary | std::ios::app) << "\x04\x07";
+    recovered = World::recover(checkpoint, journal, 16, 1000);
+    ASSERT_TRUE(printSnapshot(*(recovered->snapshot())) == expected);
+    recovered.reset();
+    ASSERT_TRUE(readFile(journal) == synced);
+    //a crash after the checkpoint, before the journal started over.
+    std::ofstream(journal, std::ios::binary) << old_journal;
+    World once ;
+    WorkloadGenerator again(400, 11);
+    while (again.next(command)) {
+        if (command.isOperation()) {
+            once.apply(command.toOperation());
+        }
+    }
+    once.schedule(3, again.nextMove());
+    once.advanceTo(2);
+    once.applyBatch(batch);
+    recovered = World::recover(checkpoint, journal, 16, 1000);
+    ASSERT_TRUE(printSnapshot(*(recovered->snapshot())) ==
+                printSnapshot(*(once.snapshot())));
+    recovered.reset();
+    std::ofstream(journal, std::ios::binary)
+            << "not a journal, just a line of text";
+    ASSERT_EXCEPTION(World::recover(checkpoint, journal, 16, 1000),
+                     JournalBadFormat);
+    std::remove(checkpoint.c_str());
+    std::remove(journal.c_str());
+    return true ;
+}
+
+bool testWorldJournalFailedSync() {
+    const string journal = "testWorldJournalFailedSync.wjnl";
+    std::remove(journal.c_str());
+    World w ;
+    World once ;
+    w.openJournal(journal, 1000000, 1000000);
+    WorkloadGenerator generator(200, 19);
+    Command command;
+    while (generator.next(command)) {
+        if (command.isOperation()) {
+            w.apply(command.toOperation());
+            once.apply(command.toOperation());
+        }
+    }
+    //the file can't grow past a few bytes more than it has, so the sync
+    //writes a part of the commands and fails.
+    string synced = readFile(journal);
+    struct rlimit limit;
+    getrlimit(RLIMIT_FSIZE, &limit);
+    struct rlimit small = limit;
+    small.rlim_cur = synced.size() + 10;
+    void (*handler)(int) = signal(SIGXFSZ, SIG_IGN);
+    setrlimit(RLIMIT_FSIZE, &small);
+    ASSERT_EXCEPTION(w.syncJournal(), JournalCantWrite);
+    ASSERT_EXCEPTION(w.syncJournal(), JournalCantWrite);
+    setrlimit(RLIMIT_FSIZE, &limit);
+    signal(SIGXFSZ, handler);
+    ASSERT_TRUE(w.getJournalStats().syncs == 0);
+    //the commands were kept, and the next sync writes them.
+    w.syncJournal();
+    ASSERT_TRUE(w.getJournalStats().syncs == 1);
+    std::unique_ptr<World> recovered = World::recover(
+            "testWorldJournalFailedSync.wckp", journal, 16, 1000);
+    ASSERT_TRUE(printSnapshot(*(recovered->snapshot())) ==
+                printSnapshot(*(once.snapshot())));
+    recovered.reset();
+    std::remove(journal.c_str());
+    return true ;
+}
+
+static bool sameStats(const SnapshotStats& s1, const SnapshotStats& s2) {
+    return (s1.clans == s2.clans) && (s1.areas == s2.areas) &&
+           (s1.groups == s2.groups) && (s1.population == s2.population) &&
+           (s1.ruler_changes == s2.ruler_changes);
+}
+
+bool testWorldFork() {
+    World w ;
+    World once ;
+    WorkloadGenerator generator(400, 13);
+    Command command;
+    while (generator.next(command)) {
+        if (command.isOperation()) {
+            w.apply(command.toOperation());
+            once.apply(command.toOperation());
+        }
+    }
+    string before = printSnapshot(*(w.snapshot()));
+    std::vector<std::vector<WorldOperation> > scenarios(3);
+    for (int i = 0; i < 500; ++i) {
+        scenarios[0].push_back(generator.nextMove());
+        scenarios[1].push_back(generator.nextMove());
+    }
+    scenarios[1].push_back(WorldOperation::uniteClans("clan0", "clan1",
+                                                      "clan5"));
+    std::unique_ptr<World> fork = w.fork();
+    (*fork).applyBatch(scenarios[0]);
+    once.applyBatch(scenarios[0]);
+    ASSERT_TRUE(printSnapshot(*((*fork).snapshot())) ==
+                printSnapshot(*(once.snapshot())));
+    ASSERT_TRUE(printSnapshot(*(w.snapshot())) == before);
+    std::vector<ScenarioResult> results = w.runScenarios(scenarios, 2);
+    ASSERT_TRUE(results.size() == 3);
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(results[i].succeeded + results[i].failed ==
+                    static_cast<int>(scenarios[i].size()));
+    }
+    ASSERT_TRUE(sameStats(results[0].stats, once.getSnapshot()->getStats()));
+    ASSERT_TRUE(sameStats(results[2].stats, w.getSnapshot()->getStats()));
+    ASSERT_TRUE(results[1].stats.clans == results[2].stats.clans - 1);
+    ASSERT_TRUE(printSnapshot(*(w.snapshot())) == before);
+    return true ;
+}
+
+bool testWorldTransaction() {
+    const string journal = "testWorldTransaction.wjnl";
+    std::remove(journal.c_str());
+    World w ;
+    World once ;
+    WorkloadGenerator generator(400, 17);
+    Command command;
+    while (generator.next(command)) {
+        if (command.isOperation()) {
+            w.apply(command.toOperation());
+            once.apply(command.toOperation());
+        }
+    }
+    string before = printSnapshot(*(w.snapshot()));
+    w.openJournal(journal, 16, 1000);
+    std::vector<WorldOperation> operations;
+    for (int i = 0; i < 300; ++i) {
+        operations.push_back(generator.nextMove());
+    }
+    operations.push_back(WorldOperation::addClan("new clan"));
+    operations.push_back(WorldOperation::addArea("new area", MOUNTAIN));
+    operations.push_back(WorldOperation::makeReachable("area0", "new area"));
+    operations.push_back(WorldOperation::makeReachable("new area", "area1"));
+    operations.push_back(WorldOperation::addGroup("new group", "clan2", 30,
+                                                  40, "new area"));
+    operations.push_back(WorldOperation::makeFriends("new clan", "clan3"));
+    operations.push_back(WorldOperation::uniteClans("clan0", "clan1",
+                                                    "clan0"));
+    for (int i = 0; i < 300; ++i) {
+        operations.push_back(generator.nextMove());
+    }
+    w.beginTransaction();
+    ASSERT_TRUE(w.inTransaction());
+    ASSERT_EXCEPTION(w.beginTransaction(), WorldTransactionActive);
+    ASSERT_EXCEPTION(w.advanceTo(1), WorldTransactionActive);
+    w.applyBatch(operations);
+    ASSERT_FALSE(printSnapshot(*(w.snapshot())) == before);
+    w.rollback();
+    ASSERT_TRUE(w.getJournalStats().records == 0);
+    ASSERT_FALSE(w.inTransaction());
+    ASSERT_EXCEPTION(w.rollback(), WorldNoTransaction);
+    ASSERT_EXCEPTION(w.commit(), WorldNoTransaction);
+    ASSERT_TRUE(printSnapshot(*(w.snapshot())) == before);
+    ASSERT_EXCEPTION(w.canReach("area0", "new area"), WorldAreaNotFound);
+    //the indexes were put back too, so the world goes on like one that
+    //never had the transaction.
+    w.beginTransaction();
+    std::vector<WorldResult> results = w.applyBatch(operations);
+    w.commit();
+    ASSERT_TRUE(w.getJournalStats().records ==
+                std::count(results.begin(), results.end(), WORLD_SUCCESS));
+    once.applyBatch(operations);
+    ASSERT_TRUE(printSnapshot(*(w.snapshot())) ==
+                printSnapshot(*(once.snapshot())));
+    ASSERT_TRUE(w.canReach("area0", "area1") ==
+                once.canReach("area0", "area1"));
+    std::remove(journal.c_str());
+    return true ;
+}
+
+bool testWorldTryApi() {
+    World w ;
+    w.addClan("Beta");
+    w.addArea("Gondor", MOUNTAIN);
+    w.addArea("Mordor", PLAIN);
+    w.addGroup("Gamma", "Beta", 10, 10, "Gondor");
+    ASSERT_TRUE(w.tryAddClan("Alpha") == WORLD_SUCCESS);
+    ASSERT_TRUE(w.tryAddClan("Alpha") == WORLD_CLAN_NAME_IS_TAKEN);
+    ASSERT_TRUE(w.tryAddClan("") == WORLD_INVALID_ARGUMENT);
+    ASSERT_TRUE(w.tryAddArea("Gondor", RIVER) == WORLD_AREA_NAME_IS_TAKEN);
+    ASSERT_TRUE(w.tryAddGroup("Gamma", "Alpha", 1, 1, "Mordor") ==
+                WORLD_GROUP_NAME_IS_TAKEN);
+    ASSERT_TRUE(w.tryAddGroup("Delta", "Omega", 1, 1, "Mordor") ==
+                WORLD_CLAN_NOT_FOUND);
+    ASSERT_TRUE(w.tryAddGroup("Delta", "Alpha", 1, 1, "Shire") ==
+                WORLD_AREA_NOT_FOUND);
+    ASSERT_TRUE(w.tryAddGroup("Delta", "Alpha", 1, 1, "Mordor") ==
+                WORLD_SUCCESS);
+    ASSERT_TRUE(w.tryMoveGroup("Omega", "Mordor") == WORLD_GROUP_NOT_FOUND);
+    ASSERT_TRUE(w.tryMoveGroup("Gamma", "Gondor") ==
+                WORLD_GROUP_ALREADY_IN_AREA);
+    ASSERT_TRUE(w.tryMoveGroup("Gamma", "Mordor") ==
+                WORLD_AREA_NOT_REACHABLE);
+    ASSERT_TRUE(w.tryMoveGroupVia("Gamma", "Mordor") ==
+                WORLD_AREA_NOT_REACHABLE);
+    ASSERT_TRUE(w.tryMakeReachable("Shire", "Mordor") ==
+                WORLD_AREA_NOT_FOUND);
+    bool reachable = true;
+    ASSERT_TRUE(w.tryCanReach("Gondor", "Mordor", reachable) ==
+                WORLD_SUCCESS);
+    ASSERT_FALSE(reachable);
+    ASSERT_TRUE(w.tryMakeFriends("Alpha", "Omega") == WORLD_CLAN_NOT_FOUND);
+    ASSERT_TRUE(w.tryUniteClans("Alpha", "Alpha", "Beta") ==
+                WORLD_CLAN_NAME_IS_TAKEN);
+    //a failed call leaves the stream and the out parameters as they were.
+    std::ostringstream os;
+    int changes = -1;
+    ASSERT_TRUE(w.tryPrintGroup(os, "Omega") == WORLD_GROUP_NOT_FOUND);
+    ASSERT_TRUE(w.tryPrintClan(os, "Omega") == WORLD_CLAN_NOT_FOUND);
+    ASSERT_TRUE(w.tryGetRulerChanges("Shire", changes) ==
+                WORLD_AREA_NOT_FOUND);
+    ASSERT_TRUE(w.tryCanReach("Shire", "Mordor", reachable) ==
+                WORLD_AREA_NOT_FOUND);
+    ASSERT_TRUE(os.str().empty() && changes == -1 && !reachable);
+    std::ostringstream printed;
+    ASSERT_TRUE(w.tryPrintGroup(os, "Gamma") == WORLD_SUCCESS);
+    w.printGroup(printed, "Gamma");
+    ASSERT_TRUE(os.str() == printed.str());
+    ASSERT_TRUE(w.tryGetRulerChanges("Gondor", changes) == WORLD_SUCCESS);
+    ASSERT_TRUE(changes == w.getRulerChanges("Gondor"));
+    long long id = -1;
+    std::vector<EventResult> results;
+    ASSERT_TRUE(w.trySchedule(5, WorldOperation::makeReachable("Gondor",
+                                                               "Mordor"),
+                              id) == WORLD_SUCCESS);
+    ASSERT_TRUE(w.tryAdvanceTo(10, results) == WORLD_SUCCESS);
+    ASSERT_TRUE(results.size() == 1 && results[0].id == id &&
+                results[0].result == WORLD_SUCCESS);
+    ASSERT_TRUE(w.tryAdvanceTo(9, results) == WORLD_INVALID_ARGUMENT);
+    ASSERT_TRUE(results.size() == 1);
+    ASSERT_TRUE(w.tryMoveGroup("Gamma", "Mordor") == WORLD_SUCCESS);
+    w.beginTransaction();
+    ASSERT_TRUE(w.trySchedule(20, WorldOperation::addClan("Zeta"), id) ==
+                WORLD_TRANSACTION_ACTIVE);
+    ASSERT_TRUE(w.tryAdvanceTo(20, results) == WORLD_TRANSACTION_ACTIVE);
+    w.rollback();
+    //the throwing API still throws the matching exceptions.
+    ASSERT_EXCEPTION(w.addClan("Alpha"), WorldClanNameIsTaken);
+    ASSERT_EXCEPTION(w.moveGroup("Omega", "Gondor"), WorldGroupNotFound);
+    ASSERT_EXCEPTION(w.moveGroup("Gamma", "Mordor"), WorldGroupAlreadyInArea);
+    ASSERT_EXCEPTION(w.moveGroup("Delta", "Gondor"), WorldAreaNotReachable);
+    ASSERT_EXCEPTION(w.printClan(os, "Omega"), WorldClanNotFound);
+    ASSERT_EXCEPTION(w.getRulerChanges("Shire"), WorldAreaNotFound);
+    ASSERT_EXCEPTION(w.advanceTo(9), WorldInvalidArgument);
+    return true ;
+}
+
+/**
+ * Checks the top groups of a world against its clan prints, that sort the
+ * groups of every clan: every clan ranks the groups it prints in the same
+ * order, and the world ranks all of them, strongest first.
+ */
+static bool checkTopGroups(World& w, int clans) {
+    std::vector<const Group*> top = w.topGroups(1 << 30);
+    std::set<string> names;
+    for (unsigned int i = 0; i < top.size(); ++i) {
+        names.insert((*(top[i])).getName());
+        ASSERT_TRUE((i == 0) || (*(top[i - 1]) > *(top[i])));
+    }
+    ASSERT_TRUE(names.size() == top.size());
+    ASSERT_TRUE((int)top.size() == (*(w.snapshot())).getStats().groups);
+    unsigned int ranked = 0;
+    //the workload unites clans into "united<i>".
+    for (int i = 0; i < 2 * clans; ++i) {
+        const string clan = i < clans ? WorkloadGenerator::clanName(i) :
+                            "united" + std::to_string(i - clans);
+        std::vector<const Group*> clan_top;
+        if (w.tryTopGroupsOfClan(clan, 1 << 30, clan_top) != WORLD_SUCCESS) {
+            continue ;
+        }
+        std::ostringstream expected;
+        std::ostringstream ranked_names;
+        w.printClan(expected, clan);
+        ranked_names << "Clan's name: " << clan << endl << "Clan's groups:"
+                     << endl;
+        for (unsigned int j = 0; j < clan_top.size(); ++j) {
+            ranked_names << (*(clan_top[j])).getName() << endl;
+            ASSERT_TRUE(names.count((*(clan_top[j])).getName()) == 1);
+        }
+        ASSERT_TRUE(ranked_names.str() == expected.str());
+        ranked += clan_top.size();
+    }
+    ASSERT_TRUE(ranked == top.size());
+    return true ;
+}
+
+bool testWorldTopGroups() {
+    World w ;
+    ASSERT_TRUE(w.topGroups(3).empty());
+    w.addClan("Beta");
+    w.addArea("Gondor", RIVER);
+    w.addGroup("Gamma", "Beta", 10, 10, "Gondor");
+    w.addGroup("Delta", "Beta", 20, 20, "Gondor");
+    std::vector<const Group*> top = w.topGroups(1);
+    ASSERT_TRUE(top.size() == 1 && (*(top[0])).getName() == "Delta");
+    ASSERT_TRUE(w.topGroupsOfClan("Beta", 5).size() == 2);
+    ASSERT_TRUE(w.topGroupsOfClan("Beta", 0).empty());
+    ASSERT_EXCEPTION(w.topGroups(-1), WorldInvalidArgument);
+    ASSERT_EXCEPTION(w.topGroupsOfClan("Beta", -1), WorldInvalidArgument);
+    ASSERT_EXCEPTION(w.topGroupsOfClan("Omega", 1), WorldClanNotFound);
+    ASSERT_TRUE(w.tryTopGroupsOfClan("Omega", 1, top) ==
+                WORLD_CLAN_NOT_FOUND);
+    ASSERT_TRUE(top.size() == 1);
+    //the power of a big group does not fit in an int.
+    w.addArea("Erebor", MOUNTAIN);
+    w.addGroup("Durin", "Beta", 0, 100000, "Erebor");
+    top = w.topGroups(1);
+    ASSERT_TRUE(top.size() == 1 && (*(top[0])).getName() == "Durin");
+    ASSERT_TRUE((*(top[0])).getPower() > 2147483647LL);
+    ASSERT_TRUE(w.areaStats("Erebor").power == (*(top[0])).getPower());
+    //a workload with fights, trades, unites, divides and clan unites, the
+    //rankings follow every change.
+    World big ;
+    WorkloadGenerator generator(3000, 23);
+    Command command;
+    while (generator.next(command)) {
+        if (command.isOperation()) {
+            big.apply(command.toOperation());
+        }
+    }
+    ASSERT_TRUE(checkTopGroups(big, 12));
+    std::vector<WorldOperation> moves;
+    for (int i = 0; i < 3000; ++i) {
+        moves.push_back(generator.nextMove());
+    }
+    big.applyBatchConcurrently(moves, 4);
+    ASSERT_TRUE(checkTopGroups(big, 12));
+    big.uniteClans("clan2", "clan3", "clan2");
+    ASSERT_TRUE(checkTopGroups(big, 12));
+    std::vector<const Group*> before = big.topGroups(1 << 30);
+    std::vector<string> before_names;
+    for (unsigned int i = 0; i < before.size(); ++i) {
+        before_names.push_back((*(before[i])).getName());
+    }
+    big.beginTransaction();
+    big.uniteClans("clan4", "clan5", "united5");
+    big.applyBatch(moves);
+    big.rollback();
+    ASSERT_TRUE(checkTopGroups(big, 12));
+    std::vector<const Group*> after = big.topGroups(1 << 30);
+    ASSERT_TRUE(after.size() == before_names.size());
+    for (unsigned int i = 0; i < after.size(); ++i) {
+        ASSERT_TRUE((*(after[i])).getName() == before_names[i]);
+    }
+    std::unique_ptr<World> fork = big.fork();
+    ASSERT_TRUE(checkTopGroups(*fork, 12));
+    //the strongest group of the united clan comes from the second clan,
+    //united into the name of either clan.
+    World unite2 ;
+    unite2.addClan("A");
+    unite2.addClan("B");
+    unite2.addArea("P", RIVER);
+    unite2.addGroup("weak", "A", 1, 1, "P");
+    unite2.addGroup("strong", "B", 10, 10, "P");
+    unite2.uniteClans("A", "B", "B");
+    top = unite2.topGroups(5);
+    ASSERT_TRUE(top.size() == 2 && (*(top[0])).getName() == "strong" &&
+                (*(top[1])).getName() == "weak");
+    ASSERT_TRUE(unite2.topGroupsOfClan("B", 5).size() == 2);
+    ASSERT_EXCEPTION(unite2.topGroupsOfClan("A", 5), WorldClanNotFound);
+    World unite1 ;
+    unite1.addClan("A");
+    unite1.addClan("B");
+    unite1.addArea("P", RIVER);
+    unite1.addGroup("weak", "A", 1, 1, "P");
+    unite1.addGroup("strong", "B", 10, 10, "P");
+    unite1.uniteClans("A", "B", "A");
+    top = unite1.topGroups(5);
+    ASSERT_TRUE(top.size() == 2 && (*(top[0])).getName() == "strong" &&
+                (*(top[1])).getName() == "weak");
+    ASSERT_TRUE(unite1.topGroupsOfClan("A", 5).size() == 2);
+    ASSERT_EXCEPTION(unite1.topGroupsOfClan("B", 5), WorldClanNotFound);
+    return true ;
+}
+
+/**
+ * Checks the stats of every area of a world against its groups, by the area
+ * every group prints, and against a fork of the world, that counts its
+ * stats from scratch when it is loaded.
+ */
+static bool checkAreaStats(World& w, int areas) {
+    std::vector<const Group*> groups = w.topGroups(1 << 30);
+    std::map<string, AreaStats> expected;
+    for (unsigned int i = 0; i < groups.size(); ++i) {
+        const Group& group = *(groups[i]);
+        std::ostringstream os;
+        w.printGroup(os, group.getName());
+        string printed = os.str();
+        printed.pop_back();
+        const string area = printed.substr(printed.rfind(": ") + 2);
+        AreaStats& stats = expected[area];
+        stats.population[group.getClan()] += group.getSize();
+        stats.power += group.getPower();
+        stats.groups++;
+    }
+    std::unique_ptr<World> fork = w.fork();
+    for (int i = 0; i < areas; ++i) {
+        const string area = WorkloadGenerator::areaName(i);
+        const AreaStats& stats = w.areaStats(area);
+        const AreaStats& loaded = (*fork).areaStats(area);
+        ASSERT_TRUE(stats.population == expected[area].population);
+        ASSERT_TRUE(stats.power == expected[area].power);
+        ASSERT_TRUE(stats.groups == expected[area].groups);
+        ASSERT_TRUE(loaded.population == stats.population);
+        ASSERT_TRUE(loaded.power == stats.power);
+        ASSERT_TRUE((loaded.ruler == nullptr) == (stats.ruler == nullptr));
+        ASSERT_TRUE((stats.ruler == nullptr) ||
+                    ((*(loaded.ruler)).getName() ==
+                     (*(stats.ruler)).getName()));
+        ASSERT_TRUE(loaded.fights == stats.fights);
+        ASSERT_TRUE(loaded.trades == stats.trades);
+    }
+    return true ;
+}
+
+bool testWorldAreaStats() {
+    World w ;
+    w.addClan("Arryn");
+    w.addClan("Baelish");
+    w.addArea("TheEyrie", MOUNTAIN);
+    w.addArea("Trident", RIVER);
+    w.makeReachable("TheEyrie", "Trident");
+    ASSERT_EXCEPTION(w.areaStats("Gulltown"), WorldAreaNotFound);
+    const AreaStats* stats = nullptr;
+    ASSERT_TRUE(w.tryAreaStats("Gulltown", stats) == WORLD_AREA_NOT_FOUND);
+    ASSERT_TRUE(stats == nullptr);
+    ASSERT_TRUE(w.areaStats("TheEyrie").groups == 0);
+    ASSERT_TRUE(w.areaStats("TheEyrie").ruler == nullptr);
+    w.addGroup("Jon", "Arryn", 0, 10, "TheEyrie");
+    w.addGroup("Robin", "Arryn", 0, 1, "TheEyrie");
+    const AreaStats& eyrie = w.areaStats("TheEyrie");
+    ASSERT_TRUE(eyrie.groups == 2 && eyrie.population.at("Arryn") == 11);
+    ASSERT_TRUE((*(eyrie.ruler)).getName() == "Jon");
+    ASSERT_TRUE(eyrie.fights == 0 && eyrie.trades == 0);
+    w.addGroup("Petyr", "Baelish", 0, 5, "TheEyrie"); //loses to Jon
+    ASSERT_TRUE(w.areaStats("TheEyrie").fights == 1);
+    ASSERT_TRUE((*(w.areaStats("TheEyrie").ruler)).getName() == "Jon");
+    w.moveGroup("Jon", "Trident");
+    w.moveGroup("Robin", "Trident");
+    ASSERT_TRUE(w.areaStats("TheEyrie").population.count("Arryn") == 0);
+    ASSERT_TRUE((*(w.areaStats("TheEyrie").ruler)).getName() == "Petyr");
+    ASSERT_TRUE(w.areaStats("Trident").groups == 2);
+    w.addGroup("Lysa", "Arryn", 10, 0, "Trident"); //more food, trades
+    ASSERT_TRUE(w.areaStats("Trident").trades == 1);
+    //a workload with fights, trades, unites, divides and clan unites.
+    World big ;
+    WorkloadGenerator generator(3000, 29);
+    Command command;
+    while (generator.next(command)) {
+        if (command.isOperation()) {
+            big.apply(command.toOperation());
+        }
+    }
+    ASSERT_TRUE(checkAreaStats(big, 30));
+    std::vector<WorldOperation> moves;
+    for (int i = 0; i < 3000; ++i) {
+        moves.push_back(generator.nextMove());
+    }
+    big.applyBatchConcurrently(moves, 4);
+    ASSERT_TRUE(checkAreaStats(big, 30));
+    int fights = 0;
+    int trades = 0;
+    for (int i = 0; i < 30; ++i) {
+        fights += big.areaStats(WorkloadGenerator::areaName(i)).fights;
+        trades += big.areaStats(WorkloadGenerator::areaName(i)).trades;
+    }
+    ASSERT_TRUE(fights > 0 && trades > 0);
+    big.uniteClans("clan2", "clan3", "clan2");
+    ASSERT_TRUE(checkAreaStats(big, 30));
+    big.beginTransaction();
+    big.uniteClans("clan4", "clan5", "united5");
+    big.applyBatch(moves);
+    big.rollback();
+    ASSERT_TRUE(checkAreaStats(big, 30));
+    int fights_after = 0;
+    for (int i = 0; i < 30; ++i) {
+        fights_after += big.areaStats(WorkloadGenerator::areaName(i)).fights;
+    }
+    ASSERT_TRUE(fights_after == fights);
+    return true ;
+}
+
+bool testWorldMetrics() {
+    std::ostringstream os;
+    World::dumpMetrics(os);
+#ifndef MTM_NO_METRICS
+    long long lost = Metrics::get(METRIC_FIGHTS_LOST);
+    long long arrivals = Metrics::get(METRIC_MOUNTAIN_ARRIVALS);
+    long long rulers = Metrics::get(METRIC_RULER_CHANGES);
+    long long add_clans = Metrics::get(METRIC_CALL_ADD_CLAN);
+    long long taken = Metrics::get(METRIC_THROWN_CLAN_NAME_IS_TAKEN);
+    long long allocations = Metrics::get(METRIC_SET_NODE_ALLOCATIONS);
+    World w ;
+    w.addClan("Arryn");
+    w.addClan("Baelish");
+    w.addArea("TheEyrie", MOUNTAIN);
+    w.addArea("TheVale", PLAIN);
+    w.makeReachable("TheEyrie", "TheVale");
+    w.addGroup("Jon", "Arryn", 0, 10, "TheEyrie");
+    w.addGroup("Petyr", "Baelish", 0, 5, "TheEyrie"); //loses to Jon
+    ASSERT_EXCEPTION(w.addClan("Arryn"), WorldClanNameIsTaken);
+    ASSERT_TRUE(w.tryAddClan("Arryn") == WORLD_CLAN_NAME_IS_TAKEN);
+    //the counters of a thread that ended are kept.
+    std::thread other([]() {
+        World world ;
+        world.addClan("Tully");
+    });
+    other.join();
+    ASSERT_TRUE(Metrics::get(METRIC_FIGHTS_LOST) == lost + 1);
+    ASSERT_TRUE(Metrics::get(METRIC_MOUNTAIN_ARRIVALS) == arrivals + 2);
+    ASSERT_TRUE(Metrics::get(METRIC_RULER_CHANGES) == rulers + 1);
+    ASSERT_TRUE(Metrics::get(METRIC_CALL_ADD_CLAN) == add_clans + 5);
+    ASSERT_TRUE(Metrics::get(METRIC_THROWN_CLAN_NAME_IS_TAKEN) == taken + 1);
+    ASSERT_TRUE(Metrics::get(METRIC_SET_NODE_ALLOCATIONS) > allocations);
+    os.str("");
+    World::dumpMetrics(os);
+    const string dump = os.str();
+    std::ostringstream line;
+    line << "mtm_fights_total{result=\"lost\"} "
+         << Metrics::get(METRIC_FIGHTS_LOST) << "\n";
+    ASSERT_TRUE(dump.find(line.str()) != string::npos);
+    ASSERT_TRUE(dump.find("# TYPE mtm_fights_total counter\n") ==
+                dump.rfind("# TYPE mtm_fights_total counter\n"));
+    ASSERT_TRUE(dump.find("mtm_world_exceptions_total"
+                          "{type=\"WorldClanNameIsTaken\"} ") !=
+                string::npos);
+#endif
+    return true ;
+}
+
+bool testWorldLatencyAndTrace() {
+    //every latency is in the bucket whose limit is the first one above it.
+    long long latencies[] = { 0, 1, 7, 8, 9, 15, 16, 17, 1000, 1535, 1536,
+                              123456789, 1LL << 40 };
+    for (unsigned int i = 0; i < sizeof(latencies) / sizeof(long long); i++) {
+        int bucket = Metrics::latencyBucket(latencies[i]);
+        ASSERT_TRUE(Metrics::bucketLimit(bucket) >= latencies[i]);
+        ASSERT_TRUE((bucket == 0) ||
+                    (Metrics::bucketLimit(bucket - 1) < latencies[i]));
+        ASSERT_TRUE(Metrics::bucketLimit(bucket) <=
+                    latencies[i] + latencies[i] / 8);
+    }
+    World w ;
+    w.addClan("TheNorth");
+    w.addClan("TheVale");
+    w.addArea("TheEyrie", MOUNTAIN);
+    w.addArea("Trident", RIVER);
+    w.makeReachable("TheEyrie", "Trident");
+    w.makeFriends("TheNorth", "TheVale");
+    World::startTrace();
+    w.addGroup("Arryn", "TheVale", 0, 2, "TheEyrie");
+    w.addGroup("Stark", "TheNorth", 10, 0, "TheEyrie"); //fights Arryn
+    std::thread other([&w]() {
+        w.moveGroup("Arryn", "Trident");
+    });
+    other.join();
+    w.addGroup("Royce", "TheVale", 0, 2, "Trident"); //more tools
+    w.addGroup("Tully", "TheNorth", 10, 0, "Trident"); //more food, trades
+    std::ostringstream os;
+    w.printClan(os, "TheNorth");
+    os.str("");
+    World::stopTrace(os);
+    const string trace = os.str();
+#ifndef MTM_NO_METRICS
+    ASSERT_TRUE(trace.find("{\"traceEvents\":[") == 0);
+    const char* spans[] = { "Mountain::groupArrive", "River::groupArrive",
+                            "Group::fight", "Group::trade",
+                            "Clan::sortGroups" };
+    for (int i = 0; i < 5; i++) {
+        ASSERT_TRUE(trace.find("{\"name\":\"" + string(spans[i]) +
+                               "\",\"cat\":\"world\",\"ph\":\"X\"") !=
+                    string::npos);
+    }
+    //the move ran on another thread.
+    ASSERT_TRUE(trace.find("\"tid\":", trace.find("River::groupArrive")) !=
+                trace.find("\"tid\":", trace.find("Group::fight")));
+    //when tracing is off, nothing is kept.
+    w.addGroup("Frey", "TheNorth", 10, 0, "Trident");
+    World::startTrace();
+    os.str("");
+    World::stopTrace(os);
+    ASSERT_TRUE(os.str().find("\"name\"") == string::npos);
+    long long median = Metrics::percentile(METRIC_CALL_ADD_GROUP, 0.5);
+    long long tail = Metrics::percentile(METRIC_CALL_ADD_GROUP, 0.99);
+    ASSERT_TRUE((median > 0) && (median <= tail));
+    ASSERT_TRUE(Metrics::percentile(METRIC_RIVER_ARRIVALS, 1) > 0);
+    os.str("");
+    World::dumpMetrics(os);
+    std::ostringstream count;
+    count << "mtm_world_call_seconds_count{call=\"addGroup\"} "
+          << Metrics::get(METRIC_CALL_ADD_GROUP) << "\n";
+    ASSERT_TRUE(os.str().find(count.str()) != string::npos);
+    ASSERT_TRUE(os.str().find("# TYPE mtm_area_arrival_seconds histogram") !=
+                string::npos);
+    ASSERT_TRUE(os.str().find("mtm_area_arrival_seconds_bucket"
+                              "{area=\"river\",le=\"+Inf\"} ") !=
+                string::npos);
+#endif
+    return true ;
+}
+
+/**
+ * Check that a memory report adds up: its total is the world and all the
+ * clans and areas.
+ */
+static bool checkMemoryAddsUp(const MemoryReport& report) {
+    MemoryUsage sum = report.world;
+    for (std::map<string, MemoryUsage>::const_iterator it =
+            report.clans.begin(); it != report.clans.end(); ++it) {
+        sum += it->second;
+    }
+    for (std::map<string, MemoryUsage>::const_iterator it =
+            report.areas.begin(); it != report.areas.end(); ++it) {
+        sum += it->second;
+    }
+    ASSERT_TRUE(sum.total() == report.total.total());
+    ASSERT_TRUE(sum.groups == report.total.groups);
+    ASSERT_TRUE(sum.strings == report.total.strings);
+    return true;
+}
+
+bool testWorldMemoryReport() {
+    World w ;
+    w.addClan("TheNorth");
+    w.addClan("TheVale");
+    w.addArea("Winterfell", PLAIN);
+    w.addArea("TheEyrie", MOUNTAIN);
+    MemoryReport before = w.memoryReport();
+    ASSERT_TRUE((before.clans.size() == 2) && (before.areas.size() == 2));
+    ASSERT_TRUE(before.clans["TheNorth"].groups == 0);
+    ASSERT_TRUE(before.areas["TheEyrie"].set_nodes == 0);
+    ASSERT_TRUE(checkMemoryAddsUp(before));
+    w.addGroup("Stark", "TheNorth", 3, 3, "Winterfell");
+    w.addArea("TheNeck", PLAIN);
+    w.addGroup("Karstark", "TheNorth", 2, 2, "TheNeck");
+    w.addGroup("Arryn", "TheVale", 2, 2, "TheEyrie");
+    w.makeReachable("Winterfell", "TheEyrie");
+    MemoryReport report = w.memoryReport();
+    ASSERT_TRUE(checkMemoryAddsUp(report));
+    const MemoryUsage& north = report.clans["TheNorth"];
+    const MemoryUsage& vale = report.clans["TheVale"];
+    ASSERT_TRUE(north.groups == 2 * static_cast<long long>(sizeof(Group)));
+    ASSERT_TRUE(north.control_blocks == 2 * vale.control_blocks);
+    ASSERT_TRUE(report.areas["Winterfell"].groups == 0);
+    ASSERT_TRUE(report.areas["Winterfell"].vectors >=
+                static_cast<long long>(sizeof(Plain) + sizeof(GroupPointer)));
+    ASSERT_TRUE(report.areas["Winterfell"].set_nodes > 0);
+    ASSERT_TRUE(report.areas["TheEyrie"].set_nodes == 0);
+    //a name too long to fit in its strings is counted by every copy of it.
+    const string name = "TheKnightOfTheFlowersFromHighgarden";
+    w.addGroup(name, "TheVale", 2, 2, "TheEyrie");
+    MemoryReport longer = w.memoryReport();
+    ASSERT_TRUE(longer.clans["TheVale"].strings >=
+                vale.strings + 2 * static_cast<long long>(name.size() + 1));
+    ASSERT_TRUE(longer.areas["TheEyrie"].strings >=
+                report.areas["TheEyrie"].strings +
+                static_cast<long long>(name.size() + 1));
+    ASSERT_TRUE(longer.world.strings >= report.world.strings +
+                static_cast<long long>(name.size() + 1));
+    //the groups of united clans are counted in the united clan.
+    w.makeFriends("TheNorth", "TheVale");
+    w.uniteClans("TheNorth", "TheVale", "TheKingdom");
+    MemoryReport united = w.memoryReport();
+    ASSERT_TRUE(checkMemoryAddsUp(united));
+    ASSERT_TRUE((united.clans.size() == 1) &&
+                (united.clans.count("TheKingdom") == 1));
+    ASSERT_TRUE(united.clans["TheKingdom"].groups ==
+                4 * static_cast<long long>(sizeof(Group)));
+    std::ostringstream os;
+    os << united;
+    std::ostringstream total;
+    total << "total: " << united.total.total() << " bytes (groups "
+          << united.total.groups << ", ";
+    ASSERT_TRUE(os.str().find(total.str()) == 0);
+    ASSERT_TRUE(os.str().find("\nclan TheKingdom: ") != string::npos);
+    ASSERT_TRUE(os.str().find("\narea Winterfell: ") != string::npos);
+    return true ;
+}
+
+bool testWorldExportState() {
+    World w ;
+    w.addClan("TheNorth");
+    w.addClan("TheVale");
+    w.addArea("Winterfell", PLAIN);
+    w.addArea("TheEyrie", MOUNTAIN);
+    w.makeFriends("TheNorth", "TheVale");
+    w.addGroup("Stark", "TheNorth", 3, 3, "Winterfell");
+    w.addGroup("Arryn", "TheVale", 2, 2, "TheEyrie");
+    w.addGroup("Royce, \"Bronze\"", "TheVale", 1, 2, "TheEyrie");
+    std::ostringstream csv;
+    w.exportState(csv, EXPORT_CSV);
+    ASSERT_TRUE(csv.str() ==
+                "clan,groups,population\n"
+                "TheNorth,1,6\n"
+                "TheVale,2,7\n"
+                "\n"
+                "clan,friend\n"
+                "TheNorth,TheVale\n"
+                "TheVale,TheNorth\n"
+                "\n"
+                "area,type,groups,power,ruler,fights,trades\n"
+                "TheEyrie,mountain,2,3359,Arryn,0,0\n"
+                "Winterfell,plain,1,4054,,0,0\n"
+                "\n"
+                "group,clan,area,children,adults,tools,food,morale\n"
+                "Arryn,TheVale,TheEyrie,2,2,8,10,77\n"
+                "\"Royce, \"\"Bronze\"\"\",TheVale,TheEyrie,1,2,8,8,77\n"
+                "Stark,TheNorth,Winterfell,3,3,12,15,77\n"
+                "\n");
+    std::ostringstream json;
+    w.exportState(json, EXPORT_JSON);
+    ASSERT_TRUE(json.str() ==
+                "{\"clans\":[\n"
+                "{\"name\":\"TheNorth\",\"groups\":1,\"population\":6,"
+                "\"friends\":[\"TheVale\"]},\n"
+                "{\"name\":\"TheVale\",\"groups\":2,\"population\":7,"
+                "\"friends\":[\"TheNorth\"]}\n"
+                "],\n"
+                "\"areas\":[\n"
+                "{\"name\":\"TheEyrie\",\"type\":\"mountain\",\"groups\":2,"
+                "\"power\":3359,\"ruler\":\"Arryn\",\"fights\":0,"
+                "\"trades\":0},\n"
+                "{\"name\":\"Winterfell\",\"type\":\"plain\",\"groups\":1,"
+                "\"power\":4054,\"ruler\":null,\"fights\":0,\"trades\":0}\n"
+                "],\n"
+                "\"groups\":[\n"
+                "{\"name\":\"Arryn\",\"clan\":\"TheVale\","
+                "\"area\":\"TheEyrie\",\"children\":2,\"adults\":2,"
+                "\"tools\":8,\"food\":10,\"morale\":77},\n"
+                "{\"name\":\"Royce, \\\"Bronze\\\"\",\"clan\":\"TheVale\","
+                "\"area\":\"TheEyrie\",\"children\":1,\"adults\":2,"
+                "\"tools\":8,\"food\":8,\"morale\":77},\n"
+                "{\"name\":\"Stark\",\"clan\":\"TheNorth\","
+                "\"area\":\"Winterfell\",\"children\":3,\"adults\":3,"
+                "\"tools\":12,\"food\":15,\"morale\":77}\n"
+                "]}\n");
+    //a world bigger than the buffer is written whole.
+    World big ;
+    big.addClan("TheNorth");
+    big.addArea("TheWall", MOUNTAIN);
+    for (int i = 0; i < 5000; i++) {
+        big.addGroup("Stark" + std::to_string(i), "TheNorth", 0, 1,
+                     "TheWall");
+    }
+    csv.str("");
+    big.exportState(csv, EXPORT_CSV);
+    const string exported = csv.str();
+    ASSERT_TRUE(exported.size() > OutputBuffer::SIZE);
+    ASSERT_TRUE(std::count(exported.begin(), exported.end(), '\n') ==
+                5000 + 10);
+    ASSERT_TRUE(exported.find("Stark4999,TheNorth,TheWall,0,1,") !=
+                string::npos);
+    return true ;
+}
+
+/**
+ * Prints a group and a clan the way their operator<< did before it wrote
+ * through a buffer: an insertion and an endl for every line, and the clan
+ * sorting a list of copies of its groups.
+ */
+static string printedBefore(const Group& group) {
+    std::ostringstream os;
+    os << "Group's name: " << group.getName() << endl <<
+          "Group's clan: " << group.getClan() << endl <<
+          "Group's children: " << group.getChildren() << endl <<
+          "Group's adults: " << group.getAdults() << endl <<
+          "Group's tools: " << group.getTools() << endl <<
+          "Group's food: " << group.getFood() << endl <<
+          "Group's morale: " << group.getMorale() << endl;
+    return os.str();
+}
+
+static string printedBefore(const string& clan,
+                            const std::vector<const Group*>& groups) {
+    std::ostringstream os;
+    os << "Clan's name: " << clan << endl << "Clan's groups:" << endl;
+    std::list<Group> copies;
+    for (unsigned int i = 0; i < groups.size(); ++i) {
+        copies.push_back(*(groups[i]));
+    }
+    copies.sort();
+    for (std::list<Group>::reverse_iterator it = copies.rbegin();
+         it != copies.rend(); ++it) {
+        os << (*it).getName() << endl;
+    }
+    return os.str();
+}
+
+bool testWorldPrintFormatting() {
+    World w ;
+    WorkloadGenerator generator(1000, 3);
+    Command command;
+    while (generator.next(command)) {
+        if (command.isOperation()) {
+            w.apply(command.toOperation());
+        }
+    }
+    w.addClan("TheNorth");
+    w.addArea("Winterfell", PLAIN);
+    w.addGroup("Stark", "TheNorth", 0, 1, "Winterfell");
+    //numbers of every length.
+    Group wide("Tarly", "TheReach", 1234567, 89, 0, 2147483647, 100);
+    std::ostringstream wide_printed;
+    wide_printed << wide;
+    ASSERT_TRUE(wide_printed.str() == printedBefore(wide));
+    std::vector<const Group*> groups = w.topGroups(1 << 30);
+    for (unsigned int i = 0; i < groups.size(); ++i) {
+        const Group& group = *(groups[i]);
+        std::ostringstream printed;
+        printed << group;
+        ASSERT_TRUE(printed.str() == printedBefore(group));
+        std::ostringstream world_printed;
+        w.printGroup(world_printed, group.getName());
+        ASSERT_TRUE(world_printed.str().compare(0, printed.str().size(),
+                                                printed.str()) == 0);
+    }
+    std::ostringstream world_printed;
+    w.printGroup(world_printed, "Stark");
+    ASSERT_TRUE(world_printed.str() ==
+                printedBefore(*(w.topGroupsOfClan("TheNorth", 1)[0])) +
+                "Group's current area: Winterfell\n");
+    //the clans of the workload print longer than a buffer on the stack.
+    int clans = 0;
+    for (int i = 0; i < 8; ++i) {
+        const string clan = i < 4 ? WorkloadGenerator::clanName(i) :
+                            "united" + std::to_string(i - 4);
+        std::vector<const Group*> clan_groups;
+        if (w.tryTopGroupsOfClan(clan, 1 << 30, clan_groups) !=
+                WORLD_SUCCESS) {
+            continue ;
+        }
+        clans++;
+        std::ostringstream printed;
+        w.printClan(printed, clan);
+        ASSERT_TRUE(printed.str().size() > OutputBuffer::STACK_SIZE);
+        ASSERT_TRUE(printed.str() == printedBefore(clan, clan_groups));
+    }
+    ASSERT_TRUE(clans >= 2);
+    return true ;
+}
+
 int main() {
     RUN_TEST(testWorldConstractor);
     RUN_TEST(testWorldAddClan);
@@ -304,7 +1814,32 @@ int main() {
     RUN_TEST(testWorldMoveGroup);
     RUN_TEST(testWorldMakeFriends);
     RUN_TEST(testWorldUniteClans);
+    RUN_TEST(testWorldUniteClansMovesGroups);
     RUN_TEST(testWorldPrintGroup);
     RUN_TEST(testWorldPrintClan);
+    RUN_TEST(testWorldAreaLeaveArrive);
+    RUN_TEST(testWorldMountainRulerChanges);
+    RUN_TEST(testWorldRiverTradePartner);
+    RUN_TEST(testWorldSplitNameReuse);
+    RUN_TEST(testWorldApplyBatch);
+    RUN_TEST(testCommandLogRoundTrip);
+    RUN_TEST(testWorldMoveGroupVia);
+    RUN_TEST(testWorldScheduler);
+    RUN_TEST(testWorldApplyBatchConcurrently);
+    RUN_TEST(testConcurrentWorldReaders);
+    RUN_TEST(testWorldSnapshot);
+    RUN_TEST(testWorldCheckpoint);
+    RUN_TEST(testWorldJournalRecover);
+    RUN_TEST(testWorldJournalFailedSync);
+    RUN_TEST(testWorldFork);
+    RUN_TEST(testWorldTransaction);
+    RUN_TEST(testWorldTryApi);
+    RUN_TEST(testWorldTopGroups);
+    RUN_TEST(testWorldAreaStats);
+    RUN_TEST(testWorldMetrics);
+    RUN_TEST(testWorldLatencyAndTrace);
+    RUN_TEST(testWorldMemoryReport);
+    RUN_TEST(testWorldExportState);
+    RUN_TEST(testWorldPrintFormatting);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,1132 @@
+#include "World.h"
+#include "ConcurrentWorld.h"
+#include "CommandLog.h"
+#include "WorkloadGenerator.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <atomic>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <sys/resource.h>
+
+using namespace mtm ;
+using std::string ;
+using std::cout ;
+using std::cerr ;
+using std::endl ;
+/**
+ * world_replay - replays a command log into a World, and reports how fast
+ * it was.
+ *
+ *  world_replay [--echo] [<journal options>] [<observing options>] <log>
+ *      Replay a text or a binary log ("-" reads the log from the standard
+ *      input). With --echo the prints are written to the standard output.
+ *  world_replay --workload <1k|100k|1m|groups> [--seed <seed>] [--echo]
+ *      [<journal options>] [<observing options>]
+ *      Generate a workload and replay it, without writing it.
+ *  world_replay --generate <1k|100k|1m|groups> [--seed <seed>] [--binary]
+ *      <log>
+ *      Write a generated workload to a log ("-" writes to the standard
+ *      output).
+ *  world_replay --scaling <1k|100k|1m|groups> [--seed <seed>]
+ *      [--threads <N>] [--moves <moves>]
+ *      Build the world of a generated workload, then apply the same batch of
+ *      moves sequentially and concurrently with 1, 2, 4 .. N threads, and
+ *      report the speedup of every run.
+ *  world_replay --reads <1k|100k|1m|groups> [--seed <seed>] [--threads <N>]
+ *      [--moves <moves>]
+ *      Build the world of a generated workload in a ConcurrentWorld, and
+ *      measure how many prints and queries N reader threads make while
+ *      the main thread applies moves one by one, and without the moves.
+ *  world_replay --checkpoint <1k|100k|1m|groups> [--seed <seed>] <file>
+ *      Build the world of a generated workload, save it to a checkpoint
+ *      file and load it back, and report how long each of them took.
+ *  world_replay --scenarios <1k|100k|1m|groups> [--seed <seed>]
+ *      [--threads <N>] [--moves <moves>]
+ *      Build the world of a generated workload, time one fork of it, then
+ *      run N scenarios of different moves on forks of it, N at a time, and
+ *      report what every scenario did.
+ *  world_replay --rejected <1k|100k|1m|groups> [--seed <seed>]
+ *      [--moves <commands>]
+ *      Build the world of a generated workload, then make the same commands
+ *      that the world rejects (missing names, names that are taken) through
+ *      the throwing API and through the try API, and report how many of
+ *      them each API makes per second.
+ *  world_replay --top <1k|100k|1m|groups> [--seed <seed>]
+ *      [--moves <queries>]
+ *      Build the world of a generated workload, then apply a move before
+ *      every query, and report how long the 10 strongest groups of the
+ *      world and of a clan take to get, and how long printing the clan
+ *      takes.
+ *  world_replay --stats <1k|100k|1m|groups> [--seed <seed>]
+ *      [--moves <polls>]
+ *      Build the world of a generated workload, then apply a move before
+ *      every poll of the stats of all the areas, and report how long a poll
+ *      takes.
+ *  world_replay --memory <1k|100k|1m|groups> [--seed <seed>] [--echo]
+ *      Build the world of a generated workload, and report the memory it
+ *      takes (World::memoryReport) by what takes it, for the whole world
+ *      and for its biggest clan and area. With --echo every clan and area
+ *      is reported.
+ *  world_replay --export <1k|100k|1m|groups> [--seed <seed>] [--json]
+ *      <file>
+ *      Build the world of a generated workload, export its state to the
+ *      file as CSV, or as JSON with --json (World::exportState), and report
+ *      how fast it was written.
+ *
+ * Journal options: --journal <file> [--sync-every <N>] [--sync-millis <ms>]
+ *      Write every change of the replay to a journal, that is synced every
+ *      N changes (256 by default) or every ms milliseconds (10 by default).
+ * Observing options of a replay: [--metrics <file>] [--trace <file>]
+ *      Write the metrics of the replay (World::dumpMetrics), and a Chrome
+ *      trace of it (World::startTrace).
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * The latencies and failures of every command type in a replay.
+ */
+class ReplayStats{
+    std::vector<long long> latencies[COMMAND_TYPES];
+    int failures[COMMAND_TYPES];
+    int bad_commands;
+
+    static long long percentile(const std::vector<long long>& sorted,
+                                double fraction) {
+        int index = static_cast<int>(fraction * (sorted.size() - 1) + 0.5);
+        return sorted[index];
+    }
+
+public:
+    ReplayStats() : bad_commands(0) {
+        std::fill(failures, failures + COMMAND_TYPES, 0);
+    }
+
+    void record(CommandType type, long long nanoseconds, bool failed) {
+        latencies[type].push_back(nanoseconds);
+        if (failed) {
+            failures[type]++;
+        }
+    }
+
+    void recordBadCommand() {
+        bad_commands++;
+    }
+
+    void report(std::ostream& os, double seconds) {
+        long long total = 0;
+        for (int i = 0; i < COMMAND_TYPES; i++) {
+            total += latencies[i].size();
+        }
+        os << std::fixed << std::setprecision(3);
+        os << "commands:      " << total << endl;
+        os << "bad commands:  " << bad_commands << endl;
+        os << "seconds:       " << seconds << endl;
+        os << "ops/sec:       " << std::setprecision(0)
+           << (seconds > 0 ? total / seconds : 0) << endl;
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        os << "peak RSS (KB): " << usage.ru_maxrss << endl;
+        os << endl << std::left << std::setw(13) << "command"
+           << std::right << std::setw(10) << "count"
+           << std::setw(10) << "failed" << std::setw(10) << "p50 us"
+           << std::setw(10) << "p90 us" << std::setw(10) << "p99 us"
+           << std::setw(10) << "p99.9 us" << std::setw(10) << "max us"
+           << endl;
+        os << std::setprecision(2);
+        for (int i = 0; i < COMMAND_TYPES; i++) {
+            std::vector<long long>& sorted = latencies[i];
+            if (sorted.empty()) {
+                continue ;
+            }
+            std::sort(sorted.begin(), sorted.end());
+            os << std::left << std::setw(13)
+               << Command::typeName(static_cast<CommandType>(i))
+               << std::right << std::setw(10) << sorted.size()
+               << std::setw(10) << failures[i];
+            const double fractions[] = { 0.5, 0.9, 0.99, 0.999, 1 };
+            for (int j = 0; j < 5; j++) {
+                os << std::setw(10) << percentile(sorted, fractions[j]) / 1e3;
+            }
+            os << endl;
+        }
+    }
+};
+
+/**
+ * Applies the commands to a world one after the other, and measures every
+ * command.
+ */
+class Replayer{
+    World world;
+    ReplayStats stats;
+    std::ostringstream printed;
+    std::vector<EventResult> events;
+    bool echo;
+
+public:
+    explicit Replayer(bool echo) : world(), stats(), printed(), events(),
+                                   echo(echo) {}
+
+    void replay(const Command& command) {
+        WorldResult result;
+        Clock::time_point start = Clock::now();
+        if (command.type == ADVANCE) {
+            result = world.tryAdvanceTo(command.tick, events);
+        } else if (command.tick >= 0) {
+            long long id;
+            result = world.trySchedule(command.tick, command.toOperation(),
+                                       id);
+        } else if (command.isOperation()) {
+            result = world.apply(command.toOperation());
+        } else if (command.type == PRINT_GROUP) {
+            result = world.tryPrintGroup(printed, command.first);
+        } else {
+            result = world.tryPrintClan(printed, command.first);
+        }
+        bool failed = result != WORLD_SUCCESS;
+        Clock::time_point end = Clock::now();
+        stats.record(command.type,
+                     std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             end - start).count(), failed);
+        if (echo) {
+            cout << printed.str();
+        }
+        printed.str("");
+    }
+
+    ReplayStats& getStats() {
+        return stats;
+    }
+
+    World& getWorld() {
+        return world;
+    }
+};
+
+/**
+ * Where a replay writes its journal, and how often it syncs it. An empty
+ * path replays without a journal.
+ */
+struct JournalOptions{
+    string path;
+    int sync_every;
+    int sync_millis;
+};
+
+/**
+ * Open the journal of a replay, if it has one.
+ * @return false if the journal can't be opened.
+ */
+static bool openJournal(Replayer& replayer, const JournalOptions& journal) {
+    if (journal.path.empty()) {
+        return true;
+    }
+    try {
+        replayer.getWorld().openJournal(journal.path, journal.sync_every,
+                                        journal.sync_millis);
+    } catch (const JournalException& e) {
+        cerr << "cannot open the journal: " << e.what() << endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Sync the journal of a replay, and report how much was written to it.
+ */
+static void reportJournal(Replayer& replayer, const JournalOptions& journal,
+                          std::ostream& os) {
+    if (journal.path.empty()) {
+        return ;
+    }
+    replayer.getWorld().syncJournal();
+    JournalStats stats = replayer.getWorld().getJournalStats();
+    os << endl << "journal records: " << stats.records << endl
+       << "journal syncs:   " << stats.syncs << endl
+       << "journal bytes:   " << stats.bytes << endl;
+}
+
+static int usage() {
+    cerr << "usage: world_replay [--echo] [<journal options>] "
+            "[<observing options>] <log>" << endl
+         << "       world_replay --workload <1k|100k|1m|groups> "
+            "[--seed <seed>] [--echo] [<journal options>] "
+            "[<observing options>]" << endl
+         << "       world_replay --generate <1k|100k|1m|groups> "
+            "[--seed <seed>] [--binary] <log>" << endl
+         << "       world_replay --scaling <1k|100k|1m|groups> "
+            "[--seed <seed>] [--threads <N>] [--moves <moves>]" << endl
+         << "       world_replay --reads <1k|100k|1m|groups> "
+            "[--seed <seed>] [--threads <N>] [--moves <moves>]" << endl
+         << "       world_replay --checkpoint <1k|100k|1m|groups> "
+            "[--seed <seed>] <file>" << endl
+         << "       world_replay --scenarios <1k|100k|1m|groups> "
+            "[--seed <seed>] [--threads <N>] [--moves <moves>]" << endl
+         << "       world_replay --rejected <1k|100k|1m|groups> "
+            "[--seed <seed>] [--moves <commands>]" << endl
+         << "       world_replay --top <1k|100k|1m|groups> "
+            "[--seed <seed>] [--moves <queries>]" << endl
+         << "       world_replay --stats <1k|100k|1m|groups> "
+            "[--seed <seed>] [--moves <polls>]" << endl
+         << "       world_replay --memory <1k|100k|1m|groups> "
+            "[--seed <seed>] [--echo]" << endl
+         << "       world_replay --export <1k|100k|1m|groups> "
+            "[--seed <seed>] [--json] <file>" << endl
+         << "journal options: --journal <file> [--sync-every <N>] "
+            "[--sync-millis <ms>]" << endl
+         << "observing options of a replay: [--metrics <file>] "
+            "[--trace <file>]" << endl;
+    return 2;
+}
+
+static int replayLog(std::istream& input, bool echo,
+                     const JournalOptions& journal) {
+    Replayer replayer(echo);
+    if (!openJournal(replayer, journal)) {
+        return 1;
+    }
+    Clock::time_point start = Clock::now();
+    try {
+        CommandReader reader(input);
+        Command command;
+        while (true) {
+            try {
+                if (!reader.next(command)) {
+                    break ;
+                }
+            } catch (const CommandLogBadCommand&) {
+                if (reader.isBinary()) {
+                    throw ;
+                }
+                cerr << "bad command in line " << reader.getLine() << endl;
+                replayer.getStats().recordBadCommand();
+                continue ;
+            }
+            replayer.replay(command);
+        }
+    } catch (const CommandLogException& e) {
+        cerr << "cannot read the log: " << e.what() << endl;
+        return 1;
+    }
+    replayer.getWorld().syncJournal();
+    double seconds = std::chrono::duration<double>(Clock::now() -
+                                                   start).count();
+    replayer.getStats().report(cout, seconds);
+    reportJournal(replayer, journal, cout);
+    return 0;
+}
+
+static int replayWorkload(int groups, unsigned int seed, bool echo,
+                          const JournalOptions& journal) {
+    Replayer replayer(echo);
+    if (!openJournal(replayer, journal)) {
+        return 1;
+    }
+    WorkloadGenerator generator(groups, seed);
+    Clock::time_point start = Clock::now();
+    Command command;
+    while (generator.next(command)) {
+        replayer.replay(command);
+    }
+    replayer.getWorld().syncJournal();
+    double seconds = std::chrono::duration<double>(Clock::now() -
+                                                   start).count();
+    replayer.getStats().report(cout, seconds);
+    reportJournal(replayer, journal, cout);
+    return 0;
+}
+
+static int generateLog(int groups, unsigned int seed, bool binary,
+                       std::ostream& output) {
+    CommandWriter writer(output, binary);
+    WorkloadGenerator generator(groups, seed);
+    Command command;
+    while (generator.next(command)) {
+        writer.write(command);
+    }
+    output.flush();
+    return output ? 0 : 1;
+}
+
+/**
+ * Builds the world of a workload, without its prints, and applies a batch of
+ * moves to it.
+ * @param threads The threads of applyBatchConcurrently, 0 to use applyBatch.
+ * @param results Where to put the results of the moves.
+ * @return The seconds it took to apply the moves.
+ */
+static double applyScalingBatch(int groups, unsigned int seed, int moves,
+                                int threads,
+                                std::vector<WorldResult>& results) {
+    World world;
+    WorkloadGenerator generator(groups, seed);
+    Command command;
+    while (generator.next(command)) {
+        if (command.isOperation()) {
+            world.apply(command.toOperation());
+        }
+    }
+    std::vector<WorldOperation> batch;
+    batch.reserve(moves);
+    for (int i = 0; i < moves; i++) {
+        batch.push_back(generator.nextMove());
+    }
+    Clock::time_point start = Clock::now();
+    results = threads == 0 ? world.applyBatch(batch) :
+              world.applyBatchConcurrently(batch, threads);
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static int scaling(int groups, unsigned int seed, int threads, int moves) {
+    std::vector<WorldResult> sequential;
+    double base = applyScalingBatch(groups, seed, moves, 0, sequential);
+    cout << std::fixed << std::setprecision(3);
+    cout << "moves:         " << moves << endl;
+    cout << std::left << std::setw(13) << "threads" << std::right
+         << std::setw(12) << "seconds" << std::setw(14) << "moves/sec"
+         << std::setw(10) << "speedup" << std::setw(10) << "same" << endl;
+    cout << std::left << std::setw(13) << "sequential" << std::right
+         << std::setw(12) << base << std::setw(14) << std::setprecision(0)
+         << moves / base << std::setw(10) << std::setprecision(2) << 1.0
+         << std::setw(10) << "yes" << endl;
+    bool same = true;
+    for (int count = 1; count <= threads; count *= 2) {
+        if ((count * 2 > threads) && (count != threads)) {
+            count = threads;
+        }
+        std::vector<WorldResult> results;
+        double seconds = applyScalingBatch(groups, seed, moves, count,
+                                           results);
+        same = same && results == sequential;
+        cout << std::left << std::setw(13) << count << std::right
+             << std::setprecision(3) << std::setw(12) << seconds
+             << std::setw(14) << std::setprecision(0) << moves / seconds
+             << std::setw(10) << std::setprecision(2) << base / seconds
+             << std::setw(10) << (results == sequential ? "yes" : "no")
+             << endl;
+    }
+    return same ? 0 : 1;
+}
+
+/**
+ * The names of the clans, areas and groups of a workload, for the readers
+ * to ask about.
+ */
+struct WorkloadNames{
+    std::vector<string> clans;
+    std::vector<string> areas;
+    std::vector<string> groups;
+};
+
+/**
+ * Reads from a world until told to stop: 8 of every 10 reads print a group,
+ * the others print a clan or ask for the ruler changes of an area.
+ */
+static void readWorld(const ConcurrentWorld& world,
+                      const WorkloadNames& names, unsigned int seed,
+                      const std::atomic<bool>& stop,
+                      std::atomic<long long>& reads) {
+    std::mt19937 random(seed);
+    std::ostringstream os;
+    long long count = 0;
+    while (!stop) {
+        int kind = random() % 10;
+        int changes;
+        if (kind < 8) {
+            world.tryPrintGroup(os, names.groups[random() %
+                                                 names.groups.size()]);
+        } else if (kind == 8) {
+            world.tryPrintClan(os, names.clans[random() %
+                                               names.clans.size()]);
+        } else {
+            world.tryGetRulerChanges(names.areas[random() %
+                                                 names.areas.size()],
+                                     changes);
+        }
+        os.str("");
+        count++;
+    }
+    reads += count;
+}
+
+/**
+ * Runs reader threads on a world, while the calling thread applies moves or
+ * waits.
+ * @param moves The moves to apply one by one, or none to only wait.
+ * @param seconds How long to wait when there are no moves. Set to how long
+ *  the moves took when there are.
+ * @return The number of reads.
+ */
+static long long runReaders(ConcurrentWorld& world, const WorkloadNames& names,
+                            int threads,
+                            const std::vector<WorldOperation>& moves,
+                            double& seconds) {
+    std::atomic<bool> stop(false);
+    std::atomic<long long> reads(0);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < threads; i++) {
+        readers.push_back(std::thread(readWorld, std::cref(world),
+                                      std::cref(names), i + 1,
+                                      std::cref(stop), std::ref(reads)));
+    }
+    Clock::time_point start = Clock::now();
+    if (moves.empty()) {
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    } else {
+        for (unsigned int i = 0; i < moves.size(); i++) {
+            world.apply(moves[i]);
+        }
+    }
+    seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    stop = true;
+    for (unsigned int i = 0; i < readers.size(); i++) {
+        readers[i].join();
+    }
+    return reads;
+}
+
+static int readThroughput(int groups, unsigned int seed, int threads,
+                          int moves) {
+    ConcurrentWorld world;
+    WorkloadNames names;
+    WorkloadGenerator generator(groups, seed);
+    Command command;
+    while (generator.next(command)) {
+        if (!command.isOperation()) {
+            continue ;
+        }
+        world.apply(command.toOperation());
+        if (command.type == CLAN_ADD) {
+            names.clans.push_back(command.first);
+        } else if (command.type == AREA_ADD) {
+            names.areas.push_back(command.first);
+        } else if (command.type == GROUP_ADD) {
+            names.groups.push_back(command.first);
+        }
+    }
+    std::vector<WorldOperation> batch;
+    for (int i = 0; i < moves; i++) {
+        batch.push_back(generator.nextMove());
+    }
+    cout << std::fixed << std::setprecision(0);
+    cout << std::left << std::setw(10) << "readers" << std::right
+         << std::setw(16) << "reads/sec" << std::setw(22)
+         << "reads/sec (writing)" << std::setw(14) << "moves/sec" << endl;
+    for (int count = 1; count <= threads; count *= 2) {
+        if ((count * 2 > threads) && (count != threads)) {
+            count = threads;
+        }
+        double writing = 0;
+        long long reads_writing = runReaders(world, names, count, batch,
+                                             writing);
+        double alone = writing;
+        long long reads_alone = runReaders(world, names, count,
+                                           std::vector<WorldOperation>(),
+                                           alone);
+        cout << std::left << std::setw(10) << count << std::right
+             << std::setw(16) << reads_alone / alone << std::setw(22)
+             << reads_writing / writing << std::setw(14) << moves / writing
+             << endl;
+    }
+    return 0;
+}
+
+static int checkpoint(int groups, unsigned int seed, const string& path) {
+    World world;
+    WorkloadGenerator generator(groups, seed);
+    Command command;
+    Clock::time_point start = Clock::now();
+    while (generator.next(command)) {
+        if (command.isOperation()) {
+            world.apply(command.toOperation());
+        }
+    }
+    double built = std::chrono::duration<double>(Clock::now() - start).count();
+    start = Clock::now();
+    world.saveCheckpoint(path);
+    double saved = std::chrono::duration<double>(Clock::now() - start).count();
+    start = Clock::now();
+    std::unique_ptr<World> loaded = World::loadCheckpoint(path);
+    double load = std::chrono::duration<double>(Clock::now() - start).count();
+    SnapshotStats expected = world.snapshot()->getStats();
+    SnapshotStats stats = loaded->snapshot()->getStats();
+    std::ifstream file(path.c_str(), std::ios::binary | std::ios::ate);
+    cout << std::fixed << std::setprecision(3);
+    cout << "build (s): " << built << endl
+         << "save (s): " << saved << endl
+         << "load (s): " << load << endl
+         << "file (bytes): " << file.tellg() << endl;
+    if (stats.groups != expected.groups ||
+            stats.population != expected.population ||
+            stats.ruler_changes != expected.ruler_changes) {
+        cerr << "the loaded world is different" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+static int scenarios(int groups, unsigned int seed, int threads, int moves) {
+    World world;
+    WorkloadGenerator generator(groups, seed);
+    Command command;
+    while (generator.next(command)) {
+        if (command.isOperation()) {
+            world.apply(command.toOperation());
+        }
+    }
+    world.snapshot();
+    Clock::time_point start = Clock::now();
+    std::unique_ptr<World> fork = world.fork();
+    double forked = std::chrono::duration<double>(Clock::now() -
+                                                  start).count();
+    fork.reset();
+    std::vector<std::vector<WorldOperation> > batches(threads);
+    for (int i = 0; i < threads; i++) {
+        for (int j = 0; j < moves; j++) {
+            batches[i].push_back(generator.nextMove());
+        }
+    }
+    start = Clock::now();
+    std::vector<ScenarioResult> results = world.runScenarios(batches,
+                                                             threads);
+    double seconds = std::chrono::duration<double>(Clock::now() -
+                                                   start).count();
+    cout << std::fixed << std::setprecision(3);
+    cout << "fork (s): " << forked << endl
+         << "scenarios (s): " << seconds << endl << endl;
+    cout << std::left << std::setw(10) << "scenario" << std::right
+         << std::setw(12) << "succeeded" << std::setw(10) << "failed"
+         << std::setw(10) << "groups" << std::setw(14) << "population"
+         << std::setw(10) << "seconds" << endl;
+    for (unsigned int i = 0; i < results.size(); i++) {
+        cout << std::left << std::setw(10) << i << std::right
+             << std::setw(12) << results[i].succeeded << std::setw(10)
+             << results[i].failed << std::setw(10)
+             << results[i].stats.groups << std::setw(14)
+             << results[i].stats.population << std::setw(10)
+             << results[i].seconds << endl;
+    }
+    return 0;
+}
+
+/**
+ * Makes the i'th rejected command of the rejected benchmark, through the
+ * throwing API (throwing) or the try API. Every command is rejected by the
+ * world: a missing group, area or clan, a name that is already taken, or a
+ * group that is already in the area. The benchmark adds the clan, the area
+ * and the group named "rejected" for the commands to find.
+ * @return true if the command was rejected.
+ */
+static bool rejectCommand(World& world, int i, bool throwing,
+                          std::ostream& os) {
+    static const string name = "rejected";
+    static const string missing = "missing";
+    if (!throwing) {
+        WorldResult result;
+        switch (i % 7) {
+            case 0 : result = world.tryMoveGroup(missing, name); break ;
+            case 1 : result = world.tryMoveGroup(name, name); break ;
+            case 2 : result = world.tryAddGroup(name, name, 1, 1, name);
+                break ;
+            case 3 : result = world.tryAddClan(name); break ;
+            case 4 : result = world.tryMakeReachable(missing, name); break ;
+            case 5 : result = world.tryPrintGroup(os, missing); break ;
+            default : result = world.tryPrintClan(os, missing); break ;
+        }
+        return result != WORLD_SUCCESS;
+    }
+    try {
+        switch (i % 7) {
+            case 0 : world.moveGroup(missing, name); break ;
+            case 1 : world.moveGroup(name, name); break ;
+            case 2 : world.addGroup(name, name, 1, 1, name); break ;
+            case 3 : world.addClan(name); break ;
+            case 4 : world.makeReachable(missing, name); break ;
+            case 5 : world.printGroup(os, missing); break ;
+            default : world.printClan(os, missing); break ;
+        }
+    } catch (const WorldException&) {
+        return true;
+    }
+    return false;
+}
+
+static int rejected(int groups, unsigned int seed, int commands) {
+    World world;
+    WorkloadGenerator generator(groups, seed);
+    Command command;
+    while (generator.next(command)) {
+        if (command.isOperation()) {
+            world.apply(command.toOperation());
+        }
+    }
+    world.addClan("rejected");
+    world.addArea("rejected", PLAIN);
+    world.addGroup("rejected", "rejected", 1, 1, "rejected");
+    SnapshotStats before = world.snapshot()->getStats();
+    std::ostringstream os;
+    double seconds[2];
+    for (int throwing = 1; throwing >= 0; throwing--) {
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < commands; i++) {
+            if (!rejectCommand(world, i, throwing == 1, os)) {
+                cerr << "command " << i << " was not rejected" << endl;
+                return 1;
+            }
+        }
+        seconds[throwing] = std::chrono::duration<double>(Clock::now() -
+                                                          start).count();
+    }
+    SnapshotStats after = world.snapshot()->getStats();
+    cout << std::fixed << std::setprecision(3);
+    cout << "rejected commands: " << commands << endl
+         << "throwing (s): " << seconds[1] << " ("
+         << commands / seconds[1] << " commands/s)" << endl
+         << "try (s): " << seconds[0] << " ("
+         << commands / seconds[0] << " commands/s)" << endl
+         << "speedup: " << seconds[1] / seconds[0] << endl;
+    if (after.groups != before.groups ||
+            after.population != before.population ||
+            after.ruler_changes != before.ruler_changes || !os.str().empty()) {
+        cerr << "a rejected command changed the world" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+static int topQueries(int groups, unsigned int seed, int queries) {
+    World world;
+    WorkloadGenerator generator(groups, seed);
+    Command command;
+    while (generator.next(command)) {
+        if (command.isOperation()) {
+            world.apply(command.toOperation());
+        }
+    }
+    int clans = std::max(groups / 250, 4);
+    std::vector<WorldOperation> moves;
+    for (int i = 0; i < queries; i++) {
+        moves.push_back(generator.nextMove());
+    }
+    //a move before every query, so the rankings are queried as they change.
+    double seconds[3] = { 0, 0, 0 };
+    long long found = 0;
+    std::ostringstream os;
+    for (int i = 0; i < queries; i++) {
+        world.apply(moves[i]);
+        const string clan = WorkloadGenerator::clanName(i % clans);
+        std::vector<const Group*> top;
+        Clock::time_point start = Clock::now();
+        world.tryTopGroups(10, top);
+        Clock::time_point end = Clock::now();
+        seconds[0] += std::chrono::duration<double>(end - start).count();
+        found += top.size();
+        start = Clock::now();
+        world.tryTopGroupsOfClan(clan, 10, top);
+        end = Clock::now();
+        seconds[1] += std::chrono::duration<double>(end - start).count();
+        start = Clock::now();
+        world.tryPrintClan(os, clan);
+        end = Clock::now();
+        seconds[2] += std::chrono::duration<double>(end - start).count();
+        os.str("");
+    }
+    cout << std::fixed << std::setprecision(3);
+    cout << "queries: " << queries << " (" << found / queries
+         << " groups each)" << endl
+         << "topGroups(10) (us): " << seconds[0] * 1e6 / queries << endl
+         << "topGroupsOfClan(10) (us): " << seconds[1] * 1e6 / queries
+         << endl
+         << "printClan (us): " << seconds[2] * 1e6 / queries << endl;
+    return 0;
+}
+
+static int statsPolls(int groups, unsigned int seed, int polls) {
+    World world;
+    WorkloadGenerator generator(groups, seed);
+    Command command;
+    while (generator.next(command)) {
+        if (command.isOperation()) {
+            world.apply(command.toOperation());
+        }
+    }
+    int areas = std::max(groups / 100, 6);
+    std::vector<WorldOperation> moves;
+    for (int i = 0; i < polls; i++) {
+        moves.push_back(generator.nextMove());
+    }
+    //a move before every poll, so the stats are polled as they change.
+    double seconds = 0;
+    long long clans = 0;
+    long long fights = 0;
+    long long trades = 0;
+    for (int i = 0; i < polls; i++) {
+        world.apply(moves[i]);
+        clans = 0;
+        fights = 0;
+        trades = 0;
+        Clock::time_point start = Clock::now();
+        for (int area = 0; area < areas; area++) {
+            const AreaStats* stats = nullptr;
+            world.tryAreaStats(WorkloadGenerator::areaName(area), stats);
+            clans += (*stats).population.size();
+            fights += (*stats).fights;
+            trades += (*stats).trades;
+        }
+        Clock::time_point end = Clock::now();
+        seconds += std::chrono::duration<double>(end - start).count();
+    }
+    cout << std::fixed << std::setprecision(3);
+    cout << "polls: " << polls << " of " << areas << " areas (" << clans
+         << " clans in them, " << fights << " fights, " << trades << " trades)"
+         << endl
+         << "poll (us): " << seconds * 1e6 / polls << endl
+         << "area (us): " << seconds * 1e6 / polls / areas << endl;
+    return 0;
+}
+
+/**
+ * Prints the biggest of the clans or the areas of a memory report.
+ */
+static void printBiggest(const string& title,
+                         const std::map<string, MemoryUsage>& usages) {
+    std::map<string, MemoryUsage>::const_iterator biggest = usages.begin();
+    for (std::map<string, MemoryUsage>::const_iterator it = usages.begin();
+         it != usages.end(); ++it) {
+        if (it->second.total() > biggest->second.total()) {
+            biggest = it;
+        }
+    }
+    if (biggest != usages.end()) {
+        cout << "biggest " << title << ": " << biggest->first << ", "
+             << biggest->second.total() << " bytes" << endl;
+    }
+}
+
+static int memory(int groups, unsigned int seed, bool echo) {
+    World world;
+    WorkloadGenerator generator(groups, seed);
+    Command command;
+    while (generator.next(command)) {
+        if (command.isOperation()) {
+            world.apply(command.toOperation());
+        }
+    }
+    Clock::time_point start = Clock::now();
+    MemoryReport report = world.memoryReport();
+    Clock::time_point end = Clock::now();
+    const MemoryUsage& total = report.total;
+    cout << std::fixed << std::setprecision(3);
+    cout << "clans: " << report.clans.size() << ", areas: "
+         << report.areas.size() << endl
+         << "report (ms): "
+         << std::chrono::duration<double>(end - start).count() * 1e3 << endl
+         << "total:          " << total.total() << endl
+         << "groups:         " << total.groups << endl
+         << "control blocks: " << total.control_blocks << endl
+         << "set nodes:      " << total.set_nodes << endl
+         << "strings:        " << total.strings << endl
+         << "map nodes:      " << total.map_nodes << endl
+         << "vectors:        " << total.vectors << endl
+         << "world indexes:  " << report.world.total() << endl;
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    cout << "peak RSS (KB):  " << usage.ru_maxrss << endl;
+    printBiggest("clan", report.clans);
+    printBiggest("area", report.areas);
+    if (echo) {
+        cout << endl << report;
+    }
+    return 0;
+}
+
+static int exportState(int groups, unsigned int seed, bool json,
+                       const string& path) {
+    World world;
+    WorkloadGenerator generator(groups, seed);
+    Command command;
+    while (generator.next(command)) {
+        if (command.isOperation()) {
+            world.apply(command.toOperation());
+        }
+    }
+    std::ofstream output(path.c_str(), std::ios::binary);
+    if (!output) {
+        cerr << "cannot open " << path << endl;
+        return 1;
+    }
+    Clock::time_point start = Clock::now();
+    world.exportState(output, json ? EXPORT_JSON : EXPORT_CSV);
+    output.flush();
+    Clock::time_point end = Clock::now();
+    if (!output) {
+        cerr << "cannot write " << path << endl;
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double megabytes = static_cast<double>(output.tellp()) / 1e6;
+    cout << std::fixed << std::setprecision(3);
+    cout << "format:  " << (json ? "json" : "csv") << endl
+         << "MB:      " << megabytes << endl
+         << "seconds: " << seconds << endl
+         << "MB/s:    " << std::setprecision(1)
+         << (seconds > 0 ? megabytes / seconds : 0) << endl;
+    return 0;
+}
+
+/**
+ * Writes the metrics and the trace of a replay to their files, if they were
+ * asked for.
+ * @return The result of the replay, or 1 if a file can't be written.
+ */
+static int observed(int result, const string& metrics, const string& trace) {
+    if (!trace.empty()) {
+        std::ofstream output(trace.c_str());
+        World::stopTrace(output);
+        if (!output) {
+            cerr << "cannot write " << trace << endl;
+            return 1;
+        }
+    }
+    if (!metrics.empty()) {
+        std::ofstream output(metrics.c_str());
+        World::dumpMetrics(output);
+        if (!output) {
+            cerr << "cannot write " << metrics << endl;
+            return 1;
+        }
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    bool echo = false;
+    bool binary = false;
+    bool json = false;
+    unsigned int seed = 2017;
+    string workload;
+    string generate;
+    string scaling_scenario;
+    string reads_scenario;
+    string checkpoint_scenario;
+    string forks_scenario;
+    string rejected_scenario;
+    string top_scenario;
+    string stats_scenario;
+    string memory_scenario;
+    string export_scenario;
+    string metrics;
+    string trace;
+    JournalOptions journal = { "", 256, 10 };
+    int threads = std::max<int>(std::thread::hardware_concurrency(), 1);
+    int moves = 100000;
+    string log;
+    for (int i = 1; i < argc; i++) {
+        string argument = argv[i];
+        bool has_value = i + 1 < argc;
+        if (argument == "--echo") {
+            echo = true;
+        } else if (argument == "--binary") {
+            binary = true;
+        } else if (argument == "--json") {
+            json = true;
+        } else if (argument == "--seed" && has_value) {
+            seed = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr,
+                                                          10));
+        } else if (argument == "--workload" && has_value) {
+            workload = argv[++i];
+        } else if (argument == "--generate" && has_value) {
+            generate = argv[++i];
+        } else if (argument == "--scaling" && has_value) {
+            scaling_scenario = argv[++i];
+        } else if (argument == "--reads" && has_value) {
+            reads_scenario = argv[++i];
+        } else if (argument == "--scenarios" && has_value) {
+            forks_scenario = argv[++i];
+        } else if (argument == "--top" && has_value) {
+            top_scenario = argv[++i];
+        } else if (argument == "--stats" && has_value) {
+            stats_scenario = argv[++i];
+        } else if (argument == "--memory" && has_value) {
+            memory_scenario = argv[++i];
+        } else if (argument == "--export" && has_value) {
+            export_scenario = argv[++i];
+        } else if (argument == "--rejected" && has_value) {
+            rejected_scenario = argv[++i];
+        } else if (argument == "--checkpoint" && has_value) {
+            checkpoint_scenario = argv[++i];
+        } else if (argument == "--metrics" && has_value) {
+            metrics = argv[++i];
+        } else if (argument == "--trace" && has_value) {
+            trace = argv[++i];
+        } else if (argument == "--journal" && has_value) {
+            journal.path = argv[++i];
+        } else if (argument == "--sync-every" && has_value) {
+            journal.sync_every = std::atoi(argv[++i]);
+        } else if (argument == "--sync-millis" && has_value) {
+            journal.sync_millis = std::atoi(argv[++i]);
+        } else if (argument == "--threads" && has_value) {
+            threads = std::atoi(argv[++i]);
+        } else if (argument == "--moves" && has_value) {
+            moves = std::atoi(argv[++i]);
+        } else if (log.empty() && (argument == "-" || argument[0] != '-')) {
+            log = argument;
+        } else {
+            return usage();
+        }
+    }
+    if ((journal.sync_every < 1) || (journal.sync_millis < 0)) {
+        return usage();
+    }
+    if ((!metrics.empty() || !trace.empty()) &&
+            (!generate.empty() || !export_scenario.empty() ||
+             !memory_scenario.empty() ||
+             !stats_scenario.empty() ||
+             !top_scenario.empty() || !rejected_scenario.empty() ||
+             !forks_scenario.empty() || !checkpoint_scenario.empty() ||
+             !reads_scenario.empty() || !scaling_scenario.empty())) {
+        return usage();
+    }
+    if (!trace.empty()) {
+        World::startTrace();
+    }
+    if (!export_scenario.empty()) {
+        int groups = WorkloadGenerator::scenarioGroups(export_scenario);
+        if (groups == 0 || log.empty() || log == "-" ||
+                !journal.path.empty() || !memory_scenario.empty() ||
+                !stats_scenario.empty() || !top_scenario.empty() ||
+                !rejected_scenario.empty() || !forks_scenario.empty() ||
+                !checkpoint_scenario.empty() || !reads_scenario.empty() ||
+                !scaling_scenario.empty() || !workload.empty() ||
+                !generate.empty()) {
+            return usage();
+        }
+        return exportState(groups, seed, json, log);
+    }
+    if (!memory_scenario.empty()) {
+        int groups = WorkloadGenerator::scenarioGroups(memory_scenario);
+        if (groups == 0 || !log.empty() || !journal.path.empty() ||
+                !stats_scenario.empty() || !top_scenario.empty() ||
+                !rejected_scenario.empty() || !forks_scenario.empty() ||
+                !checkpoint_scenario.empty() || !reads_scenario.empty() ||
+                !scaling_scenario.empty() || !workload.empty() ||
+                !generate.empty()) {
+            return usage();
+        }
+        return memory(groups, seed, echo);
+    }
+    if (!stats_scenario.empty()) {
+        int groups = WorkloadGenerator::scenarioGroups(stats_scenario);
+        if (groups == 0 || moves < 1 || !log.empty() ||
+                !journal.path.empty() || !top_scenario.empty() ||
+                !rejected_scenario.empty() || !forks_scenario.empty() ||
+                !checkpoint_scenario.empty() || !reads_scenario.empty() ||
+                !scaling_scenario.empty() || !workload.empty() ||
+                !generate.empty()) {
+            return usage();
+        }
+        return statsPolls(groups, seed, moves);
+    }
+    if (!top_scenario.empty()) {
+        int groups = WorkloadGenerator::scenarioGroups(top_scenario);
+        if (groups == 0 || moves < 1 || !log.empty() ||
+                !journal.path.empty() || !rejected_scenario.empty() ||
+                !forks_scenario.empty() || !checkpoint_scenario.empty() ||
+                !reads_scenario.empty() || !scaling_scenario.empty() ||
+                !workload.empty() || !generate.empty()) {
+            return usage();
+        }
+        return topQueries(groups, seed, moves);
+    }
+    if (!rejected_scenario.empty()) {
+        int groups = WorkloadGenerator::scenarioGroups(rejected_scenario);
+        if (groups == 0 || moves < 1 || !log.empty() ||
+                !journal.path.empty() || !forks_scenario.empty() ||
+                !checkpoint_scenario.empty() || !reads_scenario.empty() ||
+                !scaling_scenario.empty() || !workload.empty() ||
+                !generate.empty()) {
+            return usage();
+        }
+        return rejected(groups, seed, moves);
+    }
+    if (!forks_scenario.empty()) {
+        int groups = WorkloadGenerator::scenarioGroups(forks_scenario);
+        if (groups == 0 || threads < 1 || moves < 1 || !log.empty() ||
+                !journal.path.empty() || !checkpoint_scenario.empty() ||
+                !reads_scenario.empty() || !scaling_scenario.empty() ||
+                !workload.empty() || !generate.empty()) {
+            return usage();
+        }
+        return scenarios(groups, seed, threads, moves);
+    }
+    if (!checkpoint_scenario.empty()) {
+        int groups = WorkloadGenerator::scenarioGroups(checkpoint_scenario);
+        if (groups == 0 || log.empty() || log == "-" ||
+                !journal.path.empty() || !reads_scenario.empty() ||
+                !scaling_scenario.empty() || !workload.empty() ||
+                !generate.empty()) {
+            return usage();
+        }
+        return checkpoint(groups, seed, log);
+    }
+    if (!reads_scenario.empty()) {
+        int groups = WorkloadGenerator::scenarioGroups(reads_scenario);
+        if (groups == 0 || threads < 1 || moves < 1 ||
+                !journal.path.empty() || !scaling_scenario.empty() ||
+                !workload.empty() || !generate.empty() || !log.empty()) {
+            return usage();
+        }
+        return readThroughput(groups, seed, threads, moves);
+    }
+    if (!scaling_scenario.empty()) {
+        int groups = WorkloadGenerator::scenarioGroups(scaling_scenario);
+        if (groups == 0 || threads < 1 || moves < 1 || !workload.empty() ||
+                !generate.empty() || !log.empty() || !journal.path.empty()) {
+            return usage();
+        }
+        return scaling(groups, seed, threads, moves);
+    }
+    if (!workload.empty()) {
+        int groups = WorkloadGenerator::scenarioGroups(workload);
+        if (groups == 0 || !generate.empty() || !log.empty()) {
+            return usage();
+        }
+        return observed(replayWorkload(groups, seed, echo, journal), metrics,
+                        trace);
+    }
+    if (log.empty()) {
+        return usage();
+    }
+    if (!generate.empty()) {
+        int groups = WorkloadGenerator::scenarioGroups(generate);
+        if (groups == 0 || !journal.path.empty()) {
+            return usage();
+        }
+        if (log == "-") {
+            return generateLog(groups, seed, binary, cout);
+        }
+        std::ofstream output(log.c_str(), std::ios::binary);
+        if (!output) {
+            cerr << "cannot open " << log << endl;
+            return 1;
+        }
+        return generateLog(groups, seed, binary, output);
+    }
+    if (log == "-") {
+        return observed(replayLog(std::cin, echo, journal), metrics, trace);
+    }
+    std::ifstream input(log.c_str(), std::ios::binary);
+    if (!input) {
+        cerr << "cannot open " << log << endl;
+        return 1;
+    }
+    return observed(replayLog(input, echo, journal), metrics, trace);
+}